@@ -0,0 +1,169 @@
+#include "class-heap.h"
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Makes room for more class indices. Classes already in the heap keep their keys.
+     */
+    void ClassHeap::Resize(uint32_t size)
+    {
+        m_position.resize(size, ABSENT);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Inserts a class or changes its key.
+     */
+    void ClassHeap::Push(uint32_t index, double key)
+    {
+        uint32_t position = m_position[index];
+        if (position == ABSENT)
+        {
+            position = m_heap.size();
+            m_heap.emplace_back(key, index);
+            m_position[index] = position;
+            SiftUp(position);
+            return;
+        }
+
+        m_heap[position].first = key;
+        SiftUp(position);
+        SiftDown(m_position[index]);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Takes a class out of the heap by moving the last entry into its place.
+     */
+    void ClassHeap::Erase(uint32_t index)
+    {
+        uint32_t position = m_position[index];
+        if (position == ABSENT)
+        {
+            return;
+        }
+
+        uint32_t last = m_heap.size() - 1;
+        if (position != last)
+        {
+            Swap(position, last);
+        }
+
+        m_heap.pop_back();
+        m_position[index] = ABSENT;
+
+        // The entry moved into the hole may belong above or below it
+        if (position < m_heap.size())
+        {
+            uint32_t moved = m_heap[position].second;
+            SiftUp(position);
+            SiftDown(m_position[moved]);
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Returns true if the class is in the heap.
+     */
+    bool ClassHeap::Contains(uint32_t index) const
+    {
+        return index < m_position.size() && m_position[index] != ABSENT;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Returns true if no class is in the heap.
+     */
+    bool ClassHeap::IsEmpty() const
+    {
+        return m_heap.empty();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of classes in the heap.
+     */
+    uint32_t ClassHeap::GetSize() const
+    {
+        return m_heap.size();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Returns the class with the smallest key.
+     */
+    uint32_t ClassHeap::Top() const
+    {
+        return m_heap.front().second;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Returns the smallest key.
+     */
+    double ClassHeap::TopKey() const
+    {
+        return m_heap.front().first;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Moves an entry up while it is smaller than its parent.
+     */
+    void ClassHeap::SiftUp(uint32_t position)
+    {
+        while (position > 0)
+        {
+            uint32_t parent = (position - 1) / 2;
+            if (!(m_heap[position] < m_heap[parent]))
+            {
+                return;
+            }
+
+            Swap(position, parent);
+            position = parent;
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Moves an entry down while one of its children is smaller.
+     */
+    void ClassHeap::SiftDown(uint32_t position)
+    {
+        uint32_t size = m_heap.size();
+        while (true)
+        {
+            uint32_t smallest = position;
+            uint32_t left = 2 * position + 1;
+            uint32_t right = left + 1;
+
+            if (left < size && m_heap[left] < m_heap[smallest])
+            {
+                smallest = left;
+            }
+            if (right < size && m_heap[right] < m_heap[smallest])
+            {
+                smallest = right;
+            }
+            if (smallest == position)
+            {
+                return;
+            }
+
+            Swap(position, smallest);
+            position = smallest;
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Swaps two entries and keeps the position table in step.
+     */
+    void ClassHeap::Swap(uint32_t a, uint32_t b)
+    {
+        std::swap(m_heap[a], m_heap[b]);
+        m_position[m_heap[a].second] = a;
+        m_position[m_heap[b].second] = b;
+    }
+} // namespace ns3
@@ -0,0 +1,68 @@
+#ifndef CLASS_HEAP_H
+#define CLASS_HEAP_H
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Indexed binary min-heap of traffic classes keyed by a tag (a virtual time or a deadline).
+     *
+     * Each class index appears at most once. The heap remembers where every class sits, so the
+     * key of a class can be changed and a class can be taken out from anywhere in O(log n), which
+     * a std::priority_queue cannot do. Equal keys are ordered by class index, so the order is
+     * deterministic.
+     */
+    class ClassHeap
+    {
+        public:
+            /**
+             * \brief Make room for class indices 0 .. size - 1.
+             */
+            void Resize(uint32_t size);
+
+            /**
+             * \brief Insert a class, or move it to a new key if it is already in the heap.
+             */
+            void Push(uint32_t index, double key);
+
+            /**
+             * \brief Take a class out of the heap (no-op if it is not in it).
+             */
+            void Erase(uint32_t index);
+
+            bool Contains(uint32_t index) const;
+            bool IsEmpty() const;
+            uint32_t GetSize() const;
+
+            /**
+             * \brief Class with the smallest key (the heap must not be empty).
+             */
+            uint32_t Top() const;
+            double TopKey() const;
+
+        private:
+            static constexpr uint32_t ABSENT = UINT32_MAX;
+
+            // (key, class index) pairs in heap order
+            std::vector<std::pair<double, uint32_t>> m_heap;
+
+            // Position of every class in m_heap, ABSENT when it is not in the heap
+            std::vector<uint32_t> m_position;
+
+            /**
+             * \brief Move an entry towards the root or the leaves until the heap order holds.
+             */
+            void SiftUp(uint32_t position);
+            void SiftDown(uint32_t position);
+
+            /**
+             * \brief Swap two entries and update their positions.
+             */
+            void Swap(uint32_t a, uint32_t b);
+    };
+} // namespace ns3
+
+#endif // CLASS_HEAP_H
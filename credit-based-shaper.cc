@@ -0,0 +1,153 @@
+#include "credit-based-shaper.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Credit-Based Shaper Reference:
+ *
+ * IEEE Std 802.1Qav-2009. IEEE Standard for Local and Metropolitan Area Networks – Virtual Bridged
+ * Local Area Networks Amendment 12: Forwarding and Queuing Enhancements for Time-Sensitive Streams.
+ */
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Constructor for CreditBasedShaper.
+     * \param idleSlope Rate the class is reserved on the port.
+     * \param portRate Rate of the link the class is sent on.
+     */
+    CreditBasedShaper::CreditBasedShaper(DataRate idleSlope, DataRate portRate)
+        : TrafficShaper(idleSlope, 0),
+          m_portRate(portRate),
+          m_idleBitsPerSecond(idleSlope.GetBitRate()),
+          m_portBitsPerSecond(portRate.GetBitRate()),
+          m_credit(0),
+          m_backlogged(false)
+    {
+        SetSendSlope(DataRate(portRate.GetBitRate() > idleSlope.GetBitRate() ? portRate.GetBitRate() - idleSlope.GetBitRate() : 0));
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Brings the credit up to date.
+     * \details While packets wait the credit grows at the idle slope. An empty class climbs back
+     * to zero from a debt at the idle slope, and positive credit is dropped.
+     */
+    void CreditBasedShaper::Update(Time now)
+    {
+        if (now <= m_lastUpdate)
+        {
+            return;
+        }
+
+        m_credit += (now - m_lastUpdate).GetSeconds() * m_idleBitsPerSecond;
+        if (!m_backlogged)
+        {
+            m_credit = std::min(m_credit, 0.0);
+        }
+        m_lastUpdate = now;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Computes when the credit will be back at zero.
+     * \details The packet size does not matter: a class with non-negative credit may send any
+     * packet. The time is rounded up to the next nanosecond so the release never comes early.
+     */
+    Time CreditBasedShaper::GetEligibleTime(uint32_t, Time now)
+    {
+        Update(now);
+
+        if (m_credit >= 0)
+        {
+            return now;
+        }
+
+        // A zero idle slope never earns credit
+        if (m_idleBitsPerSecond <= 0)
+        {
+            return Time::Max();
+        }
+
+        double seconds = -m_credit / m_idleBitsPerSecond;
+        return now + NanoSeconds(static_cast<int64_t>(std::ceil(seconds * 1e9)));
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Charges a packet about to be sent.
+     * \details The credit goes on growing at the idle slope, so the charge is
+     * (idleSlope + sendSlope) x the transmission time of the packet on the port.
+     */
+    void CreditBasedShaper::Consume(uint32_t size, Time now)
+    {
+        Update(now);
+
+        if (m_portBitsPerSecond > 0)
+        {
+            m_credit -= (m_idleBitsPerSecond + m_sendBitsPerSecond) * size * 8 / m_portBitsPerSecond;
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Tracks whether packets are waiting, which decides how the credit moves from now on.
+     */
+    void CreditBasedShaper::NotifyBacklog(bool backlogged, Time now)
+    {
+        Update(now);
+
+        if (!backlogged)
+        {
+            m_credit = std::min(m_credit, 0.0);
+        }
+        m_backlogged = backlogged;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the send slope.
+     */
+    void CreditBasedShaper::SetSendSlope(DataRate sendSlope)
+    {
+        m_sendSlope = sendSlope;
+        m_sendBitsPerSecond = sendSlope.GetBitRate();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the send slope.
+     */
+    DataRate CreditBasedShaper::GetSendSlope() const
+    {
+        return m_sendSlope;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the idle slope.
+     */
+    DataRate CreditBasedShaper::GetIdleSlope() const
+    {
+        return GetRate();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the port rate.
+     */
+    DataRate CreditBasedShaper::GetPortRate() const
+    {
+        return m_portRate;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the credit.
+     */
+    double CreditBasedShaper::GetCredit(Time now)
+    {
+        Update(now);
+        return m_credit;
+    }
+} // namespace ns3
@@ -0,0 +1,74 @@
+#ifndef CREDIT_BASED_SHAPER_H
+#define CREDIT_BASED_SHAPER_H
+
+#include "traffic-shaper.h"
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief IEEE 802.1Qav credit-based shaper for a TrafficClass.
+     *
+     * The class may start a packet while its credit is zero or more. Credit grows at the idle
+     * slope while packets wait, drops at the send slope while one is sent, and an empty class
+     * keeps no positive credit but climbs back to zero from a debt. Unlike the token bucket a
+     * class never saves up a burst while it has nothing to send, which bounds the burstiness of
+     * a stream to what interference from other classes built up.
+     *
+     * The credit is a piecewise linear function of time, so it is only brought up to date when
+     * the class changes or is served. Sending is charged when the packet is dequeued: the credit
+     * keeps growing at the idle slope through the transmission and the charge takes out
+     * (idleSlope + sendSlope) x transmission time, which gives the send slope at its end.
+     * DiffServ holds the class while it is in debt and releases it with one event at the time
+     * the credit is back at zero.
+     */
+    class CreditBasedShaper : public TrafficShaper
+    {
+        public:
+            /**
+             * \brief Constructor. The credit starts at zero.
+             * \param idleSlope Rate the class is reserved on the port.
+             * \param portRate Rate of the link the class is sent on. The send slope defaults to
+             * portRate - idleSlope, as in 802.1Qav.
+             */
+            CreditBasedShaper(DataRate idleSlope, DataRate portRate);
+
+            Time GetEligibleTime(uint32_t size, Time now) override;
+            void Consume(uint32_t size, Time now) override;
+            void NotifyBacklog(bool backlogged, Time now) override;
+
+            /**
+             * \brief Rate the credit drops at while the class sends (a magnitude, the slope itself is negative).
+             */
+            void SetSendSlope(DataRate sendSlope);
+            DataRate GetSendSlope() const;
+
+            DataRate GetIdleSlope() const;
+            DataRate GetPortRate() const;
+
+            /**
+             * \brief Credit in bits at the given time.
+             */
+            double GetCredit(Time now);
+
+        private:
+            DataRate m_portRate;
+            DataRate m_sendSlope;
+
+            // Slopes and port rate in bits per second
+            double m_idleBitsPerSecond;
+            double m_sendBitsPerSecond;
+            double m_portBitsPerSecond;
+
+            // Credit in bits at the last update, and whether packets were waiting since then
+            double m_credit;
+            Time m_lastUpdate;
+            bool m_backlogged;
+
+            /**
+             * \brief Bring the credit up to date.
+             */
+            void Update(Time now);
+    };
+} // namespace ns3
+
+#endif // CREDIT_BASED_SHAPER_H
@@ -0,0 +1,349 @@
+#include "decision-tree.h"
+#include <algorithm>
+
+namespace ns3 {
+    // Width in bits of each header field, indexed by FlowField - 1
+    static const uint32_t FIELD_BITS[] = {32, 32, 16, 16, 8, 6};
+
+    /**
+     * \ingroup diffserv
+     * \brief Compiles the rules into a tree.
+     */
+    void DecisionTree::Build(const std::vector<std::pair<uint32_t, const Filter*>>& filters)
+    {
+        m_rules.clear();
+        m_nodes.clear();
+        m_leafRules.clear();
+
+        // Project every rule onto per-field ranges; rules that can never match are dropped
+        for (const auto& entry : filters)
+        {
+            Rule rule;
+            rule.classIndex = entry.first;
+            rule.filter = entry.second;
+            if (Project(entry.second, rule))
+            {
+                m_rules.push_back(rule);
+            }
+        }
+
+        m_referenceLimit = std::max<uint32_t>(m_rules.size() * REFERENCES_PER_RULE, LEAF_SIZE);
+        m_pending = m_rules.size();
+
+        // The root covers every value of every field
+        Region region;
+        for (uint32_t f = 0; f < FIELDS; ++f)
+        {
+            region.low[f] = 0;
+            region.bits[f] = FIELD_BITS[f];
+        }
+
+        std::vector<uint32_t> all(m_rules.size());
+        for (uint32_t i = 0; i < all.size(); ++i)
+        {
+            all[i] = i;
+        }
+
+        m_nodes.emplace_back();
+        BuildNode(0, all, region);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Projects a filter onto one range per header field.
+     * \details Exact elements give a single value and prefix elements the block they cover.
+     * Elements that describe neither leave their field unconstrained; the leaf check with
+     * Filter::Match still applies them.
+     */
+    bool DecisionTree::Project(const Filter* filter, Rule& rule)
+    {
+        for (uint32_t f = 0; f < FIELDS; ++f)
+        {
+            rule.low[f] = 0;
+            rule.high[f] = (1ULL << FIELD_BITS[f]) - 1;
+        }
+
+        // A class without filters matches everything
+        if (filter == nullptr)
+        {
+            return true;
+        }
+
+        for (const FilterElement* element : filter->GetFilterElements())
+        {
+            FlowField field;
+            uint32_t value;
+            uint8_t length;
+            uint64_t low;
+            uint64_t high;
+            if (element->GetExactMatch(field, value))
+            {
+                low = value;
+                high = value;
+            }
+            else if (element->GetPrefixMatch(field, value, length))
+            {
+                uint64_t span = length >= 32 ? 0 : (1ULL << (32 - length)) - 1;
+                low = value;
+                high = value + span;
+            }
+            else
+            {
+                continue;
+            }
+
+            // Elements on the same field intersect
+            uint32_t f = static_cast<uint32_t>(field) - 1;
+            rule.low[f] = std::max(rule.low[f], low);
+            rule.high[f] = std::min(rule.high[f], high);
+            if (rule.low[f] > rule.high[f])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Computes which children of a cut a rule falls into.
+     */
+    bool DecisionTree::ChildSpan(const Rule& rule, const Region& region, uint32_t field, uint32_t cutBits,
+                                 uint32_t& first, uint32_t& last)
+    {
+        uint64_t low = region.low[field];
+        uint64_t high = low + (1ULL << region.bits[field]) - 1;
+        if (rule.high[field] < low || rule.low[field] > high)
+        {
+            return false;
+        }
+
+        uint32_t shift = region.bits[field] - cutBits;
+        first = (std::max(rule.low[field], low) - low) >> shift;
+        last = (std::min(rule.high[field], high) - low) >> shift;
+        return true;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Shrinks a field of the region to the smallest aligned block holding the rules that
+     * do not span the whole region.
+     * \details Rules that span the region end up in every child whatever is cut, and a packet
+     * outside the block can only match those. So the cut may start at the first bit where the
+     * other rules differ instead of the top of the region (HyperCuts region compaction).
+     * \returns false if no rule constrains the field inside the region.
+     */
+    bool DecisionTree::Compact(const std::vector<uint32_t>& rules, const Region& region, uint32_t field, Region& compacted) const
+    {
+        uint64_t low = region.low[field];
+        uint64_t high = low + (1ULL << region.bits[field]) - 1;
+        uint64_t minLow = high;
+        uint64_t maxHigh = low;
+        bool constrained = false;
+
+        for (uint32_t r : rules)
+        {
+            const Rule& rule = m_rules[r];
+            if (rule.low[field] <= low && rule.high[field] >= high)
+            {
+                continue;
+            }
+
+            constrained = true;
+            minLow = std::min(minLow, std::max(rule.low[field], low));
+            maxHigh = std::max(maxHigh, std::min(rule.high[field], high));
+        }
+
+        if (!constrained)
+        {
+            return false;
+        }
+
+        // The block is fixed by the bits where minLow and maxHigh agree
+        uint32_t bits = 0;
+        while (bits < region.bits[field] && (minLow >> bits) != (maxHigh >> bits))
+        {
+            bits++;
+        }
+
+        compacted = region;
+        compacted.low[field] = (minLow >> bits) << bits;
+        compacted.bits[field] = bits;
+        return true;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Cuts a node, or makes it a leaf when no cut helps.
+     * \details Each field is first compacted, then the largest cut within the space factor is
+     * found, and the field whose cut leaves the smallest largest child wins (the HiCuts heuristic).
+     */
+    void DecisionTree::BuildNode(uint32_t node, const std::vector<uint32_t>& rules, const Region& region)
+    {
+        if (rules.size() <= LEAF_SIZE)
+        {
+            MakeLeaf(node, rules);
+            return;
+        }
+
+        uint32_t bestField = FIELDS;
+        uint32_t bestBits = 0;
+        uint32_t bestLargest = rules.size();
+        uint64_t bestCopies = 0;
+        Region bestRegion = region;
+
+        for (uint32_t f = 0; f < FIELDS; ++f)
+        {
+            Region compacted;
+            if (!Compact(rules, region, f, compacted))
+            {
+                continue;
+            }
+
+            for (uint32_t bits = 1; bits <= std::min(MAX_CUT_BITS, compacted.bits[f]); ++bits)
+            {
+                // Count the rules of every child with a difference array
+                std::vector<int64_t> counts((1u << bits) + 1, 0);
+                for (uint32_t r : rules)
+                {
+                    uint32_t first;
+                    uint32_t last;
+                    if (ChildSpan(m_rules[r], compacted, f, bits, first, last))
+                    {
+                        counts[first]++;
+                        counts[last + 1]--;
+                    }
+                }
+
+                uint64_t copies = 0;
+                uint32_t largest = 0;
+                int64_t running = 0;
+                for (uint32_t c = 0; c < (1u << bits); ++c)
+                {
+                    running += counts[c];
+                    copies += running;
+                    largest = std::max<uint32_t>(largest, running);
+                }
+
+                // Stop growing the cut once it copies too many rules
+                if (copies + (1u << bits) > static_cast<uint64_t>(SPACE_FACTOR) * rules.size())
+                {
+                    break;
+                }
+
+                if (largest < bestLargest)
+                {
+                    bestField = f;
+                    bestBits = bits;
+                    bestLargest = largest;
+                    bestCopies = copies;
+                    bestRegion = compacted;
+                }
+            }
+        }
+
+        // No cut makes progress, or the tree would outgrow its memory bound
+        if (bestField == FIELDS || m_leafRules.size() + m_pending - rules.size() + bestCopies > m_referenceLimit)
+        {
+            MakeLeaf(node, rules);
+            return;
+        }
+
+        uint32_t children = 1u << bestBits;
+        uint32_t shift = bestRegion.bits[bestField] - bestBits;
+
+        std::vector<std::vector<uint32_t>> childRules(children);
+        for (uint32_t r : rules)
+        {
+            uint32_t first;
+            uint32_t last;
+            if (ChildSpan(m_rules[r], bestRegion, bestField, bestBits, first, last))
+            {
+                for (uint32_t c = first; c <= last; ++c)
+                {
+                    childRules[c].push_back(r);
+                }
+            }
+        }
+
+        m_pending = m_pending - rules.size() + bestCopies;
+
+        uint32_t firstChild = m_nodes.size();
+        m_nodes[node].leaf = false;
+        m_nodes[node].field = bestField;
+        m_nodes[node].shift = shift;
+        m_nodes[node].mask = children - 1;
+        m_nodes[node].firstChild = firstChild;
+        m_nodes.resize(m_nodes.size() + children);
+
+        for (uint32_t c = 0; c < children; ++c)
+        {
+            Region child = bestRegion;
+            child.low[bestField] = bestRegion.low[bestField] + (static_cast<uint64_t>(c) << shift);
+            child.bits[bestField] = shift;
+            BuildNode(firstChild + c, childRules[c], child);
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Stores the rules of a leaf (already in class order).
+     */
+    void DecisionTree::MakeLeaf(uint32_t node, const std::vector<uint32_t>& rules)
+    {
+        m_nodes[node].leaf = true;
+        m_nodes[node].ruleBegin = m_leafRules.size();
+        m_leafRules.insert(m_leafRules.end(), rules.begin(), rules.end());
+        m_nodes[node].ruleEnd = m_leafRules.size();
+        m_pending -= rules.size();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Walks to the leaf of the packet and checks its rules in class order.
+     */
+    uint32_t DecisionTree::Lookup(const FlowKey& key) const
+    {
+        if (m_nodes.empty())
+        {
+            return NO_MATCH;
+        }
+
+        const Node* node = &m_nodes[0];
+        while (!node->leaf)
+        {
+            uint32_t value = key.Get(static_cast<FlowField>(node->field + 1));
+            node = &m_nodes[node->firstChild + ((value >> node->shift) & node->mask)];
+        }
+
+        for (uint32_t i = node->ruleBegin; i < node->ruleEnd; ++i)
+        {
+            const Rule& rule = m_rules[m_leafRules[i]];
+            if (rule.filter == nullptr || rule.filter->Match(key))
+            {
+                return rule.classIndex;
+            }
+        }
+
+        return NO_MATCH;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of nodes.
+     */
+    uint32_t DecisionTree::GetNodeCount() const
+    {
+        return m_nodes.size();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of rule references stored in leaves.
+     */
+    uint32_t DecisionTree::GetRuleReferences() const
+    {
+        return m_leafRules.size();
+    }
+} // namespace ns3
@@ -0,0 +1,135 @@
+#ifndef DECISION_TREE_H
+#define DECISION_TREE_H
+
+#include <vector>
+#include <array>
+#include <limits>
+#include "flow-key.h"
+#include "filter.h"
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief HiCuts-style decision tree compiled from the filters of a DiffServ instance.
+     *
+     * Every rule is projected onto one range per header field (the whole field for elements that
+     * cannot be described). Internal nodes first shrink a field of their region to the aligned
+     * block where the rules differ, then cut it into 2^k equal parts,
+     * picking the field and k that shrink the largest child most while keeping the copies of
+     * rules within SPACE_FACTOR times the rules of the node. Nodes with at most LEAF_SIZE rules
+     * become leaves and are searched linearly with Filter::Match in class order, so the tree
+     * keeps first-match semantics and never depends on the cuts being exact.
+     *
+     * The total number of rule references stored in leaves is capped, which bounds the memory
+     * of the tree. Once the cap is reached the remaining nodes become (larger) leaves.
+     */
+    class DecisionTree
+    {
+        public:
+            // Returned by Lookup() when no rule matches
+            static constexpr uint32_t NO_MATCH = std::numeric_limits<uint32_t>::max();
+
+            // Rules per leaf below which a node is not cut further
+            static constexpr uint32_t LEAF_SIZE = 8;
+
+            // Most cut bits per node (at most 2^8 children)
+            static constexpr uint32_t MAX_CUT_BITS = 8;
+
+            // Allowed growth of rule copies per cut
+            static constexpr uint32_t SPACE_FACTOR = 4;
+
+            // Cap on rule references stored in the whole tree, per rule
+            static constexpr uint32_t REFERENCES_PER_RULE = 32;
+
+            /**
+             * \brief Compile the tree.
+             * \param filters The rules in class order: (class index, filter), where a null filter matches everything.
+             */
+            void Build(const std::vector<std::pair<uint32_t, const Filter*>>& filters);
+
+            /**
+             * \brief Find the first rule (in class order) matching the packet.
+             * \param key The parsed header view of the packet.
+             * \returns The class index, or NO_MATCH.
+             */
+            uint32_t Lookup(const FlowKey& key) const;
+
+            /**
+             * \brief Size of the compiled tree.
+             */
+            uint32_t GetNodeCount() const;
+            uint32_t GetRuleReferences() const;
+
+        private:
+            // Number of header fields (FlowField without NONE)
+            static constexpr uint32_t FIELDS = 6;
+
+            struct Rule
+            {
+                uint32_t classIndex;
+                const Filter* filter;
+                std::array<uint64_t, FIELDS> low;
+                std::array<uint64_t, FIELDS> high;
+            };
+
+            struct Node
+            {
+                // Leaf: rules [ruleBegin, ruleEnd) of m_leafRules
+                bool leaf = true;
+                uint32_t ruleBegin = 0;
+                uint32_t ruleEnd = 0;
+
+                // Internal: child = firstChild + ((field >> shift) & mask)
+                uint8_t field = 0;
+                uint8_t shift = 0;
+                uint32_t mask = 0;
+                uint32_t firstChild = 0;
+            };
+
+            // A node's region is an aligned block of 2^bits values per field
+            struct Region
+            {
+                std::array<uint64_t, FIELDS> low;
+                std::array<uint32_t, FIELDS> bits;
+            };
+
+            /**
+             * \brief Turn a filter into per-field ranges.
+             * \returns false if the filter can never match (two elements on one field that do not overlap).
+             */
+            static bool Project(const Filter* filter, Rule& rule);
+
+            /**
+             * \brief Shrink one field of a region to the aligned block where the rules differ.
+             * \returns false if no rule constrains the field inside the region.
+             */
+            bool Compact(const std::vector<uint32_t>& rules, const Region& region, uint32_t field, Region& compacted) const;
+
+            /**
+             * \brief Build the subtree of a node.
+             */
+            void BuildNode(uint32_t node, const std::vector<uint32_t>& rules, const Region& region);
+
+            /**
+             * \brief Make a node a leaf holding the given rules.
+             */
+            void MakeLeaf(uint32_t node, const std::vector<uint32_t>& rules);
+
+            /**
+             * \brief Child range [first, last] of a rule when a field of the region is cut into 2^cutBits parts.
+             * \returns false if the rule does not overlap the region on that field.
+             */
+            static bool ChildSpan(const Rule& rule, const Region& region, uint32_t field, uint32_t cutBits,
+                                  uint32_t& first, uint32_t& last);
+
+            std::vector<Rule> m_rules;
+            std::vector<Node> m_nodes;
+            std::vector<uint32_t> m_leafRules;
+            uint32_t m_referenceLimit = 0;
+
+            // Rules held by nodes that are not yet a leaf or cut
+            uint64_t m_pending = 0;
+    };
+} // namespace ns3
+
+#endif // DECISION_TREE_H
@@ -1,6 +1,4 @@
-#include "ns3/ipv4-header.h"
 #include "destination-ip-address.h"
-#include "ns3/ppp-header.h"
 #include "ns3/log.h"
 
 NS_LOG_COMPONENT_DEFINE("DestinationIPAddress");  
@@ -16,33 +14,33 @@ namespace ns3 {
     /**
      * \ingroup diffserv
      * \brief Match the packet against the destination IP address.
-     * \param pkt The packet to check.
+     * \param key The parsed header view of the packet to check.
      * \returns true if the packet matches, false otherwise.
      */
     bool
-    DestinationIPAddress::Match(Ptr<Packet> pkt) const
+    DestinationIPAddress::Match(const FlowKey& key) const
     {
-        // Make a copy of the packet to avoid modifying the original
-        Ptr<Packet> packetCopy = pkt->Copy();
-
-        // Use Headers to remove the PPP header and check the destination IP
-        Ipv4Header ipv4Header;
-        PppHeader pppHeader;
-
-        if (!packetCopy->RemoveHeader(pppHeader))
-        {
-            NS_LOG_WARN("Packet does not contain PPP header");
-            return false;
-        }
-
-        // If we can't access the header, return false
-        if (!packetCopy->PeekHeader(ipv4Header))
+        // Packets without an IPv4 header never match
+        if (!key.hasIpv4)
         {
-            NS_LOG_WARN("Packet does not contain IPv4 header");
             return false;
         }
 
-        return ipv4Header.GetDestination() == m_destinationIp;
+        return key.destinationAddress == m_destinationIp;
     }
 
+
+    /**
+     * \ingroup diffserv
+     * \brief Describe the element as an exact match on the destination address.
+     * \param field Set to FlowField::DESTINATION_ADDRESS.
+     * \param value Set to the destination address to match.
+     * \returns true
+     */
+    bool DestinationIPAddress::GetExactMatch(FlowField& field, uint32_t& value) const
+    {
+        field = FlowField::DESTINATION_ADDRESS;
+        value = m_destinationIp.Get();
+        return true;
+    }
 } // namespace ns3
\ No newline at end of file
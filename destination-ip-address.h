@@ -15,6 +15,8 @@ namespace ns3 {
     {
 
     public:
+        using FilterElement::Match;
+
         /**
          * \brief Constructor.
          * \param destinationIp The destination IP address to match.
@@ -23,10 +25,16 @@ namespace ns3 {
 
         /**
          * \brief Match the packet against the destination IP address.
-         * \param pkt The packet to check.
+         * \param key The parsed header view of the packet to check.
          * \returns true if the packet matches, false otherwise.
          */
-        bool Match(Ptr<Packet> pkt) const override;
+        bool Match(const FlowKey& key) const override;
+
+        /**
+         * \brief Describe the element as an exact match on the destination address.
+         * \returns true, so DiffServ can index the element.
+         */
+        bool GetExactMatch(FlowField& field, uint32_t& value) const override;
 
     private:
         Ipv4Address m_destinationIp;
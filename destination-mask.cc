@@ -1,6 +1,4 @@
-#include "ns3/ipv4-header.h"
 #include "destination-mask.h"
-#include "ns3/ppp-header.h"
 #include "ns3/log.h"
 
 NS_LOG_COMPONENT_DEFINE("DestinationMask");  
@@ -17,36 +15,42 @@ namespace ns3 {
     /**
      * \ingroup diffserv
      * \brief Match the packet's destination IP address using the stored mask.
-     * \param pkt The packet to inspect.
+     * \param key The parsed header view of the packet to inspect.
      * \returns true if the masked destination IP matches, false otherwise.
      */
     bool
-    DestinationMask::Match(Ptr<Packet> pkt) const
+    DestinationMask::Match(const FlowKey& key) const
     {
-        // Make a copy of the packet to avoid modifying the original
-        Ptr<Packet> packetCopy = pkt->Copy();
-
-        // Use Headers to remove the PPP header and check the destination IP
-        Ipv4Header ipv4Header;
-        PppHeader pppHeader;
-
-        if (!packetCopy->RemoveHeader(pppHeader))
+        // Packets without an IPv4 header never match
+        if (!key.hasIpv4)
         {
-            NS_LOG_WARN("Packet does not contain PPP header");
             return false;
         }
 
-        // If we can't access the packet header, return false
-        if (!packetCopy->RemoveHeader(ipv4Header))
+        // NS3 standard is to prefer CombineMask over IsMatch (which use the same underlying functionality)
+        return (key.destinationAddress.CombineMask(m_mask) == m_address.CombineMask(m_mask));
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Describe the element as a destination address prefix.
+     * \param field Set to FlowField::DESTINATION_ADDRESS.
+     * \param prefix Set to the masked address.
+     * \param length Set to the mask's prefix length.
+     * \returns false for a non-contiguous mask (e.g. 255.0.255.0), which only Match() can evaluate.
+     */
+    bool DestinationMask::GetPrefixMatch(FlowField& field, uint32_t& prefix, uint8_t& length) const
+    {
+        // A contiguous mask has all of its host bits at the bottom
+        uint32_t hostBits = ~m_mask.Get();
+        if ((hostBits & (hostBits + 1)) != 0)
         {
-            NS_LOG_WARN("Packet does not contain IPv4 header");
             return false;
         }
 
-        // Apply the mask and compare
-        Ipv4Address destinationIpAddress = ipv4Header.GetDestination();
-
-        // NS3 standard is to prefer CombineMask over IsMatch (which use the same underlying functionality)
-        return (destinationIpAddress.CombineMask(m_mask) == m_address.CombineMask(m_mask));
+        field = FlowField::DESTINATION_ADDRESS;
+        prefix = m_address.CombineMask(m_mask).Get();
+        length = static_cast<uint8_t>(m_mask.GetPrefixLength());
+        return true;
     }
 } // namespace ns3
\ No newline at end of file
@@ -15,6 +15,8 @@ namespace ns3 {
     {
 
     public:
+        using FilterElement::Match;
+
         /**
          * \brief Constructor.
          * \param mask The destination IP mask to apply.
@@ -24,10 +26,16 @@ namespace ns3 {
 
         /**
          * \brief Match the packet's destination IP address using the provided mask.
-         * \param pkt The packet to inspect.
+         * \param key The parsed header view of the packet to inspect.
          * \returns true if the masked destination IP matches, false otherwise.
          */
-        bool Match(Ptr<Packet> pkt) const override;
+        bool Match(const FlowKey& key) const override;
+
+        /**
+         * \brief Describe the element as a destination address prefix.
+         * \returns true if the mask is contiguous, so DiffServ can put the element in its prefix trie.
+         */
+        bool GetPrefixMatch(FlowField& field, uint32_t& prefix, uint8_t& length) const override;
 
     private:
         Ipv4Mask m_mask;
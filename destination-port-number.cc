@@ -1,8 +1,4 @@
-#include "ns3/ipv4-header.h"
-#include "ns3/tcp-header.h"
-#include "ns3/udp-header.h"
 #include "destination-port-number.h"
-#include "ns3/ppp-header.h"
 #include "ns3/log.h"
 
 NS_LOG_COMPONENT_DEFINE("DestinationPortNumber"); 
@@ -18,60 +14,32 @@ namespace ns3 {
     /**
      * \ingroup diffserv
      * \brief Match the packet against the stored destination port number.
-     * \param pkt The packet to inspect.
+     * \param key The parsed header view of the packet to inspect.
      * \returns true if the destination port matches, else false.
      */
-    bool DestinationPortNumber::Match(Ptr<Packet> pkt) const
+    bool DestinationPortNumber::Match(const FlowKey& key) const
     {
-        // Make a copy of the packet to avoid modifying the original
-        Ptr<Packet> packetCopy = pkt->Copy();
-
-        // Use Headers to remove the PPP header and check the destination port
-        Ipv4Header ipv4Header;
-        PppHeader pppHeader;
-
-        if (!packetCopy->RemoveHeader(pppHeader))
-        {
-            NS_LOG_WARN("Packet does not contain PPP header");
-            return false;
-        }
-        
-        if (!packetCopy->RemoveHeader(ipv4Header))
+        // Only TCP (6) and UDP (17) packets carry ports
+        if (!key.hasPorts)
         {
-            NS_LOG_WARN("Packet does not contain IPv4 header");
+            NS_LOG_WARN("Unknown protocol: " << static_cast<int>(key.protocol));
             return false;
         }
 
-        // Check the protocol type (TCP or UDP)
-        uint8_t protocol = ipv4Header.GetProtocol();
-
-        // Check if the protocol is TCP (6) or UDP (17)
-        if (protocol == 6)
-        {
-            TcpHeader tcpHeader;
-            if (!packetCopy->PeekHeader(tcpHeader))
-            {
-                NS_LOG_WARN("Packet does not contain TCP header");
-                return false;
-            }
-
-            uint16_t dst = tcpHeader.GetDestinationPort();
-            return dst == m_destinationPort;
-        }
-        else if (protocol == 17)
-        {
-            UdpHeader udpHeader;
-            if (!packetCopy->PeekHeader(udpHeader))
-            {
-                NS_LOG_WARN("Packet does not contain UDP header");
-                return false;
-            }
-
-            uint16_t dst = udpHeader.GetDestinationPort();
-            return dst == m_destinationPort;
-        }
+        return key.destinationPort == m_destinationPort;
+    }
 
-        NS_LOG_WARN("Unknown protocol: " << static_cast<int>(protocol));
-        return false;
+    /**
+     * \ingroup diffserv
+     * \brief Describe the element as an exact match on the destination port.
+     * \param field Set to FlowField::DESTINATION_PORT.
+     * \param value Set to the destination port to match.
+     * \returns true
+     */
+    bool DestinationPortNumber::GetExactMatch(FlowField& field, uint32_t& value) const
+    {
+        field = FlowField::DESTINATION_PORT;
+        value = m_destinationPort;
+        return true;
     }
 } // namespace ns3
\ No newline at end of file
@@ -13,6 +13,8 @@ namespace ns3 {
     class DestinationPortNumber : public FilterElement
     {
         public:
+            using FilterElement::Match;
+
             /**
              * \brief Constructor.
              * \param destinationPort The destination port number to match.
@@ -21,10 +23,16 @@ namespace ns3 {
 
             /**
              * \brief Match the packet against the referenced destination port number.
-             * \param pkt The packet to inspect.
+             * \param key The parsed header view of the packet to inspect.
              * \returns true if the destination port matches, false otherwise.
              */
-            bool Match(Ptr<Packet> pkt) const override;
+            bool Match(const FlowKey& key) const override;
+
+            /**
+             * \brief Describe the element as an exact match on the destination port.
+             * \returns true, so DiffServ can index the element.
+             */
+            bool GetExactMatch(FlowField& field, uint32_t& value) const override;
 
         private:
             uint32_t m_destinationPort;
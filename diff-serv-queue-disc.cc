@@ -0,0 +1,239 @@
+#include "diff-serv-queue-disc.h"
+#include "ns3/ppp-header.h"
+#include "ns3/ipv4-queue-disc-item.h"
+#include "ns3/log.h"
+#include <iterator>
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Constructor for DiffServQueueDisc. The scheduler is set with SetScheduler.
+     */
+    DiffServQueueDisc::DiffServQueueDisc() {}
+
+    /**
+     * \ingroup diffserv
+     * \brief Destructor for DiffServQueueDisc.
+     */
+    DiffServQueueDisc::~DiffServQueueDisc() {}
+
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the scheduler.
+     * \details The mirror of the scheduler's items is the single internal queue of the queue disc.
+     */
+    void DiffServQueueDisc::SetScheduler(Ptr<DiffServ> scheduler)
+    {
+        m_scheduler = scheduler;
+        m_items = CreateObject<ScheduledItems>(scheduler);
+        AddInternalQueue(m_items);
+
+        m_scheduler->SetReleaseCallback(MakeCallback(&DiffServQueueDisc::Released, this));
+        m_scheduler->SetDropCallback(MakeCallback(&ScheduledItems::Dropped, PeekPointer(m_items)));
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the scheduler.
+     */
+    Ptr<DiffServ> DiffServQueueDisc::GetScheduler() const
+    {
+        return m_scheduler;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Disconnects the scheduler, whose callbacks point back at this queue disc.
+     */
+    void DiffServQueueDisc::DoDispose()
+    {
+        if (m_scheduler)
+        {
+            m_scheduler->SetReleaseCallback(Callback<void>());
+            m_scheduler->SetDropCallback(Callback<void, Ptr<const Packet>>());
+        }
+        m_scheduler = nullptr;
+        m_items = nullptr;
+        QueueDisc::DoDispose();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Hands the item to the scheduler through the mirror.
+     */
+    bool DiffServQueueDisc::DoEnqueue(Ptr<QueueDiscItem> item)
+    {
+        return m_items->Enqueue(item);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Takes the item of the packet the scheduler serves next.
+     * \returns The item, or nullptr if every backlogged class is held.
+     */
+    Ptr<QueueDiscItem> DiffServQueueDisc::DoDequeue()
+    {
+        return m_items->Dequeue();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Checks that the queue disc only holds the mirror of its scheduler.
+     */
+    bool DiffServQueueDisc::CheckConfig()
+    {
+        if (!m_scheduler)
+        {
+            NS_LOG_UNCOND("DiffServQueueDisc: no scheduler set");
+            return false;
+        }
+
+        if (GetNQueueDiscClasses() > 0 || GetNPacketFilters() > 0 || GetNInternalQueues() != 1)
+        {
+            NS_LOG_UNCOND("DiffServQueueDisc: classes, filters and queues come from the scheduler");
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Nothing to initialize; the scheduler is configured before it is set.
+     */
+    void DiffServQueueDisc::InitializeParams()
+    {
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Runs the queue disc once a held class became eligible.
+     * \details A run while the device is busy stops at the device queue as usual, and the device
+     * wakes the queue disc again when it drains.
+     */
+    void DiffServQueueDisc::Released()
+    {
+        Run();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Constructor for the item mirror. Admission is left to the scheduler, so the mirror
+     * itself has no size limit.
+     */
+    DiffServQueueDisc::ScheduledItems::ScheduledItems(Ptr<DiffServ> scheduler) : m_scheduler(scheduler)
+    {
+        SetMaxSize(QueueSize(QueueSizeUnit::PACKETS, std::numeric_limits<uint32_t>::max()));
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Lifts the limit again once the attributes are set, since CreateObject resets
+     * MaxSize to its 100 packet default after the constructor ran.
+     */
+    void DiffServQueueDisc::ScheduledItems::NotifyConstructionCompleted()
+    {
+        SetMaxSize(QueueSize(QueueSizeUnit::PACKETS, std::numeric_limits<uint32_t>::max()));
+        Queue<QueueDiscItem>::NotifyConstructionCompleted();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Offers the scheduler a framed copy of the item's packet, as the device would queue it.
+     * \details The item itself is left untouched: the traffic control layer adds its IPv4 header
+     * when it hands the item to the device, and that must be the only time it is added.
+     * \returns false (with the item counted as dropped) if the scheduler refused the packet.
+     */
+    bool DiffServQueueDisc::ScheduledItems::Enqueue(Ptr<QueueDiscItem> item)
+    {
+        Ptr<Packet> framed = item->GetPacket()->Copy();
+        Ptr<Ipv4QueueDiscItem> ipv4Item = DynamicCast<Ipv4QueueDiscItem>(item);
+        if (ipv4Item)
+        {
+            framed->AddHeader(ipv4Item->GetHeader());
+        }
+
+        // 0x0021 is the PPP protocol number of IPv4
+        PppHeader ppp;
+        ppp.SetProtocol(0x0021);
+        framed->AddHeader(ppp);
+
+        if (!m_scheduler->Enqueue(framed))
+        {
+            DropBeforeEnqueue(item);
+            return false;
+        }
+
+        DoEnqueue(GetContainer().end(), item);
+        m_positions[PeekPointer(framed)] = std::prev(GetContainer().end());
+        return true;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Takes the item of the packet the scheduler dequeues.
+     */
+    Ptr<QueueDiscItem> DiffServQueueDisc::ScheduledItems::Dequeue()
+    {
+        Ptr<Packet> pkt = m_scheduler->Dequeue();
+        return pkt ? Release(pkt, false) : nullptr;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Takes the item of the packet the scheduler removes, counted as a drop.
+     */
+    Ptr<QueueDiscItem> DiffServQueueDisc::ScheduledItems::Remove()
+    {
+        Ptr<Packet> pkt = m_scheduler->Remove();
+        return pkt ? Release(pkt, true) : nullptr;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Looks up the item of the packet the scheduler would serve next.
+     */
+    Ptr<const QueueDiscItem> DiffServQueueDisc::ScheduledItems::Peek() const
+    {
+        Ptr<const Packet> head = m_scheduler->Schedule();
+        if (!head)
+        {
+            return nullptr;
+        }
+
+        auto position = m_positions.find(PeekPointer(head));
+        return position != m_positions.end() ? *position->second : nullptr;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Drops the item of a packet that a class evicted.
+     */
+    void DiffServQueueDisc::ScheduledItems::Dropped(Ptr<const Packet> pkt)
+    {
+        auto position = m_positions.find(PeekPointer(pkt));
+        if (position != m_positions.end())
+        {
+            DoRemove(position->second);
+            m_positions.erase(position);
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Takes the item of a framed packet out of the mirror; the framed copy is discarded.
+     */
+    Ptr<QueueDiscItem> DiffServQueueDisc::ScheduledItems::Release(Ptr<Packet> pkt, bool dropped)
+    {
+        auto position = m_positions.find(PeekPointer(pkt));
+        if (position == m_positions.end())
+        {
+            NS_LOG_UNCOND("DiffServQueueDisc: the scheduler returned a packet it was not given");
+            return nullptr;
+        }
+
+        Ptr<QueueDiscItem> item = dropped ? DoRemove(position->second) : DoDequeue(position->second);
+        m_positions.erase(position);
+        return item;
+    }
+} // namespace ns3
@@ -0,0 +1,96 @@
+#ifndef DIFF_SERV_QUEUE_DISC_H
+#define DIFF_SERV_QUEUE_DISC_H
+
+#include <unordered_map>
+#include "ns3/queue-disc.h"
+#include "diff-serv.h"
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Root queue disc that runs a DiffServ scheduler above a device.
+     *
+     * A device pulls from its queue right after a Send on an idle link, so a DiffServ installed
+     * as the device queue must always hand out a packet it has just admitted. Shapers and gate
+     * control lists hold packets back, so they need this queue disc instead: the traffic control
+     * layer enqueues and then runs the queue disc, a run that finds every backlogged class held
+     * simply sends nothing, and the DiffServ release callback runs the queue disc again when a
+     * class becomes eligible (the way TbfQueueDisc restarts itself when its tokens arrive). The
+     * device keeps a small FIFO of its own and wakes the queue disc whenever it drains it.
+     *
+     * The DiffServ gets a copy of each item's packet framed as the device would have queued it
+     * (the item's IPv4 header and a PPP header in front), so the classifier, the conditioners and
+     * the per-class byte counts see the same packet. The copy only stands for the item: the item
+     * leaves unchanged, and the traffic control layer adds its IPv4 header before the device adds
+     * its own PPP header.
+     */
+    class DiffServQueueDisc : public QueueDisc
+    {
+        public:
+            DiffServQueueDisc();
+            ~DiffServQueueDisc() override;
+
+            /**
+             * \brief Set the scheduler. Its release and drop callbacks are taken over by this queue disc.
+             * \param scheduler The DiffServ holding the traffic classes.
+             */
+            void SetScheduler(Ptr<DiffServ> scheduler);
+            Ptr<DiffServ> GetScheduler() const;
+
+        protected:
+            void DoDispose() override;
+
+        private:
+            /**
+             * \brief Internal queue mirroring the items held by the scheduler.
+             * \details The scheduler decides the order, while the mirror keeps the items (and
+             * the QueueDisc statistics and traces) in step with it: every packet in the scheduler
+             * maps to the position of its item, so an item is taken out wherever its packet left.
+             */
+            class ScheduledItems : public Queue<QueueDiscItem>
+            {
+                public:
+                    explicit ScheduledItems(Ptr<DiffServ> scheduler);
+
+                    bool Enqueue(Ptr<QueueDiscItem> item) override;
+                    Ptr<QueueDiscItem> Dequeue() override;
+                    Ptr<QueueDiscItem> Remove() override;
+                    Ptr<const QueueDiscItem> Peek() const override;
+
+                    /**
+                     * \brief Drop the item of a packet the scheduler dropped after admitting it.
+                     */
+                    void Dropped(Ptr<const Packet> pkt);
+
+                private:
+                    /**
+                     * \brief Lift the QueueBase "MaxSize" default that CreateObject applies after the constructor.
+                     */
+                    void NotifyConstructionCompleted() override;
+
+                    /**
+                     * \brief Take the item of a framed copy that left the scheduler out of the mirror.
+                     * \param dropped true if the scheduler dropped the packet rather than sent it.
+                     */
+                    Ptr<QueueDiscItem> Release(Ptr<Packet> pkt, bool dropped);
+
+                    Ptr<DiffServ> m_scheduler;
+                    std::unordered_map<const Packet*, ConstIterator> m_positions;
+            };
+
+            bool DoEnqueue(Ptr<QueueDiscItem> item) override;
+            Ptr<QueueDiscItem> DoDequeue() override;
+            bool CheckConfig() override;
+            void InitializeParams() override;
+
+            /**
+             * \brief Release callback of the scheduler: send what became eligible.
+             */
+            void Released();
+
+            Ptr<DiffServ> m_scheduler;
+            Ptr<ScheduledItems> m_items;
+    };
+} // namespace ns3
+
+#endif // DIFF_SERV_QUEUE_DISC_H
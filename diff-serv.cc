@@ -1,12 +1,41 @@
 #include "diff-serv.h"
 #include "ns3/log.h"
+#include "ns3/simulator.h"
+#include <algorithm>
 
 namespace ns3 {
     /**
      * \brief Constructor for DiffServ class
-     * \details Initializes the DiffServ class and sets up the logging component.
+     * \details Starts without an aggregate limit; the classes' own limits bound the scheduler.
      */
-    DiffServ::DiffServ() {}
+    DiffServ::DiffServ()
+    {
+        SetMaxSize(QueueSize(QueueSizeUnit::PACKETS, std::numeric_limits<uint32_t>::max()));
+    }
+
+    /**
+     * \brief Lifts the QueueBase "MaxSize" default (100 packets) applied by CreateObject.
+     * \details The attributes are set after the constructor ran, so the limit is lifted again
+     * here. A MaxSize set afterwards is enforced over all classes together.
+     */
+    void DiffServ::NotifyConstructionCompleted()
+    {
+        SetMaxSize(QueueSize(QueueSizeUnit::PACKETS, std::numeric_limits<uint32_t>::max()));
+        Queue<Packet>::NotifyConstructionCompleted();
+    }
+
+    /**
+     * \brief Destructor for DiffServ class
+     * \details Cancels the pending shaper release events, which refer to this instance.
+     */
+    DiffServ::~DiffServ()
+    {
+        for (EventId& event : releaseEvents)
+        {
+            Simulator::Cancel(event);
+        }
+        Simulator::Cancel(gateEvent);
+    }
 
     // Create Enqueue, Dequeue, Remove, and Peek methods
     /**
@@ -51,16 +80,23 @@ namespace ns3 {
      */
     Ptr<Packet> DiffServ::DoRemove()
     {
-        Ptr<const Packet> pktToRemove = Schedule();
+        // Ask the scheduler which queue holds the scheduled packet
+        uint32_t index = ScheduleQueue();
 
-        // If the scheduled packet is not null, classify it and remove from the corresponding queue
-        if (pktToRemove != nullptr)
+        // If the index is valid, remove from the corresponding queue
+        if (index < q_class.size())
         {
-            uint32_t index = Classify(pktToRemove->Copy());
-            if (index < q_class.size())
+            CommitSchedule(index);
+            ChargeShaper(index);
+            Ptr<Packet> pkt = q_class[index]->Remove();
+
+            // A removed packet counts as dropped
+            if (pkt)
             {
-                return q_class[index]->Remove();
+                Unmirror(pkt, true);
             }
+
+            return pkt;
         }
 
         return nullptr;
@@ -72,18 +108,186 @@ namespace ns3 {
      */
     bool DiffServ::DoEnqueue(Ptr<Packet> pkt)
     {
+        // Bring the gates up to date if their events stopped while the scheduler was empty.
+        // The owner dequeues right after this enqueue, so an opening needs no release callback.
+        if (gateControlList && !releaseCallback.IsNull() && !gateEvent.IsPending())
+        {
+            UpdateGates();
+        }
+
+        // Parse the headers once; the classifier and the conditioner share the view
+        FlowKey key = FlowKey::Parse(pkt);
+
         // Get the index of the queue to which the packet belongs
-        uint32_t queueIndex = Classify(pkt);
+        uint32_t queueIndex = Classify(key);
 
         // If the index is invalid, return false
-        if (queueIndex == static_cast<uint32_t>(-1) || queueIndex >= q_class.size())
+        if (queueIndex == NO_QUEUE || queueIndex >= q_class.size())
         {
             NS_LOG_UNCOND("Invalid queue index. Packet not enqueued.");
+            DropBeforeEnqueue(pkt);
+            return false;
+        }
+
+        // Meter and mark the packet if its class has a conditioner
+        TrafficConditioner* conditioner = q_class[queueIndex]->GetConditioner();
+        if (conditioner)
+        {
+            uint8_t dscp = key.dscp;
+            if (!conditioner->Condition(pkt, key))
+            {
+                NS_LOG_UNCOND("Out of profile for queue " << queueIndex << ". Packet not enqueued.");
+                DropBeforeEnqueue(pkt);
+                return false;
+            }
+
+            // A remarked (downgraded) packet may now belong to another class.
+            // It is not metered a second time.
+            if (key.dscp != dscp)
+            {
+                queueIndex = Classify(key);
+                if (queueIndex == NO_QUEUE || queueIndex >= q_class.size())
+                {
+                    NS_LOG_UNCOND("Invalid queue index. Packet not enqueued.");
+                    DropBeforeEnqueue(pkt);
+                    return false;
+                }
+            }
+        }
+
+        // Drop if the packet would push the whole scheduler past its MaxSize
+        if (!FitsAggregateLimit(pkt))
+        {
+            NS_LOG_UNCOND("Aggregate limit reached. Packet not enqueued.");
+            DropBeforeEnqueue(pkt);
+            return false;
+        }
+
+        // Drop if the class is over its dynamic threshold in the shared pool
+        if (!FitsSharedBuffer(queueIndex, pkt))
+        {
+            NS_LOG_UNCOND("Shared buffer threshold reached for queue " << queueIndex << ". Packet not enqueued.");
+            DropBeforeEnqueue(pkt);
+            return false;
+        }
+
+        // Otherwise, enqueue the packet into the appropriate queue.
+        // A class with flow sub-queues may drop a packet of its longest flow to make room;
+        // NotifyDropped takes that packet out of the base.
+        if (!q_class[queueIndex]->Enqueue(pkt, key))
+        {
+            DropBeforeEnqueue(pkt);
+            return false;
+        }
+
+        // Account the packet in the Queue<Packet> base. It already passed the MaxSize check
+        // above and an eviction only frees room, so the base admits it.
+        Queue<Packet>::DoEnqueue(GetContainer().end(), pkt);
+        positions[PeekPointer(pkt)] = std::prev(GetContainer().end());
+        NotifyEnqueued(queueIndex, pkt);
+        return true;
+    }
+
+    /**
+     * \brief Checks a packet against the aggregate limit.
+     * \details The limit is the standard QueueBase "MaxSize" attribute, so it can be set with
+     * SetMaxSize(QueueSize("64KB")), SetMaxSize(QueueSize("500p")) or through the attribute
+     * system, and is counted in its own unit over all classes together. It is checked before the
+     * class sees the packet, so a refused packet never evicts one of another flow.
+     */
+    bool DiffServ::FitsAggregateLimit(Ptr<const Packet> pkt) const
+    {
+        QueueSize maxSize = GetMaxSize();
+        uint32_t occupancy = GetCurrentSize().GetValue();
+        uint32_t size = maxSize.GetUnit() == QueueSizeUnit::BYTES ? pkt->GetSize() : 1;
+
+        return occupancy <= maxSize.GetValue() && size <= maxSize.GetValue() - occupancy;
+    }
+
+    /**
+     * \brief Applies the shared pool and the Choudhury-Hahne dynamic threshold.
+     * \details The threshold is T = Alpha * (pool - total occupancy), both counted in the pool's
+     * unit. The class admits while its own occupancy is below T and the packet still fits in the
+     * pool. All occupancies are tracked incrementally, so this is O(1).
+     */
+    bool DiffServ::FitsSharedBuffer(uint32_t index, Ptr<const Packet> pkt) const
+    {
+        if (sharedBuffer.GetValue() == 0)
+        {
+            return true;
+        }
+
+        bool inBytes = sharedBuffer.GetUnit() == QueueSizeUnit::BYTES;
+        double pool = sharedBuffer.GetValue();
+        double total = inBytes ? GetNBytes() : GetNPackets();
+        double occupancy = inBytes ? q_class[index]->GetNBytes() : q_class[index]->GetNPackets();
+        double size = inBytes ? pkt->GetSize() : 1;
+
+        // The packet must fit in what is left of the pool
+        if (total + size > pool)
+        {
             return false;
         }
 
-        // Otherwise, enqueue the packet into the appropriate queue
-        return q_class[queueIndex]->Enqueue(pkt);
+        // And the class must be under its share of the free space
+        return occupancy < q_class[index]->GetAlpha() * (pool - total);
+    }
+
+    /**
+     * \brief Setter for the shared pool size.
+     */
+    void DiffServ::SetSharedBuffer(QueueSize poolSize)
+    {
+        sharedBuffer = poolSize;
+    }
+
+    /**
+     * \brief Getter for the shared pool size.
+     */
+    QueueSize DiffServ::GetSharedBuffer() const
+    {
+        return sharedBuffer;
+    }
+
+    /**
+     * \brief Setter for the classifier mode. The classifier is rebuilt on the next packet.
+     */
+    void DiffServ::SetClassifierMode(ClassifierMode mode)
+    {
+        classifierMode = mode;
+        classifierDirty = true;
+    }
+
+    /**
+     * \brief Getter for the classifier mode.
+     */
+    DiffServ::ClassifierMode DiffServ::GetClassifierMode() const
+    {
+        return classifierMode;
+    }
+
+    /**
+     * \brief Setter for the flow cache size.
+     */
+    void DiffServ::SetFlowCacheSize(uint32_t entries)
+    {
+        flowCache.SetCapacity(entries);
+    }
+
+    /**
+     * \brief Getter for the number of packets classified from the flow cache.
+     */
+    uint64_t DiffServ::GetFlowCacheHits() const
+    {
+        return flowCache.GetHits();
+    }
+
+    /**
+     * \brief Getter for the number of packets that missed the flow cache.
+     */
+    uint64_t DiffServ::GetFlowCacheMisses() const
+    {
+        return flowCache.GetMisses();
     }
 
 
@@ -93,25 +297,301 @@ namespace ns3 {
      */
     Ptr<Packet> DiffServ::DoDequeue()
     {
-         // Get the next scheduled packet
-        Ptr<const Packet> scheduledPkt = Schedule();
+        // Ask the scheduler which queue holds the scheduled packet
+        uint32_t queueIndex = ScheduleQueue();
 
-        // If the scheduledPkt packet is not null, classify it and dequeue from the corresponding queue
-        if (scheduledPkt)
+        // If the index is valid, dequeue from the corresponding queue
+        if (queueIndex < q_class.size())
         {
-            uint32_t queueIndex = Classify(scheduledPkt->Copy());
+            CommitSchedule(queueIndex);
+            ChargeShaper(queueIndex);
+            Ptr<Packet> pkt = q_class[queueIndex]->Dequeue();
 
-            // If the index is valid, dequeue from the corresponding queue
-            if (queueIndex < q_class.size())
+            if (pkt)
             {
-                return q_class[queueIndex]->Dequeue();
+                Unmirror(pkt, false);
             }
+
+            return pkt;
         }
 
         NS_LOG_UNCOND("No packet to dequeue. Returning nullptr.");
         return nullptr;
     }
 
+    /**
+     * \brief Default queue selection for schedulers that only implement Schedule().
+     * \details Finds the queue whose head is the scheduled packet. This compares pointers only,
+     * so no packet copy or rule walk is needed and a packet that matches several classes
+     * is always popped from the queue it was actually enqueued in.
+     * \returns The index of the queue holding the scheduled packet, or NO_QUEUE.
+     */
+    uint32_t DiffServ::ScheduleQueue() const
+    {
+        Ptr<const Packet> scheduledPkt = Schedule();
+
+        if (scheduledPkt)
+        {
+            for (uint32_t i = 0; i < q_class.size(); ++i)
+            {
+                if (!q_class[i]->IsEmpty() && q_class[i]->Peek() == scheduledPkt)
+                {
+                    return i;
+                }
+            }
+        }
+
+        return NO_QUEUE;
+    }
+
+    /**
+     * \brief Checks if a queue may be served now.
+     */
+    bool DiffServ::IsBacklogged(uint32_t index) const
+    {
+        return !q_class[index]->IsEmpty() && !held[index] && IsGateOpen(index);
+    }
+
+    /**
+     * \brief Tracks the shaper hold of a queue, then lets the scheduler catch up.
+     */
+    void DiffServ::QueueChanged(uint32_t index)
+    {
+        UpdateShaper(index);
+        NotifyQueueChanged(index);
+    }
+
+    /**
+     * \brief Holds a shaped queue until its shaper has tokens for the head-of-line packet.
+     * \details Only an empty queue or a new head can change the hold: an empty queue is released,
+     * and a queue that is not held is checked against its new head. The release is a single
+     * Simulator event at the time the bucket will hold the packet. Without a release callback
+     * nobody would dequeue the packet at that time, so the class is never held.
+     */
+    void DiffServ::UpdateShaper(uint32_t index)
+    {
+        TrafficShaper* shaper = q_class[index]->GetShaper();
+        if (!shaper || releaseCallback.IsNull())
+        {
+            return;
+        }
+
+        Time now = Simulator::Now();
+        shaper->NotifyBacklog(!q_class[index]->IsEmpty(), now);
+
+        if (q_class[index]->IsEmpty())
+        {
+            held[index] = false;
+            Simulator::Cancel(releaseEvents[index]);
+            return;
+        }
+
+        if (held[index])
+        {
+            return;
+        }
+
+        Time eligible = shaper->GetEligibleTime(q_class[index]->Peek()->GetSize(), now);
+        if (eligible > now)
+        {
+            held[index] = true;
+            if (eligible != Time::Max())
+            {
+                releaseEvents[index] = Simulator::Schedule(eligible - now, &DiffServ::ReleaseShaped, this, index);
+            }
+        }
+    }
+
+    /**
+     * \brief Makes a held queue eligible again and lets the owner dequeue it.
+     */
+    void DiffServ::ReleaseShaped(uint32_t index)
+    {
+        held[index] = false;
+        NotifyQueueChanged(index);
+        releaseCallback();
+    }
+
+    /**
+     * \brief Counts a packet dropped by a class and passes it on to the owner.
+     */
+    void DiffServ::NotifyDropped(Ptr<const Packet> pkt)
+    {
+        Unmirror(pkt, true);
+
+        if (!dropCallback.IsNull())
+        {
+            dropCallback(pkt);
+        }
+    }
+
+    /**
+     * \brief Takes a packet that left its class out of the Queue<Packet> base.
+     * \details Dequeued packets leave through DoDequeue, removed and evicted ones through
+     * DoRemove, so the base counts them as sent or dropped and fires the matching traces.
+     */
+    void DiffServ::Unmirror(Ptr<const Packet> pkt, bool dropped)
+    {
+        auto position = positions.find(PeekPointer(pkt));
+        if (position == positions.end())
+        {
+            return;
+        }
+
+        if (dropped)
+        {
+            Queue<Packet>::DoRemove(position->second);
+        }
+        else
+        {
+            Queue<Packet>::DoDequeue(position->second);
+        }
+        positions.erase(position);
+    }
+
+    /**
+     * \brief Setter for the gate control list.
+     */
+    void DiffServ::SetGateControlList(GateControlList* list)
+    {
+        Simulator::Cancel(gateEvent);
+        gateControlList = list;
+
+        // Without a release callback the gates stay open (DoEnqueue starts them once one is set)
+        if (gateControlList && !releaseCallback.IsNull())
+        {
+            UpdateGates();
+            return;
+        }
+
+        // Open every gate again
+        uint64_t closed = ~gateStates;
+        gateStates = ~uint64_t(0);
+        for (; closed; closed &= closed - 1)
+        {
+            uint32_t index = __builtin_ctzll(closed);
+            if (index < q_class.size())
+            {
+                NotifyQueueChanged(index);
+            }
+        }
+    }
+
+    /**
+     * \brief Getter for the gate control list.
+     */
+    GateControlList* DiffServ::GetGateControlList() const
+    {
+        return gateControlList;
+    }
+
+    /**
+     * \brief Checks the gate of a class in the current gate states.
+     */
+    bool DiffServ::IsGateOpen(uint32_t index) const
+    {
+        return index >= 64 || ((gateStates >> index) & 1);
+    }
+
+    /**
+     * \brief Applies the gate states of the list at the current time.
+     * \details Only the classes whose gate changed are notified. The next change is computed from
+     * the list, so the gates cost one event per change and nothing in between.
+     */
+    bool DiffServ::UpdateGates()
+    {
+        Time now = Simulator::Now();
+        Time next;
+        uint64_t states = gateControlList->GetGateStates(now, next);
+        uint64_t changed = states ^ gateStates;
+        gateStates = states;
+
+        bool opened = false;
+        for (; changed; changed &= changed - 1)
+        {
+            uint32_t index = __builtin_ctzll(changed);
+            if (index < q_class.size())
+            {
+                NotifyQueueChanged(index);
+                opened = opened || IsBacklogged(index);
+            }
+        }
+
+        if (next != Time::Max())
+        {
+            gateEvent = Simulator::Schedule(next - now, &DiffServ::GateTransition, this);
+        }
+
+        return opened;
+    }
+
+    /**
+     * \brief Applies a gate change, unless nothing is queued behind the gates.
+     * \details With no packet queued no class can become eligible, so the events stop and the
+     * next enqueue picks the list up again at its current position.
+     */
+    void DiffServ::GateTransition()
+    {
+        if (IsEmpty())
+        {
+            return;
+        }
+
+        if (UpdateGates())
+        {
+            releaseCallback();
+        }
+    }
+
+    /**
+     * \brief Takes the head-of-line packet out of the shaper of a queue about to be popped.
+     * \note Runs before the pop, so the queue change notification sees the updated bucket.
+     */
+    void DiffServ::ChargeShaper(uint32_t index)
+    {
+        TrafficShaper* shaper = q_class[index]->GetShaper();
+        if (shaper && !q_class[index]->IsEmpty())
+        {
+            shaper->Consume(q_class[index]->Peek()->GetSize(), Simulator::Now());
+        }
+    }
+
+    /**
+     * \brief Setter for the release callback.
+     */
+    void DiffServ::SetReleaseCallback(Callback<void> callback)
+    {
+        releaseCallback = callback;
+    }
+
+    /**
+     * \brief Setter for the drop callback.
+     */
+    void DiffServ::SetDropCallback(Callback<void, Ptr<const Packet>> callback)
+    {
+        dropCallback = callback;
+    }
+
+    /**
+     * \brief Default commit step. Stateless schedulers have nothing to commit.
+     */
+    void DiffServ::CommitSchedule(uint32_t index)
+    {
+    }
+
+    /**
+     * \brief Default queue change notification. Stateless schedulers ignore it.
+     */
+    void DiffServ::NotifyQueueChanged(uint32_t index)
+    {
+    }
+
+    /**
+     * \brief Default enqueue notification. Schedulers without per-packet state ignore it.
+     */
+    void DiffServ::NotifyEnqueued(uint32_t index, Ptr<const Packet> pkt)
+    {
+    }
 
     /**
      * \brief Peeks at the next packet in the queue without removing it.
@@ -132,28 +612,409 @@ namespace ns3 {
      */
     uint32_t DiffServ::Classify(Ptr<Packet> pkt)
     {
-        // Set the default index to an invalid value
-        constexpr uint32_t NO_QUEUE = std::numeric_limits<uint32_t>::max();
-        uint32_t defaultIndex = NO_QUEUE;
+        // Parse the packet headers once, every filter element works from this view
+        return Classify(FlowKey::Parse(pkt));
+    }
+
+    /**
+     * \brief Classifies a parsed packet based on its traffic class.
+     * \details Packets of a flow seen recently are answered from the flow cache with one hash
+     * probe. Otherwise the packet goes through the classifier rules and the result is cached.
+     */
+    uint32_t DiffServ::Classify(const FlowKey& key)
+    {
+        // Pick up new classes or filters (this also empties the flow cache)
+        if (classifierDirty)
+        {
+            BuildClassifier();
+        }
+
+        // Classes keyed purely by DSCP: one table read, cheaper than even the flow cache
+        if (dscpOnly)
+        {
+            uint32_t index = key.hasIpv4 ? dscpTable[key.dscp & (DSCP_COUNT - 1)] : dscpNoIpv4;
+            if (index != NO_QUEUE)
+            {
+                return index;
+            }
+
+            NS_LOG_UNCOND("Falling back to default queue: " << defaultQueue);
+            return defaultQueue;
+        }
+
+        // Only packets with an IPv4 header have a 5-tuple to cache
+        uint32_t index;
+        if (key.hasIpv4 && flowCache.Lookup(key, index))
+        {
+            return index;
+        }
+
+        index = MatchRules(key);
+
+        if (key.hasIpv4)
+        {
+            flowCache.Insert(key, index);
+        }
+
+        return index;
+    }
+
+    /**
+     * \brief Runs a parsed packet through the classifier rules of the selected mode.
+     * \returns The index of the matching queue, or the default queue.
+     */
+    uint32_t DiffServ::MatchRules(const FlowKey& key)
+    {
+        uint32_t index = NO_QUEUE;
+
+        switch (classifierMode)
+        {
+            case CLASSIFIER_LINEAR:
+                index = MatchLinear(key);
+                break;
+
+            case CLASSIFIER_DECISION_TREE:
+                // The tree holds every rule but the subnet filters, which resolve by longest prefix
+                index = std::min(decisionTree.Lookup(key), MatchPrefixes(key));
+                break;
+
+            default:
+                index = MatchIndexed(key);
+                break;
+        }
+
+        if (index != NO_QUEUE)
+        {
+            return index;
+        }
+
+        NS_LOG_UNCOND("Falling back to default queue: " << defaultQueue);
+        return defaultQueue;
+    }
+
+    /**
+     * \brief Runs a parsed packet through the indexed classifier.
+     * \details The result is the first registered class with a matching filter, as if every
+     * class were checked in order. Exact-match filters are answered by one hash probe per
+     * indexed field. Subnet filters are answered by a longest-prefix lookup per direction, so
+     * among overlapping subnets the most specific one speaks for that direction. Multi-field
+     * filters are answered by a tuple space search with one probe per rule shape. Only the
+     * remaining filters of classes ahead of the best hit are checked one by one. The same
+     * FlowKey is shared by every filter, so the packet is parsed only once.
+     * \returns The index of the matching queue, or NO_QUEUE.
+     */
+    uint32_t DiffServ::MatchIndexed(const FlowKey& key) const
+    {
+        // Best class among the indexed rules, and the most specific subnet rule in each direction
+        uint32_t index = std::min(exactMatchIndex.Lookup(key), MatchPrefixes(key));
+
+        // Multi-field rules, probing only the tuples that can still beat the current hit
+        index = std::min(index, tupleSpace.Lookup(key, index));
+
+        // A non-indexed rule can only win if its class comes first
+        for (const auto& rule : linearRules)
+        {
+            if (rule.first >= index)
+            {
+                break;
+            }
+
+            if (rule.second == nullptr || rule.second->Match(key))
+            {
+                return rule.first;
+            }
+        }
+
+        return index;
+    }
+
+    /**
+     * \brief Checks every class in order, the reference the other modes must agree with.
+     * \details Subnet filters are first matched by brute force to find the longest prefix covering
+     * the packet in each direction (the first class among equally long ones). A subnet filter then
+     * only counts for the class holding that prefix, and every other filter counts as usual.
+     * \returns The index of the matching queue, or NO_QUEUE.
+     */
+    uint32_t DiffServ::MatchLinear(const FlowKey& key) const
+    {
+        uint32_t longest[2] = {NO_QUEUE, NO_QUEUE};
+        int32_t lengths[2] = {-1, -1};
+        if (key.hasIpv4)
+        {
+            for (const SubnetRule& rule : subnetRules)
+            {
+                uint32_t direction = rule.field == FlowField::SOURCE_ADDRESS ? 0 : 1;
+                uint32_t address = direction == 0 ? key.sourceAddress.Get() : key.destinationAddress.Get();
+                uint32_t mask = rule.length == 0 ? 0 : ~uint32_t(0) << (32 - rule.length);
+                if ((address & mask) == rule.prefix && rule.length > lengths[direction])
+                {
+                    lengths[direction] = rule.length;
+                    longest[direction] = rule.classIndex;
+                }
+            }
+        }
 
         for (uint32_t i = 0; i < q_class.size(); ++i)
         {
-            // Check if the packet matches the traffic class
-            // If it does, return the index of the traffic class
-            if (q_class[i]->Match(pkt))
+            if (longest[0] == i || longest[1] == i || q_class[i]->GetFilters().empty())
             {
                 return i;
             }
 
-            // If the packet doesn't match any class, check if it's the default class
+            FlowField field;
+            uint32_t prefix;
+            uint8_t length;
+            for (const Filter* filter : q_class[i]->GetFilters())
+            {
+                if (!GetSubnetRule(filter, field, prefix, length) && filter->Match(key))
+                {
+                    return i;
+                }
+            }
+        }
+
+        return NO_QUEUE;
+    }
+
+    /**
+     * \brief Looks the packet's addresses up in the prefix tries.
+     * \returns The lower class of the longest source and destination prefixes, or NO_QUEUE.
+     */
+    uint32_t DiffServ::MatchPrefixes(const FlowKey& key) const
+    {
+        if (!key.hasIpv4)
+        {
+            return NO_QUEUE;
+        }
+
+        return std::min(sourcePrefixes.Lookup(key.sourceAddress.Get()), destinationPrefixes.Lookup(key.destinationAddress.Get()));
+    }
+
+    /**
+     * \brief Describes a filter made of one SourceMask or DestinationMask element with a contiguous mask.
+     * \returns false for any other filter.
+     */
+    bool DiffServ::GetSubnetRule(const Filter* filter, FlowField& field, uint32_t& prefix, uint8_t& length)
+    {
+        const std::vector<FilterElement*>& elements = filter->GetFilterElements();
+        return elements.size() == 1 && elements[0]->GetPrefixMatch(field, prefix, length);
+    }
+
+    /**
+     * \brief Rebuilds the classifier of the selected mode from the filters of the registered classes.
+     * \details In the indexed mode a single-element filter is indexed when the element describes
+     * itself as an exact match on a header field or as a contiguous address prefix, and a
+     * multi-element filter goes in the tuple space when every element can be described that way.
+     * In the decision tree mode the subnet filters go in the prefix tries as well and every other
+     * filter is compiled into the tree; the linear mode only lists the subnet filters. A rule set made only of
+     * single DSCP matches is answered by the DSCP table in both modes. The default queue is the
+     * last registered class marked as default.
+     */
+    void DiffServ::BuildClassifier()
+    {
+        exactMatchIndex.Clear();
+        sourcePrefixes.Clear();
+        destinationPrefixes.Clear();
+        tupleSpace.Clear();
+        linearRules.clear();
+        subnetRules.clear();
+        defaultQueue = NO_QUEUE;
+
+        // Cached results may no longer hold
+        flowCache.Invalidate();
+
+        // Every rule in class order; a class without filters matches everything
+        std::vector<std::pair<uint32_t, const Filter*>> rules;
+        for (uint32_t i = 0; i < q_class.size(); ++i)
+        {
             if (q_class[i]->GetIsDefault())
             {
-                defaultIndex = i;
+                defaultQueue = i;
+            }
+
+            if (q_class[i]->GetFilters().empty())
+            {
+                rules.emplace_back(i, nullptr);
+            }
+
+            for (const Filter* filter : q_class[i]->GetFilters())
+            {
+                rules.emplace_back(i, filter);
             }
         }
 
-        NS_LOG_UNCOND("Falling back to default queue: " << defaultIndex);
-        return defaultIndex;
+        // Pure DSCP rule sets need no other structure
+        dscpOnly = classifierMode != CLASSIFIER_LINEAR && BuildDscpTable(rules);
+        if (dscpOnly)
+        {
+            classifierDirty = false;
+            return;
+        }
+
+        // Subnet filters resolve by longest prefix in every mode
+        FlowField field;
+        uint32_t value;
+        uint8_t length;
+        if (classifierMode != CLASSIFIER_INDEXED)
+        {
+            std::vector<std::pair<uint32_t, const Filter*>> treeRules;
+            for (const auto& rule : rules)
+            {
+                if (rule.second == nullptr || !GetSubnetRule(rule.second, field, value, length))
+                {
+                    treeRules.push_back(rule);
+                }
+                else if (classifierMode == CLASSIFIER_LINEAR)
+                {
+                    subnetRules.push_back({rule.first, field, value, length});
+                }
+                else
+                {
+                    PrefixTrie& trie = field == FlowField::SOURCE_ADDRESS ? sourcePrefixes : destinationPrefixes;
+                    trie.Insert(value, length, rule.first);
+                }
+            }
+
+            if (classifierMode == CLASSIFIER_DECISION_TREE)
+            {
+                decisionTree.Build(treeRules);
+            }
+        }
+        else
+        {
+            for (const auto& rule : rules)
+            {
+                if (rule.second == nullptr)
+                {
+                    linearRules.push_back(rule);
+                    continue;
+                }
+
+                const std::vector<FilterElement*>& elements = rule.second->GetFilterElements();
+
+                std::vector<TupleSpace::FieldMask> tests;
+                if (elements.size() == 1 && elements[0]->GetExactMatch(field, value))
+                {
+                    exactMatchIndex.Insert(field, value, rule.first);
+                }
+                else if (elements.size() == 1 && elements[0]->GetPrefixMatch(field, value, length))
+                {
+                    PrefixTrie& trie = field == FlowField::SOURCE_ADDRESS ? sourcePrefixes : destinationPrefixes;
+                    trie.Insert(value, length, rule.first);
+                }
+                else if (elements.size() > 1 && DescribeFilter(rule.second, tests))
+                {
+                    tupleSpace.Insert(tests, rule.first);
+                }
+                else
+                {
+                    linearRules.push_back(rule);
+                }
+            }
+        }
+
+        classifierDirty = false;
+    }
+
+    /**
+     * \brief Fills the DSCP table for rule sets keyed purely by DSCP.
+     * \details Rules come in class order, so the first class to claim a codepoint keeps it and the
+     * table gives the same answer as a first-match walk. A class without filters claims every
+     * codepoint still free. At least one DSCP rule is required, otherwise the other structures
+     * are just as cheap.
+     * \returns false (leaving the table unused) if any rule tests something besides the DSCP.
+     */
+    bool DiffServ::BuildDscpTable(const std::vector<std::pair<uint32_t, const Filter*>>& rules)
+    {
+        dscpTable.fill(NO_QUEUE);
+        dscpNoIpv4 = NO_QUEUE;
+        bool hasDscpRule = false;
+
+        for (const auto& rule : rules)
+        {
+            if (rule.second == nullptr)
+            {
+                for (uint32_t& entry : dscpTable)
+                {
+                    if (entry == NO_QUEUE)
+                    {
+                        entry = rule.first;
+                    }
+                }
+
+                if (dscpNoIpv4 == NO_QUEUE)
+                {
+                    dscpNoIpv4 = rule.first;
+                }
+                continue;
+            }
+
+            const std::vector<FilterElement*>& elements = rule.second->GetFilterElements();
+
+            FlowField field;
+            uint32_t value;
+            if (elements.size() != 1 || !elements[0]->GetExactMatch(field, value) || field != FlowField::DSCP)
+            {
+                return false;
+            }
+
+            hasDscpRule = true;
+
+            // A codepoint above 63 can never be carried in the ToS field
+            if (value < DSCP_COUNT && dscpTable[value] == NO_QUEUE)
+            {
+                dscpTable[value] = rule.first;
+            }
+        }
+
+        return hasDscpRule;
+    }
+
+    /**
+     * \brief Describes a multi-element filter as field tests for the tuple space.
+     * \details Exact elements test the whole field, prefix elements test the masked address.
+     * \returns false if an element cannot be described or two elements test the same field.
+     */
+    bool DiffServ::DescribeFilter(const Filter* filter, std::vector<TupleSpace::FieldMask>& tests)
+    {
+        for (const FilterElement* element : filter->GetFilterElements())
+        {
+            TupleSpace::FieldMask test;
+            uint8_t length;
+            if (element->GetExactMatch(test.field, test.value))
+            {
+                test.mask = std::numeric_limits<uint32_t>::max();
+            }
+            else if (element->GetPrefixMatch(test.field, test.value, length))
+            {
+                test.mask = length == 0 ? 0 : std::numeric_limits<uint32_t>::max() << (32 - length);
+            }
+            else
+            {
+                return false;
+            }
+
+            // A tuple has one test per field
+            for (const TupleSpace::FieldMask& other : tests)
+            {
+                if (other.field == test.field)
+                {
+                    return false;
+                }
+            }
+
+            tests.push_back(test);
+        }
+
+        return true;
+    }
+
+    /**
+     * \brief Marks the classifier for a rebuild after a registered class gained a filter.
+     */
+    void DiffServ::NotifyClassifierChanged()
+    {
+        classifierDirty = true;
     }
 
     /**
@@ -162,5 +1023,15 @@ namespace ns3 {
     void DiffServ::RegisterQueue(TrafficClass* trafficClass)
     {
         q_class.push_back(trafficClass);
+
+        // Keep the shaper hold and the scheduler in sync with enqueues and removals on this class
+        held.push_back(false);
+        releaseEvents.emplace_back();
+        trafficClass->SetQueueChangedCallback(MakeCallback(&DiffServ::QueueChanged, this), q_class.size() - 1);
+        trafficClass->SetDropCallback(MakeCallback(&DiffServ::NotifyDropped, this));
+
+        // Rebuild the classifier on the next packet, and again whenever the class gains a filter
+        trafficClass->SetClassifierChangedCallback(MakeCallback(&DiffServ::NotifyClassifierChanged, this));
+        classifierDirty = true;
     }
 } // namespace ns3
\ No newline at end of file
@@ -2,10 +2,22 @@
 #define DIFF_SERV_H
 
 #include <vector>
+#include <array>
+#include <unordered_map>
+#include <limits>
 #include "ns3/log.h"
 #include "ns3/packet.h"
 #include "traffic-class.h"
+#include "flow-key.h"
+#include "exact-match-index.h"
+#include "prefix-trie.h"
+#include "flow-cache.h"
+#include "tuple-space.h"
+#include "decision-tree.h"
+#include "gate-control-list.h"
 #include "ns3/queue.h"
+#include "ns3/event-id.h"
+#include "ns3/callback.h"
 
 namespace ns3 {
     /**
@@ -25,7 +37,7 @@ namespace ns3 {
              * \brief Destructor for DiffServ class.
              * \details Cleans up the DiffServ class and releases resources.
              */
-            virtual ~DiffServ() = default;
+            virtual ~DiffServ();
 
             /**
              * \brief Add a queue to the DiffServ class.
@@ -65,15 +77,328 @@ namespace ns3 {
              */
             virtual uint32_t Classify(Ptr<Packet> pkt);
 
+            /**
+             * \brief Classify a packet from its parsed header view.
+             * \param key The header fields parsed once from the packet.
+             * \returns The index of the matching queue, or the default queue.
+             */
+            virtual uint32_t Classify(const FlowKey& key);
+
             /**
              * \brief Schedule the next packet to be sent.
              * \returns The scheduled packet.
              */
             virtual Ptr<const Packet> Schedule() const = 0;
 
+            /**
+             * \brief Select the queue whose head-of-line packet Schedule() would serve.
+             * \returns The index into q_class, or NO_QUEUE if nothing is scheduled.
+             * \note Dequeue and Remove pop this queue directly, so the scheduled packet is never
+             * classified a second time. The default looks the result of Schedule() up among the
+             * queue heads; SPQ and DRR override it to return the index they already computed.
+             */
+            virtual uint32_t ScheduleQueue() const;
+
+            /**
+             * \brief Enable the shared-buffer mode.
+             * \param poolSize Size of the pool every class draws from, in packets or bytes.
+             * A zero-valued size turns the mode off again.
+             * \details In shared-buffer mode a class admits a packet only while its occupancy is
+             * below Alpha * (pool - occupancy of all classes), i.e. the Choudhury-Hahne dynamic
+             * threshold. A busy class can absorb a burst into the free space while the others
+             * are idle, and the threshold shrinks as the pool fills so it never locks the others out.
+             * The per-class MaxPackets / MaxBytes limits still apply as hard caps.
+             */
+            void SetSharedBuffer(QueueSize poolSize);
+            QueueSize GetSharedBuffer() const;
+
+            /**
+             * \brief How Classify runs a packet through the filters when the flow cache misses.
+             * CLASSIFIER_INDEXED (default): hash index, prefix tries and tuple space, linear for the rest.
+             * CLASSIFIER_DECISION_TREE: a HiCuts-style tree compiled from every filter, with small linear leaves.
+             * CLASSIFIER_LINEAR: check every class in order (the reference behavior).
+             * \note Every mode is first-match in class order, except among subnet filters (a filter made
+             * of one SourceMask or DestinationMask element with a contiguous mask): of the subnet
+             * filters of one direction that cover the packet only the longest prefix counts, so a
+             * narrower subnet wins over a broader one registered earlier. All modes agree on this.
+             */
+            enum ClassifierMode
+            {
+                CLASSIFIER_INDEXED,
+                CLASSIFIER_DECISION_TREE,
+                CLASSIFIER_LINEAR
+            };
+
+            /**
+             * \brief Set the callback run when a held class becomes eligible again.
+             * \param callback Called from the release event of a shaper or at a gate opening on a
+             * backlogged class; the owner dequeues again (DiffServQueueDisc runs the queue disc).
+             * \details Shapers and gates hold packets back, so Dequeue may return nothing while
+             * packets are queued. Only an owner that comes back on this callback can cope with that:
+             * a device pulls from its queue right after a Send on an idle link and would find
+             * nothing. Without a release callback the DiffServ therefore never holds a class, i.e.
+             * shapers and gate control lists are ignored, and it can be a device queue. With one it
+             * must be driven through a DiffServQueueDisc.
+             */
+            void SetReleaseCallback(Callback<void> callback);
+
+            /**
+             * \brief Set the callback run for a queued packet a class drops to admit another one.
+             * \details Flow sub-queues may evict the oldest packet of the longest flow when the class
+             * is full; owners that track queued packets (DiffServQueueDisc) are told through this.
+             */
+            void SetDropCallback(Callback<void, Ptr<const Packet>> callback);
+
+            /**
+             * \brief Gate the classes with a time-aware (IEEE 802.1Qbv) gate control list.
+             * \param gateControlList The list (nullptr opens every gate again). Bit i of an entry
+             * is the gate of the i-th registered class; classes past the 64th are never gated.
+             * \details A class behind a closed gate is not eligible, so the scheduler picks among
+             * the open gates as usual (strict priority under SPQ). One Simulator event runs at
+             * each gate change while packets are queued, notifies only the classes whose gate
+             * changed, and runs the release callback when a gate opens on a backlogged class.
+             * The gates only act while a release callback is set (see SetReleaseCallback).
+             */
+            void SetGateControlList(GateControlList* gateControlList);
+            GateControlList* GetGateControlList() const;
+
+            /**
+             * \brief Check if the gate of a class is open (always true without a gate control list).
+             */
+            bool IsGateOpen(uint32_t index) const;
+
+            void SetClassifierMode(ClassifierMode mode);
+            ClassifierMode GetClassifierMode() const;
+
+            /**
+             * \brief Size the flow cache used by Classify.
+             * \param entries Number of cached flows (rounded up to a power of two); 0 disables it.
+             */
+            void SetFlowCacheSize(uint32_t entries);
+
+            /**
+             * \brief Flow cache counters, for sizing the cache.
+             */
+            uint64_t GetFlowCacheHits() const;
+            uint64_t GetFlowCacheMisses() const;
+
+            // Default number of flows remembered by the classifier
+            static constexpr uint32_t DEFAULT_FLOW_CACHE_SIZE = 1024;
+
+            // Number of DSCP codepoints (6 bits of the IPv4 ToS field)
+            static constexpr uint32_t DSCP_COUNT = 64;
+
+            // Queue index returned when no queue matches or none is scheduled
+            static constexpr uint32_t NO_QUEUE = std::numeric_limits<uint32_t>::max();
+
         protected:
             std::vector<TrafficClass*> q_class;
 
+            /**
+             * \brief Check if a queue may be served now: it is non-empty, not held by its shaper and its gate is open.
+             * \note Schedulers use this instead of IsEmpty() to track their backlogged queues.
+             */
+            bool IsBacklogged(uint32_t index) const;
+
+            /**
+             * \brief Lift the QueueBase "MaxSize" default once the attributes are set.
+             * \details The classes' own limits bound the scheduler unless MaxSize is set afterwards.
+             */
+            void NotifyConstructionCompleted() override;
+
+            /**
+             * \brief Check a packet against the aggregate "MaxSize" limit, in packets or bytes.
+             * \returns true if the packet fits.
+             */
+            bool FitsAggregateLimit(Ptr<const Packet> pkt) const;
+
+            // Shared pool size (a zero value means every class only uses its own limits)
+            QueueSize sharedBuffer;
+
+            /**
+             * \brief Check a packet against the shared pool and the class's dynamic threshold.
+             * \param index The class the packet was classified into.
+             * \returns true if the packet is admitted (or the shared-buffer mode is off).
+             */
+            bool FitsSharedBuffer(uint32_t index, Ptr<const Packet> pkt) const;
+
+            // Classifier, rebuilt lazily after RegisterQueue, SetClassifierMode, or AddFilter / SetIsDefault
+            // on a registered class. In the indexed mode filters made of one exact-match element live in the hash index, filters made of one
+            // SourceMask / DestinationMask element live in the prefix trie of their direction, and
+            // filters made of several exact or prefix elements on different fields live in the tuple
+            // space. Every other filter (and every class without filters, which matches everything)
+            // is kept in linearRules in class order with a null Filter standing for "match everything".
+            // The decision tree mode keeps its subnet filters in the prefix tries too.
+            bool classifierDirty = true;
+            ExactMatchIndex exactMatchIndex;
+            PrefixTrie sourcePrefixes;
+            PrefixTrie destinationPrefixes;
+            TupleSpace tupleSpace;
+            ClassifierMode classifierMode = CLASSIFIER_INDEXED;
+            DecisionTree decisionTree;
+            std::vector<std::pair<uint32_t, const Filter*>> linearRules;
+            uint32_t defaultQueue = NO_QUEUE;
+
+            // Subnet filters in class order, matched by brute force in the linear mode (the other
+            // modes keep them in the prefix tries)
+            struct SubnetRule
+            {
+                uint32_t classIndex;
+                FlowField field;
+                uint32_t prefix;
+                uint8_t length;
+            };
+            std::vector<SubnetRule> subnetRules;
+
+            // DSCP fast path, used when every filter is a single DscpFilterElement (and the mode is not
+            // linear). dscpTable maps each codepoint to the first class that takes it, and dscpNoIpv4
+            // is the first class without filters (the only kind that matches a packet without IPv4).
+            // Classify then costs one array read and skips the rules and the flow cache.
+            bool dscpOnly = false;
+            std::array<uint32_t, DSCP_COUNT> dscpTable;
+            uint32_t dscpNoIpv4 = NO_QUEUE;
+
+            // Recently classified flows (invalidated whenever the classifier is rebuilt)
+            FlowCache flowCache{DEFAULT_FLOW_CACHE_SIZE};
+
+            /**
+             * \brief Run the packet through the classifier rules (no flow cache).
+             * \returns The index of the matching queue, or the default queue.
+             */
+            uint32_t MatchRules(const FlowKey& key);
+
+            /**
+             * \brief Run the packet through the hash index, prefix tries, tuple space and linear rules.
+             * \returns The index of the matching queue, or NO_QUEUE.
+             */
+            uint32_t MatchIndexed(const FlowKey& key) const;
+
+            /**
+             * \brief Check every class in order, resolving overlapping subnet filters by longest prefix.
+             * \returns The index of the matching queue, or NO_QUEUE.
+             */
+            uint32_t MatchLinear(const FlowKey& key) const;
+
+            /**
+             * \brief Longest-prefix subnet rule covering the packet in each direction, from the prefix tries.
+             * \returns The lower class of the two, or NO_QUEUE.
+             */
+            uint32_t MatchPrefixes(const FlowKey& key) const;
+
+            /**
+             * \brief Check if a filter is a subnet filter (one SourceMask or DestinationMask element with a contiguous mask).
+             */
+            static bool GetSubnetRule(const Filter* filter, FlowField& field, uint32_t& prefix, uint8_t& length);
+
+            /**
+             * \brief Describe a multi-element filter as one field test per header field.
+             * \returns false if an element cannot be described or two elements test the same field.
+             */
+            static bool DescribeFilter(const Filter* filter, std::vector<TupleSpace::FieldMask>& tests);
+
+            /**
+             * \brief Rebuild the classifier from the filters of the registered classes.
+             */
+            void BuildClassifier();
+
+            /**
+             * \brief Fill the DSCP table if every rule is a single DSCP match or matches everything.
+             * \param rules Every rule in class order (a null Filter matches everything).
+             * \returns true if the DSCP fast path can answer every packet.
+             */
+            bool BuildDscpTable(const std::vector<std::pair<uint32_t, const Filter*>>& rules);
+
+            /**
+             * \brief Called by a registered TrafficClass after AddFilter or SetIsDefault.
+             */
+            void NotifyClassifierChanged();
+
+            // Shaper state per queue: held while the shaper has no tokens for the head-of-line
+            // packet, with one pending release event per held queue
+            std::vector<bool> held;
+            std::vector<EventId> releaseEvents;
+
+            // Owner notifications: a held class became eligible, a queued packet was dropped
+            Callback<void> releaseCallback;
+            Callback<void, Ptr<const Packet>> dropCallback;
+
+            // Gate states of the gate control list (bit i for class i), and the pending gate
+            // change, scheduled only while packets are queued
+            GateControlList* gateControlList = nullptr;
+            uint64_t gateStates = ~uint64_t(0);
+            EventId gateEvent;
+
+            /**
+             * \brief Called by a registered TrafficClass after every enqueue or removal.
+             * \details Updates the shaper hold of the queue, then notifies the scheduler.
+             */
+            void QueueChanged(uint32_t index);
+
+            /**
+             * \brief Hold a shaped queue whose head-of-line packet has no tokens yet.
+             */
+            void UpdateShaper(uint32_t index);
+
+            /**
+             * \brief Release event of a held queue: make it eligible and run the release callback.
+             */
+            void ReleaseShaped(uint32_t index);
+
+            /**
+             * \brief Called by a registered TrafficClass for a queued packet it dropped.
+             */
+            void NotifyDropped(Ptr<const Packet> pkt);
+
+            /**
+             * \brief Take a packet that left its class out of the Queue<Packet> base.
+             * \param dropped true if the packet was removed or evicted rather than sent.
+             */
+            void Unmirror(Ptr<const Packet> pkt, bool dropped);
+
+            // The Queue<Packet> base holds every queued packet in arrival order, so its counters,
+            // GetCurrentSize() and the queue traces follow the classes. The classes decide the
+            // order; each queued packet maps to its position in the base container.
+            std::unordered_map<const Packet*, ConstIterator> positions;
+
+            /**
+             * \brief Apply the current gate states and schedule the next gate change.
+             * \returns true if a gate opened on a backlogged class.
+             */
+            bool UpdateGates();
+
+            /**
+             * \brief Gate change event. Stops the gate events once no packet is queued.
+             */
+            void GateTransition();
+
+            /**
+             * \brief Take the head-of-line packet of a queue about to be popped out of its shaper.
+             */
+            void ChargeShaper(uint32_t index);
+
+            /**
+             * \brief Commit the scheduling decision for the queue about to be popped.
+             * \param index The queue returned by ScheduleQueue().
+             * \note Called by DoDequeue/DoRemove before the packet is removed. Schedulers that keep
+             * round state (e.g. DRR) update it here so ScheduleQueue() itself stays free of side effects.
+             */
+            virtual void CommitSchedule(uint32_t index);
+
+            /**
+             * \brief Called by a registered TrafficClass after every enqueue or removal.
+             * \param index The index of the TrafficClass in q_class.
+             */
+            virtual void NotifyQueueChanged(uint32_t index);
+
+            /**
+             * \brief Called by DoEnqueue after a packet was admitted into a class.
+             * \param index The index of the TrafficClass in q_class.
+             * \param pkt The packet just queued.
+             * \note Runs after NotifyQueueChanged for the same enqueue. Schedulers that rank each
+             * packet on arrival (e.g. PIFO) compute the rank here.
+             */
+            virtual void NotifyEnqueued(uint32_t index, Ptr<const Packet> pkt);
+
             // Called by Queue<Packet>::Enqueue()
             bool DoEnqueue (Ptr<Packet> pkt);
 
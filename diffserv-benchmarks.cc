@@ -0,0 +1,290 @@
+#include "diffserv-benchmarks.h"
+#include "destination-port-number.h"
+#include "destination-mask.h"
+#include "source-mask.h"
+#include "protocol-number.h"
+#include "dscp-filter-element.h"
+#include "filter.h"
+#include "traffic-class.h"
+#include "spq.h"
+#include "drr.h"
+#include "pifo.h"
+#include "flow-key.h"
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/ppp-header.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("DiffservBenchmarks");
+
+DiffservBenchmarks::DiffservBenchmarks() {}
+
+/**
+ * \ingroup diffserv
+ * \brief Execute all Diffserv benchmarks and log the results.
+ */
+void
+DiffservBenchmarks::RunAll()
+{
+    NS_LOG_UNCOND("Running Diffserv Benchmarks...");
+
+    BenchClassifier();
+    BenchDscpClassifier();
+    BenchSchedulers();
+
+    NS_LOG_UNCOND("Benchmarks finished");
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Compare the classifier modes on an ACL-style rule set.
+ * \details 1000 classes each hold one filter made of a source subnet, a destination subnet and,
+ * for some, a destination port and a protocol, followed by a catch-all class. The same pre-parsed packets are classified in
+ * every mode with the flow cache disabled, so only the rule lookup is timed.
+ */
+void
+DiffservBenchmarks::BenchClassifier()
+{
+    NS_LOG_UNCOND("-- [BenchClassifier] --");
+
+    static constexpr uint32_t RULES = 1000;
+    static constexpr uint32_t PACKETS = 20000;
+    static constexpr uint32_t ROUNDS = 5;
+
+    std::mt19937 rng(1);
+    auto address = [&rng]() { return Ipv4Address(0x0a000000u | ((rng() % 16) << 16) | ((rng() % 16) << 8) | (rng() % 16)); };
+    auto port = [&rng]() { return static_cast<uint16_t>(1000 + rng() % 64); };
+    const char* masks[] = {"255.0.0.0", "255.255.0.0", "255.255.255.0", "255.255.255.255"};
+
+    std::vector<TrafficClass*> classes;
+    for (uint32_t i = 0; i < RULES; ++i)
+    {
+        Filter* filter = new Filter();
+        filter->AddFilterElement(new SourceMask(Ipv4Mask(masks[1 + rng() % 3]), address()));
+        filter->AddFilterElement(new DestinationMask(Ipv4Mask(masks[1 + rng() % 3]), address()));
+        if (i % 2 == 0)
+        {
+            filter->AddFilterElement(new DestinationPortNumber(port()));
+        }
+        if (i % 3 == 0)
+        {
+            filter->AddFilterElement(new ProtocolNumber(17));
+        }
+
+        TrafficClass* tc = new TrafficClass();
+        tc->AddFilter(filter);
+        classes.push_back(tc);
+    }
+
+    // Catch-all class last, so no packet falls back to the (logged) default path
+    classes.push_back(new TrafficClass());
+
+    // Pre-parse the packets so only classification is timed
+    std::vector<FlowKey> keys;
+    for (uint32_t n = 0; n < PACKETS; ++n)
+    {
+        Ptr<Packet> pkt = Create<Packet>(100);
+        UdpHeader udpHdr;
+        udpHdr.SetSourcePort(port());
+        udpHdr.SetDestinationPort(port());
+        Ipv4Header ipHdr;
+        ipHdr.SetSource(address());
+        ipHdr.SetDestination(address());
+        ipHdr.SetProtocol(17);
+        pkt->AddHeader(udpHdr);
+        pkt->AddHeader(ipHdr);
+        pkt->AddHeader(PppHeader());
+        keys.push_back(FlowKey::Parse(pkt));
+    }
+
+    struct Mode { const char* name; DiffServ::ClassifierMode mode; };
+    Mode modes[] = {
+        {"Linear       ", DiffServ::CLASSIFIER_LINEAR},
+        {"Indexed      ", DiffServ::CLASSIFIER_INDEXED},
+        {"DecisionTree ", DiffServ::CLASSIFIER_DECISION_TREE},
+    };
+
+    // A class can only be registered with one scheduler at a time, so re-register per mode
+    for (const Mode& mode : modes)
+    {
+        SPQ spq;
+        spq.SetFlowCacheSize(0);
+        spq.SetClassifierMode(mode.mode);
+        for (TrafficClass* tc : classes)
+        {
+            spq.RegisterQueue(tc);
+        }
+
+        // The first pass builds the classifier
+        uint64_t checksum = 0;
+        for (const FlowKey& key : keys)
+        {
+            checksum += spq.Classify(key);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t round = 0; round < ROUNDS; ++round)
+        {
+            for (const FlowKey& key : keys)
+            {
+                checksum += spq.Classify(key);
+            }
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+        NS_LOG_UNCOND("\t" << mode.name << ": " << elapsed.count() / (ROUNDS * PACKETS) << " ns/packet (checksum " << checksum << ")");
+    }
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Compare a linear walk with the DSCP table on classes keyed purely by DSCP.
+ * \details One class per codepoint (in random order) is followed by a catch-all class, and the
+ * packets carry random codepoints. The flow cache is disabled in both runs.
+ */
+void
+DiffservBenchmarks::BenchDscpClassifier()
+{
+    NS_LOG_UNCOND("-- [BenchDscpClassifier] --");
+
+    static constexpr uint32_t PACKETS = 20000;
+    static constexpr uint32_t ROUNDS = 5;
+
+    std::mt19937 rng(2);
+    std::vector<uint8_t> codepoints(DiffServ::DSCP_COUNT);
+    for (uint32_t dscp = 0; dscp < codepoints.size(); ++dscp)
+    {
+        codepoints[dscp] = dscp;
+    }
+    std::shuffle(codepoints.begin(), codepoints.end(), rng);
+
+    std::vector<TrafficClass*> classes;
+    for (uint8_t dscp : codepoints)
+    {
+        Filter* filter = new Filter();
+        filter->AddFilterElement(new DscpFilterElement(dscp));
+        TrafficClass* tc = new TrafficClass();
+        tc->AddFilter(filter);
+        classes.push_back(tc);
+    }
+    classes.push_back(new TrafficClass());
+
+    // Only the DSCP and the IPv4 flag matter to these rules
+    std::vector<FlowKey> keys(PACKETS);
+    for (FlowKey& key : keys)
+    {
+        key.hasIpv4 = true;
+        key.protocol = 17;
+        key.dscp = rng() % DiffServ::DSCP_COUNT;
+    }
+
+    struct Mode { const char* name; DiffServ::ClassifierMode mode; };
+    Mode modes[] = {
+        {"Linear       ", DiffServ::CLASSIFIER_LINEAR},
+        {"DscpTable    ", DiffServ::CLASSIFIER_INDEXED},
+    };
+
+    for (const Mode& mode : modes)
+    {
+        SPQ spq;
+        spq.SetFlowCacheSize(0);
+        spq.SetClassifierMode(mode.mode);
+        for (TrafficClass* tc : classes)
+        {
+            spq.RegisterQueue(tc);
+        }
+
+        // The first pass builds the classifier
+        uint64_t checksum = 0;
+        for (const FlowKey& key : keys)
+        {
+            checksum += spq.Classify(key);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t round = 0; round < ROUNDS; ++round)
+        {
+            for (const FlowKey& key : keys)
+            {
+                checksum += spq.Classify(key);
+            }
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+        NS_LOG_UNCOND("\t" << mode.name << ": " << elapsed.count() / (ROUNDS * PACKETS) << " ns/packet (checksum " << checksum << ")");
+    }
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Compare the PIFO engine with the dedicated SPQ and DRR schedulers.
+ * \details Every class keys on its own DSCP, so classification is one table read. Each class is
+ * kept backlogged: every dequeued packet is enqueued again, so one step is one enqueue and one
+ * dequeue at a constant occupancy.
+ */
+void
+DiffservBenchmarks::BenchSchedulers()
+{
+    NS_LOG_UNCOND("-- [BenchSchedulers] --");
+
+    static constexpr uint32_t BACKLOG = 16;
+    static constexpr uint32_t STEPS = 200000;
+
+    for (uint32_t classes : {4u, 64u})
+    {
+        NS_LOG_UNCOND("\t" << classes << " classes:");
+
+        Ptr<DiffServ> schedulers[] = {
+            CreateObject<SPQ>(),
+            CreateObject<DRR>(),
+            CreateObject<PIFO>(PIFO::RANK_PRIORITY),
+            CreateObject<PIFO>(PIFO::RANK_FAIR),
+        };
+        const char* names[] = {"SPQ          ", "DRR          ", "PIFO priority", "PIFO fair    "};
+
+        for (uint32_t s = 0; s < 4; ++s)
+        {
+            Ptr<DiffServ> scheduler = schedulers[s];
+            for (uint32_t i = 0; i < classes; ++i)
+            {
+                Filter* filter = new Filter();
+                filter->AddFilterElement(new DscpFilterElement(i));
+                TrafficClass* tc = new TrafficClass();
+                tc->AddFilter(filter);
+                tc->SetPriorityLevel(i);
+                tc->SetWeight(500 * (1 + i % 4));
+                tc->SetMaxPackets(BACKLOG);
+                scheduler->RegisterQueue(tc);
+            }
+
+            for (uint32_t n = 0; n < classes * BACKLOG; ++n)
+            {
+                Ptr<Packet> pkt = Create<Packet>(100 + n % 1000);
+                Ipv4Header ipHdr;
+                ipHdr.SetDscp(static_cast<Ipv4Header::DscpType>(n % classes));
+                ipHdr.SetProtocol(17);
+                pkt->AddHeader(UdpHeader());
+                pkt->AddHeader(ipHdr);
+                pkt->AddHeader(PppHeader());
+                scheduler->Enqueue(pkt);
+            }
+
+            uint64_t checksum = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t step = 0; step < STEPS; ++step)
+            {
+                Ptr<Packet> pkt = scheduler->Dequeue();
+                checksum += pkt->GetSize();
+                scheduler->Enqueue(pkt);
+            }
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+            NS_LOG_UNCOND("\t" << names[s] << ": " << elapsed.count() / STEPS << " ns/packet (checksum " << checksum << ")");
+        }
+    }
+}
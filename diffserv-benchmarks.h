@@ -0,0 +1,24 @@
+#ifndef DIFFSERV_BENCHMARKS_H
+#define DIFFSERV_BENCHMARKS_H
+
+#include "ns3/packet.h"
+
+namespace ns3 {
+
+class DiffservBenchmarks
+{
+  public:
+    DiffservBenchmarks();
+
+    // Run all the benchmarks
+    void RunAll();
+
+  private:
+    // Individual Benchmarks
+    void BenchClassifier();
+    void BenchDscpClassifier();
+    void BenchSchedulers();
+  };
+} // namespace ns3
+
+#endif // DIFFSERV_BENCHMARKS_H
@@ -6,6 +6,10 @@
 #include "source-port-number.h"
 #include "destination-port-number.h"
 #include "protocol-number.h"
+#include "dscp-filter-element.h"
+#include "traffic-conditioner.h"
+#include "traffic-shaper.h"
+#include "credit-based-shaper.h"
 #include "source-mask.h"
 #include "spq.h"
 #include "traffic-class.h"
@@ -16,11 +20,67 @@
 #include "ns3/internet-module.h"
 #include "ns3/ppp-header.h"
 #include "drr.h"
+#include "flow-key.h"
+#include "prefix-trie.h"
+#include "flow-cache.h"
+#include "decision-tree.h"
+#include "hierarchical-scheduler.h"
+#include "wf2q.h"
+#include "stfq.h"
+#include "stochastic-fair-queue.h"
+#include "rank-queue.h"
+#include "pifo.h"
+#include "edf.h"
+#include "pias.h"
+#include "gate-control-list.h"
+#include "diff-serv-queue-disc.h"
+#include <random>
 
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("DiffservTests");
 
+/**
+ * \brief Build a PPP/IPv4/UDP packet as it sits in the router's output queue.
+ */
+static Ptr<Packet>
+MakeUdpPacket(Ipv4Address source, Ipv4Address destination, uint16_t sourcePort, uint16_t destinationPort, uint32_t size = 100,
+              uint8_t dscp = 0)
+{
+    Ptr<Packet> pkt = Create<Packet>(size);
+    UdpHeader udpHdr;
+    udpHdr.SetSourcePort(sourcePort);
+    udpHdr.SetDestinationPort(destinationPort);
+    Ipv4Header ipHdr;
+    ipHdr.SetSource(source);
+    ipHdr.SetDestination(destination);
+    ipHdr.SetProtocol(17);  // UDP
+    ipHdr.SetDscp(static_cast<Ipv4Header::DscpType>(dscp));
+    pkt->AddHeader(udpHdr);
+    pkt->AddHeader(ipHdr);
+    pkt->AddHeader(PppHeader());
+    return pkt;
+}
+
+/**
+ * \brief Build an IPv4/UDP item as the traffic control layer hands it to the root queue disc.
+ */
+static Ptr<QueueDiscItem>
+MakeUdpItem(Ipv4Address source, Ipv4Address destination, uint16_t sourcePort, uint16_t destinationPort, uint32_t size = 100)
+{
+    Ptr<Packet> pkt = Create<Packet>(size);
+    UdpHeader udpHdr;
+    udpHdr.SetSourcePort(sourcePort);
+    udpHdr.SetDestinationPort(destinationPort);
+    pkt->AddHeader(udpHdr);
+    Ipv4Header ipHdr;
+    ipHdr.SetSource(source);
+    ipHdr.SetDestination(destination);
+    ipHdr.SetProtocol(17);  // UDP
+    ipHdr.SetPayloadSize(pkt->GetSize());
+    return Create<Ipv4QueueDiscItem>(pkt, Address(), 0x0800, ipHdr);
+}
+
 DiffservTests::DiffservTests() {}
 
 /**
@@ -44,10 +104,43 @@ DiffservTests::RunAll()
     if (TestDestinationMask())      ++passed; ++total;
     if (TestProtocolNumber())       ++passed; ++total;
     if (TestFilter())               ++passed; ++total;
+    if (TestFlowKey())              ++passed; ++total;
     if (TestTrafficClass())         ++passed; ++total;
+    if (TestTrafficClassRing())     ++passed; ++total;
+    if (TestByteLimits())           ++passed; ++total;
+    if (TestSharedBuffer())         ++passed; ++total;
+    if (TestExactMatchIndex())      ++passed; ++total;
+    if (TestPrefixTrie())           ++passed; ++total;
+    if (TestFlowCache())            ++passed; ++total;
+    if (TestTupleSpace())           ++passed; ++total;
+    if (TestDecisionTree())         ++passed; ++total;
+    if (TestDscpClassifier())       ++passed; ++total;
+    if (TestTrafficConditioner())   ++passed; ++total;
+    if (TestTrafficShaper())        ++passed; ++total;
     if (TestDiffServ())             ++passed; ++total;
     if (TestSPQ())                  ++passed; ++total;
+    if (TestSPQManyLevels())        ++passed; ++total;
     if (TestDRR())                  ++passed; ++total;
+    if (TestDRRPeekStability())     ++passed; ++total;
+    if (TestDRRWeightedShare())     ++passed; ++total;
+    if (TestHierarchicalScheduler()) ++passed; ++total;
+    if (TestWF2Q())                 ++passed; ++total;
+    if (TestSTFQ())                 ++passed; ++total;
+    if (TestFlowQueues())           ++passed; ++total;
+    if (TestRankQueue())            ++passed; ++total;
+    if (TestPIFO())                 ++passed; ++total;
+    if (TestEDF())                  ++passed; ++total;
+    if (TestPIAS())                 ++passed; ++total;
+    if (TestCreditBasedShaper())    ++passed; ++total;
+    if (TestGateControlList())      ++passed; ++total;
+    if (TestClassifierModesAgree()) ++passed; ++total;
+    if (TestDeviceQueueNeverHolds()) ++passed; ++total;
+    if (TestDiffServQueueDisc())    ++passed; ++total;
+    if (TestCreditBasedShaperInDebt()) ++passed; ++total;
+    if (TestGateClosedOnArrival())  ++passed; ++total;
+    if (TestPIFOFlowQueues())       ++passed; ++total;
+    if (TestEDFFlowQueueEviction()) ++passed; ++total;
+    if (TestPIFORankClamp())        ++passed; ++total;
 
     NS_LOG_UNCOND("\n-- Diffserv Tests Summary --");
     NS_LOG_UNCOND("Total tests run: " << total);
@@ -422,7 +515,7 @@ DiffservTests::TestFilter()
     {
     public:
         DummyElement(bool res) : m_res(res) {}
-        bool Match(Ptr<Packet>) const override { return m_res; }
+        bool Match(const FlowKey&) const override { return m_res; }
     private:
         bool m_res;
     };
@@ -452,6 +545,62 @@ DiffservTests::TestFilter()
     return true;
 }
 
+/**
+ * \ingroup diffserv
+ * \brief Test that FlowKey parses the header fields used by the filter elements.
+ * \returns true if addresses, protocol and ports are extracted correctly.
+ */
+bool
+DiffservTests::TestFlowKey()
+{
+    NS_LOG_UNCOND("-- [TestFlowKey] --");
+
+    Ptr<Packet> pkt = Create<Packet>(10);
+    UdpHeader udpHdr;
+    udpHdr.SetSourcePort(33333);
+    udpHdr.SetDestinationPort(3333);
+    Ipv4Header ipHdr;
+    ipHdr.SetSource(Ipv4Address("10.1.1.1"));
+    ipHdr.SetDestination(Ipv4Address("10.1.2.2"));
+    ipHdr.SetProtocol(17);
+    pkt->AddHeader(udpHdr);
+    pkt->AddHeader(ipHdr);
+    pkt->AddHeader(PppHeader());
+
+    FlowKey key = FlowKey::Parse(pkt);
+    if (!key.hasIpv4 || !key.hasPorts)
+    {
+        NS_LOG_UNCOND("\tFAILED: Headers were not parsed.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Headers parsed.");
+
+    if (key.sourceAddress != Ipv4Address("10.1.1.1") || key.destinationAddress != Ipv4Address("10.1.2.2") ||
+        key.protocol != 17 || key.sourcePort != 33333 || key.destinationPort != 3333)
+    {
+        NS_LOG_UNCOND("\tFAILED: Parsed fields mismatch.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Parsed fields correct.");
+
+    if (key.length != pkt->GetSize())
+    {
+        NS_LOG_UNCOND("\tFAILED: Parsed length mismatch.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Parsed length correct.");
+
+    FlowKey empty = FlowKey::Parse(Create<Packet>(10));
+    if (empty.hasIpv4)
+    {
+        NS_LOG_UNCOND("\tFAILED: Packet without headers parsed as IPv4.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Packet without headers rejected.");
+
+    return true;
+}
+
 /**
  * \ingroup diffserv
  * \brief Test basic TrafficClass operations.
@@ -535,115 +684,2808 @@ DiffservTests::TestTrafficClass()
 
 /**
  * \ingroup diffserv
- * \brief Test DiffServ enqueue, dequeue, and peek logic.
- * \returns true if operations succeed with dummy traffic class.
+ * \brief Test the TrafficClass packet ring across wrap-around, resizing and growth past the preallocation cap.
+ * \returns true if FIFO order and the packet limit hold.
  */
 bool
-DiffservTests::TestDiffServ()
+DiffservTests::TestTrafficClassRing()
 {
-    NS_LOG_UNCOND("-- [TestDiffServ] --");
+    NS_LOG_UNCOND("-- [TestTrafficClassRing] --");
 
-    class DummyTC : public TrafficClass
+    TrafficClass tc;
+    tc.SetMaxPackets(5);
+
+    std::vector<Ptr<Packet>> sent;
+    for (uint32_t i = 0; i < 5; ++i)
     {
-    public:
-        bool Match(Ptr<Packet>) const  { return true; }
-        bool Enqueue(Ptr<Packet> p)  { m_p = p; return true; }
-        Ptr<Packet> Dequeue()  { return m_p; }
-        Ptr<const Packet> Peek() const { return m_p; }
-    private:
-        Ptr<Packet> m_p;
-    };
+        sent.push_back(Create<Packet>(i + 1));
+        tc.Enqueue(sent.back());
+    }
 
-    class TestDS : public DiffServ
+    if (tc.Enqueue(Create<Packet>(99)))
     {
-    public:
-        Ptr<const Packet> Schedule() const 
+        NS_LOG_UNCOND("\tFAILED: Enqueue beyond MaxPackets accepted.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: MaxPackets enforced.");
+
+    // Drain and refill a few times so the head wraps around the ring
+    uint32_t next = 0;
+    for (uint32_t round = 0; round < 20; ++round)
+    {
+        if (tc.Dequeue() != sent[next++])
         {
-            if (!m_pkt) m_pkt = Create<Packet>(30);
-            return m_pkt;
+            NS_LOG_UNCOND("\tFAILED: Packets left out of order.");
+            return false;
         }
-    private:
-        mutable Ptr<Packet> m_pkt;
-    };
+        sent.push_back(Create<Packet>(round + 10));
+        tc.Enqueue(sent.back());
+    }
 
-    Ptr<Packet> testPkt = Create<Packet>(42);
-    TestDS ds;
-    DummyTC* dtc = new DummyTC();
-    ds.RegisterQueue(dtc);
+    // Growing the limit keeps the queued packets in order
+    tc.SetMaxPackets(40);
+    while (!tc.IsEmpty())
+    {
+        if (tc.Dequeue() != sent[next++])
+        {
+            NS_LOG_UNCOND("\tFAILED: Packets out of order after resize.");
+            return false;
+        }
+    }
 
-    if (!ds.Enqueue(testPkt))
+    if (next != sent.size() || tc.GetNPackets() != 0)
     {
-        NS_LOG_UNCOND("\tFAILED: Enqueue in DiffServ.");
+        NS_LOG_UNCOND("\tFAILED: Packets lost.");
         return false;
     }
-    NS_LOG_UNCOND("\tPASSED: Enqueue in DiffServ.");
+    NS_LOG_UNCOND("\tPASSED: FIFO order kept across wrap-around and resize.");
 
-    Ptr<Packet> rd = ds.Dequeue();
-    if (!rd)
+    // An unbounded limit preallocates only the cap, then the ring doubles (here while wrapped)
+    TrafficClass unbounded;
+    unbounded.SetMaxPackets(std::numeric_limits<uint32_t>::max());
+    unbounded.Enqueue(Create<Packet>(1));
+    unbounded.Dequeue();
+
+    sent.clear();
+    for (uint32_t i = 0; i < TrafficClass::MAX_PREALLOCATED_PACKETS + 100; ++i)
     {
-        NS_LOG_UNCOND("\tFAILED: Dequeue in DiffServ.");
+        sent.push_back(Create<Packet>(1));
+        if (!unbounded.Enqueue(sent.back()))
+        {
+            NS_LOG_UNCOND("\tFAILED: Packet " << i << " refused below an unbounded limit.");
+            return false;
+        }
+    }
+    for (const Ptr<Packet>& pkt : sent)
+    {
+        if (unbounded.Dequeue() != pkt)
+        {
+            NS_LOG_UNCOND("\tFAILED: Packets out of order after growing the ring.");
+            return false;
+        }
+    }
+
+    // The flow sub-queues' slot pool grows the same way
+    TrafficClass flows;
+    StochasticFairQueue flowQueue(64, 300, Seconds(0));
+    flows.SetFlowQueue(&flowQueue);
+    flows.SetMaxPackets(std::numeric_limits<uint32_t>::max());
+    for (uint32_t i = 0; i < TrafficClass::MAX_PREALLOCATED_PACKETS + 100; ++i)
+    {
+        flows.Enqueue(Create<Packet>(1));
+    }
+    if (flows.GetNPackets() != TrafficClass::MAX_PREALLOCATED_PACKETS + 100)
+    {
+        NS_LOG_UNCOND("\tFAILED: Flow sub-queues hold " << flows.GetNPackets() << " packets.");
         return false;
     }
-    NS_LOG_UNCOND("\tPASSED: Dequeue in DiffServ.");
+    NS_LOG_UNCOND("\tPASSED: Unbounded limit grows on demand.");
 
-    Ptr<const Packet> pk = ds.Peek();
-    if (!pk)
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test the per-class byte limit and the aggregate MaxSize limit in both units.
+ * \returns true if the limits are enforced, released on dequeue and reported by the queue base.
+ */
+bool
+DiffservTests::TestByteLimits()
+{
+    NS_LOG_UNCOND("-- [TestByteLimits] --");
+
+    TrafficClass tc;
+    tc.SetMaxPackets(10);
+    tc.SetMaxBytes(2500);
+
+    tc.Enqueue(Create<Packet>(1000));
+    tc.Enqueue(Create<Packet>(1000));
+    if (tc.Enqueue(Create<Packet>(1000)) || tc.GetNBytes() != 2000)
     {
-        NS_LOG_UNCOND("\tFAILED: Peek in DiffServ.");
+        NS_LOG_UNCOND("\tFAILED: Enqueue beyond MaxBytes accepted.");
         return false;
     }
-    NS_LOG_UNCOND("\tPASSED: Peek in DiffServ.");
+    if (!tc.Enqueue(Create<Packet>(500)) || tc.GetNBytes() != 2500)
+    {
+        NS_LOG_UNCOND("\tFAILED: Packet that fits MaxBytes rejected.");
+        return false;
+    }
+    tc.Dequeue();
+    if (tc.GetNBytes() != 1500 || !tc.Enqueue(Create<Packet>(1000)))
+    {
+        NS_LOG_UNCOND("\tFAILED: Dequeue did not release the byte budget.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Per-class MaxBytes enforced.");
+
+    // Aggregate limit through the standard MaxSize attribute
+    SPQ spq;
+    TrafficClass low, high;
+    low.SetMaxPackets(10);
+    high.SetMaxPackets(10);
+    high.SetPriorityLevel(1);
+    spq.RegisterQueue(&low);
+    spq.RegisterQueue(&high);
+    spq.SetMaxSize(QueueSize(QueueSizeUnit::BYTES, 3000));
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        spq.Enqueue(Create<Packet>(1000));
+    }
+    if (spq.Enqueue(Create<Packet>(1)) || spq.GetNBytes() != 3000 || spq.GetNPackets() != 3)
+    {
+        NS_LOG_UNCOND("\tFAILED: Enqueue beyond the aggregate byte limit accepted.");
+        return false;
+    }
+    spq.Dequeue();
+    if (spq.GetNBytes() != 2000 || !spq.Enqueue(Create<Packet>(1000)))
+    {
+        NS_LOG_UNCOND("\tFAILED: Dequeue did not release the aggregate byte budget.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Aggregate byte limit enforced.");
+
+    // The Queue<Packet> base follows the classes
+    if (spq.GetCurrentSize().GetValue() != 3000 || spq.GetNPackets() != 3 || spq.GetTotalDroppedPackets() != 1)
+    {
+        NS_LOG_UNCOND("\tFAILED: Base reports " << spq.GetCurrentSize().GetValue() << " bytes in "
+                      << spq.GetNPackets() << " packets and " << spq.GetTotalDroppedPackets() << " drops.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Occupancy reported through the Queue<Packet> base.");
+
+    // No aggregate limit by default, and a packet-valued MaxSize is enforced as well
+    TrafficClass large;
+    large.SetMaxPackets(200);
+    Ptr<SPQ> counted = CreateObject<SPQ>();
+    counted->RegisterQueue(&large);
+    for (uint32_t i = 0; i < 150; ++i)
+    {
+        counted->Enqueue(Create<Packet>(100));
+    }
+    if (counted->GetNPackets() != 150)
+    {
+        NS_LOG_UNCOND("\tFAILED: Default MaxSize capped the scheduler at " << counted->GetNPackets() << " packets.");
+        return false;
+    }
+    counted->SetMaxSize(QueueSize(QueueSizeUnit::PACKETS, 151));
+    if (!counted->Enqueue(Create<Packet>(100)) || counted->Enqueue(Create<Packet>(100)) ||
+        counted->GetCurrentSize().GetValue() != 151 || large.GetNPackets() != 151)
+    {
+        NS_LOG_UNCOND("\tFAILED: Aggregate packet limit not enforced.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Aggregate packet limit enforced.");
 
     return true;
 }
 
 /**
  * \ingroup diffserv
- * \brief Test SPQ scheduling (highest priority first).
- * \returns true if SPQ schedules correctly.
+ * \brief Test the shared-buffer mode with dynamic thresholds.
+ * \returns true if each class is held to Alpha times the free space of the pool.
  */
 bool
-DiffservTests::TestSPQ()
+DiffservTests::TestSharedBuffer()
 {
-    NS_LOG_UNCOND("-- [TestSPQ] --");
+    NS_LOG_UNCOND("-- [TestSharedBuffer] --");
+
+    auto makePacket = [](uint16_t port) {
+        return MakeUdpPacket(Ipv4Address("10.1.1.1"), Ipv4Address("10.1.2.2"), 49153, port);
+    };
+
+    auto makeClass = [](uint16_t port, double alpha) {
+        Filter* filter = new Filter();
+        filter->AddFilterElement(new DestinationPortNumber(port));
+        TrafficClass* tc = new TrafficClass();
+        tc->SetMaxPackets(1000);
+        tc->SetAlpha(alpha);
+        tc->AddFilter(filter);
+        return tc;
+    };
+
+    auto fill = [&](SPQ& spq, uint16_t port) {
+        uint32_t accepted = 0;
+        while (spq.Enqueue(makePacket(port)))
+        {
+            ++accepted;
+        }
+        return accepted;
+    };
+
+    // Alpha 1: a lone class takes half the pool, the next one half of what is left
+    {
+        SPQ spq;
+        spq.RegisterQueue(makeClass(1111, 1.0));
+        spq.RegisterQueue(makeClass(2222, 1.0));
+        spq.SetSharedBuffer(QueueSize(QueueSizeUnit::PACKETS, 100));
+
+        uint32_t first = fill(spq, 1111);
+        uint32_t second = fill(spq, 2222);
+        if (first != 50 || second != 25)
+        {
+            NS_LOG_UNCOND("\tFAILED: Expected 50/25 packets admitted but got " << first << "/" << second);
+            return false;
+        }
+        NS_LOG_UNCOND("\tPASSED: Thresholds follow the free space of the pool.");
+    }
+
+    // Alpha 2: a lone class may use two thirds of the pool
+    {
+        SPQ spq;
+        spq.RegisterQueue(makeClass(1111, 2.0));
+        spq.SetSharedBuffer(QueueSize(QueueSizeUnit::PACKETS, 100));
+
+        uint32_t accepted = fill(spq, 1111);
+        if (accepted != 67)
+        {
+            NS_LOG_UNCOND("\tFAILED: Expected 67 packets admitted but got " << accepted);
+            return false;
+        }
+
+        // Draining frees space, so the class is admitted again
+        spq.Dequeue();
+        spq.Dequeue();
+        if (!spq.Enqueue(makePacket(1111)))
+        {
+            NS_LOG_UNCOND("\tFAILED: Dequeue did not free space in the pool.");
+            return false;
+        }
+        NS_LOG_UNCOND("\tPASSED: Alpha scales the class threshold.");
+    }
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test the exact-match classifier index against first-match semantics.
+ * \returns true if indexed and non-indexed rules resolve to the first matching class.
+ */
+bool
+DiffservTests::TestExactMatchIndex()
+{
+    NS_LOG_UNCOND("-- [TestExactMatchIndex] --");
 
     SPQ spq;
-    TrafficClass* high = new TrafficClass(); high->SetPriorityLevel(0);
-    TrafficClass* low  = new TrafficClass(); low->SetPriorityLevel(1);
-    spq.RegisterQueue(high); spq.RegisterQueue(low);
+    std::vector<TrafficClass*> classes;
+    for (uint32_t i = 0; i < 200; ++i)
+    {
+        Filter* filter = new Filter();
+        filter->AddFilterElement(new DestinationPortNumber(1000 + i));
+        TrafficClass* tc = new TrafficClass();
+        tc->AddFilter(filter);
+        tc->SetIsDefault(i == 199);
+        spq.RegisterQueue(tc);
+        classes.push_back(tc);
+    }
 
-    Ptr<Packet> ph = Create<Packet>(20);
-    Ptr<Packet> pl = Create<Packet>(10);
-    spq.Enqueue(ph); spq.Enqueue(pl);
+    // A two-element filter cannot be indexed; it still wins because its class comes first
+    Filter* composite = new Filter();
+    composite->AddFilterElement(new ProtocolNumber(17));
+    composite->AddFilterElement(new DestinationPortNumber(1150));
+    classes[50]->AddFilter(composite);
+
+    // A filter added after registration must reach the index too
+    Filter* address = new Filter();
+    address->AddFilterElement(new DestinationIPAddress(Ipv4Address("10.1.2.9")));
+    classes[10]->AddFilter(address);
+
+    struct Case { const char* destination; uint16_t port; uint32_t expected; };
+    Case cases[] = {
+        {"10.1.2.2", 1000, 0},
+        {"10.1.2.2", 1123, 123},
+        {"10.1.2.2", 1150, 50},
+        {"10.1.2.9", 1100, 10},
+        {"10.1.2.9", 1005, 5},
+        {"10.1.2.2", 9, 199},
+    };
 
-    Ptr<const Packet> sch = spq.Schedule();
-    NS_LOG_UNCOND("\tScheduled size: " << (sch ? sch->GetSize() : 0));
-    Ptr<Packet> dq = spq.Dequeue();
-    NS_LOG_UNCOND("\tDequeued size: " << (dq ? dq->GetSize() : 0));
+    for (const Case& c : cases)
+    {
+        Ptr<Packet> pkt = MakeUdpPacket(Ipv4Address("10.1.1.1"), Ipv4Address(c.destination), 49153, c.port);
+
+        // Reference result: check every class in order
+        uint32_t reference = DiffServ::NO_QUEUE;
+        for (uint32_t i = 0; i < classes.size() && reference == DiffServ::NO_QUEUE; ++i)
+        {
+            if (classes[i]->Match(pkt))
+            {
+                reference = i;
+            }
+        }
+        if (reference == DiffServ::NO_QUEUE)
+        {
+            reference = 199;
+        }
+
+        uint32_t index = spq.Classify(pkt);
+        if (index != c.expected || index != reference)
+        {
+            NS_LOG_UNCOND("\tFAILED: Port " << c.port << " classified to " << index << ", expected " << c.expected);
+            return false;
+        }
+    }
+    NS_LOG_UNCOND("\tPASSED: Index keeps first-match semantics.");
 
     return true;
 }
 
 /**
  * \ingroup diffserv
- * \brief Test DRR scheduling (deficit round robin).
- * \returns true if expected packet is dequeued.
+ * \brief Test the longest-prefix-match trie and its use for subnet filters.
+ * \returns true if lookups agree with a brute-force longest match and the most specific subnet wins in every classifier mode.
  */
 bool
-DiffservTests::TestDRR()
+DiffservTests::TestPrefixTrie()
 {
-    NS_LOG_UNCOND("-- [TestDRR] --");
+    NS_LOG_UNCOND("-- [TestPrefixTrie] --");
 
-    DRR drr;
-    TrafficClass* tw = new TrafficClass(); tw->SetWeight(70);
-    TrafficClass* tl = new TrafficClass(); tl->SetWeight(50);
-    drr.RegisterQueue(tl); drr.RegisterQueue(tw);
+    // Random prefixes, clustered under 10.0.0.0/8 so they overlap
+    std::mt19937 rng(7);
+    std::vector<std::pair<uint32_t, uint8_t>> prefixes;
+    PrefixTrie trie;
+    for (uint32_t i = 0; i < 500; ++i)
+    {
+        uint8_t length = rng() % 33;
+        uint32_t mask = length == 0 ? 0 : 0xffffffffu << (32 - length);
+        uint32_t prefix = (0x0a000000u | (rng() & 0x00ffffffu)) & mask;
+        prefixes.emplace_back(prefix, length);
+        trie.Insert(prefix, length, i);
+    }
 
-    Ptr<Packet> ph = Create<Packet>(80);
-    Ptr<Packet> pl = Create<Packet>(40);
-    tw->Enqueue(ph); tl->Enqueue(pl);
+    for (uint32_t n = 0; n < 5000; ++n)
+    {
+        uint32_t address = 0x0a000000u | (rng() & 0x00ffffffu);
+        if (n % 2 == 0)
+        {
+            // Half the probes land inside a stored prefix
+            const auto& p = prefixes[rng() % prefixes.size()];
+            uint32_t mask = p.second == 0 ? 0 : 0xffffffffu << (32 - p.second);
+            address = p.first | (address & ~mask);
+        }
 
-    Ptr<Packet> dq = drr.Dequeue();
-    NS_LOG_UNCOND("\tDequeued size: " << (dq ? dq->GetSize() : 0));
-    return (dq == pl);
-}
\ No newline at end of file
+        // Reference: longest prefix, lowest class among equal prefixes
+        uint32_t expected = PrefixTrie::NO_MATCH;
+        int32_t bestLength = -1;
+        for (uint32_t i = 0; i < prefixes.size(); ++i)
+        {
+            uint32_t mask = prefixes[i].second == 0 ? 0 : 0xffffffffu << (32 - prefixes[i].second);
+            if ((address & mask) == prefixes[i].first && prefixes[i].second > bestLength)
+            {
+                bestLength = prefixes[i].second;
+                expected = i;
+            }
+        }
+
+        if (trie.Lookup(address) != expected)
+        {
+            NS_LOG_UNCOND("\tFAILED: Lookup of " << Ipv4Address(address) << " returned " << trie.Lookup(address) << ", expected " << expected);
+            return false;
+        }
+    }
+    NS_LOG_UNCOND("\tPASSED: Trie agrees with a brute-force longest match.");
+
+    // Overlapping subnets, the /8 registered before the more specific ones
+    DiffServ::ClassifierMode modes[] = {DiffServ::CLASSIFIER_INDEXED, DiffServ::CLASSIFIER_DECISION_TREE, DiffServ::CLASSIFIER_LINEAR};
+    for (DiffServ::ClassifierMode mode : modes)
+    {
+        SPQ spq;
+        spq.SetClassifierMode(mode);
+        const char* subnets[][2] = {{"10.0.0.0", "255.0.0.0"}, {"10.1.2.0", "255.255.255.0"}, {"10.1.0.0", "255.255.0.0"}};
+        for (auto& subnet : subnets)
+        {
+            Filter* filter = new Filter();
+            filter->AddFilterElement(new DestinationMask(Ipv4Mask(subnet[1]), Ipv4Address(subnet[0])));
+            TrafficClass* tc = new TrafficClass();
+            tc->AddFilter(filter);
+            spq.RegisterQueue(tc);
+        }
+
+        struct Case { const char* destination; uint32_t expected; };
+        Case cases[] = {{"10.1.2.2", 1}, {"10.1.3.3", 2}, {"10.9.9.9", 0}, {"11.1.2.2", DiffServ::NO_QUEUE}};
+        for (const Case& c : cases)
+        {
+            Ptr<Packet> pkt = MakeUdpPacket(Ipv4Address("10.2.2.2"), Ipv4Address(c.destination), 49153, 80);
+            if (spq.Classify(pkt) != c.expected)
+            {
+                NS_LOG_UNCOND("\tFAILED: Mode " << mode << " classified " << c.destination << " to " << spq.Classify(pkt) << ", expected " << c.expected);
+                return false;
+            }
+        }
+    }
+    NS_LOG_UNCOND("\tPASSED: Most specific subnet wins in every classifier mode.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test the flow cache: hits, invalidation on rule changes, and clock eviction.
+ * \returns true if repeat packets hit and the cache never returns a stale class.
+ */
+bool
+DiffservTests::TestFlowCache()
+{
+    NS_LOG_UNCOND("-- [TestFlowCache] --");
+
+    SPQ spq;
+    TrafficClass* first = new TrafficClass();
+    TrafficClass* second = new TrafficClass();
+    Filter* portFilter = new Filter();
+    portFilter->AddFilterElement(new DestinationPortNumber(5000));
+    first->AddFilter(portFilter);
+    Filter* otherPortFilter = new Filter();
+    otherPortFilter->AddFilterElement(new DestinationPortNumber(6000));
+    second->AddFilter(otherPortFilter);
+    spq.RegisterQueue(first);
+    spq.RegisterQueue(second);
+
+    Ptr<Packet> pkt = MakeUdpPacket(Ipv4Address("10.1.1.1"), Ipv4Address("10.1.2.2"), 49153, 6000);
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        if (spq.Classify(pkt) != 1)
+        {
+            NS_LOG_UNCOND("\tFAILED: Flow classified to the wrong class.");
+            return false;
+        }
+    }
+    if (spq.GetFlowCacheHits() != 9 || spq.GetFlowCacheMisses() != 1)
+    {
+        NS_LOG_UNCOND("\tFAILED: Expected 9 hits / 1 miss, got " << spq.GetFlowCacheHits() << " / " << spq.GetFlowCacheMisses());
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Repeat packets hit the cache.");
+
+    // A new filter on an earlier class must take effect for a cached flow
+    Filter* addressFilter = new Filter();
+    addressFilter->AddFilterElement(new DestinationIPAddress(Ipv4Address("10.1.2.2")));
+    first->AddFilter(addressFilter);
+    if (spq.Classify(pkt) != 0)
+    {
+        NS_LOG_UNCOND("\tFAILED: Cached class survived AddFilter.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: AddFilter invalidates the cache.");
+
+    // One set of four ways: a referenced flow gets a second chance, the oldest unreferenced one goes
+    FlowCache cache(4);
+    std::vector<FlowKey> keys;
+    for (uint16_t port = 1; port <= 5; ++port)
+    {
+        keys.push_back(FlowKey::Parse(MakeUdpPacket(Ipv4Address("10.1.1.1"), Ipv4Address("10.1.2.2"), port, 80)));
+    }
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        cache.Insert(keys[i], i);
+    }
+
+    uint32_t classIndex;
+    cache.Lookup(keys[0], classIndex);
+    cache.Insert(keys[4], 4);
+    if (!cache.Lookup(keys[0], classIndex) || classIndex != 0 || cache.Lookup(keys[1], classIndex) ||
+        !cache.Lookup(keys[4], classIndex) || classIndex != 4)
+    {
+        NS_LOG_UNCOND("\tFAILED: Clock eviction picked the wrong entry.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Clock eviction keeps referenced flows.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test the tuple space search for multi-field filters against first-match semantics.
+ * \returns true if Classify agrees with checking every class in order.
+ */
+bool
+DiffservTests::TestTupleSpace()
+{
+    NS_LOG_UNCOND("-- [TestTupleSpace] --");
+
+    // Small value pools so that rules overlap
+    std::mt19937 rng(11);
+    auto address = [&rng]() { return Ipv4Address(0x0a000000u | ((rng() % 4) << 16) | ((rng() % 4) << 8) | (rng() % 4)); };
+    auto port = [&rng]() { return static_cast<uint16_t>(1000 + rng() % 8); };
+
+    SPQ spq;
+    spq.SetFlowCacheSize(0);
+    std::vector<TrafficClass*> classes;
+    for (uint32_t i = 0; i < 300; ++i)
+    {
+        Filter* filter = new Filter();
+        switch (i % 4)
+        {
+            case 0:
+                filter->AddFilterElement(new DestinationPortNumber(port()));
+                filter->AddFilterElement(new ProtocolNumber(17));
+                break;
+            case 1:
+                filter->AddFilterElement(new SourceMask(Ipv4Mask("255.255.255.0"), address()));
+                filter->AddFilterElement(new DestinationPortNumber(port()));
+                break;
+            case 2:
+                filter->AddFilterElement(new DestinationIPAddress(address()));
+                filter->AddFilterElement(new SourcePortNumber(port()));
+                break;
+            default:
+                filter->AddFilterElement(new SourceMask(Ipv4Mask("255.255.0.0"), address()));
+                filter->AddFilterElement(new DestinationMask(Ipv4Mask("255.255.255.0"), address()));
+                filter->AddFilterElement(new ProtocolNumber(6));
+                break;
+        }
+
+        TrafficClass* tc = new TrafficClass();
+        tc->AddFilter(filter);
+        spq.RegisterQueue(tc);
+        classes.push_back(tc);
+    }
+
+    for (uint32_t n = 0; n < 2000; ++n)
+    {
+        Ptr<Packet> pkt = MakeUdpPacket(address(), address(), port(), port());
+
+        uint32_t reference = DiffServ::NO_QUEUE;
+        for (uint32_t i = 0; i < classes.size() && reference == DiffServ::NO_QUEUE; ++i)
+        {
+            if (classes[i]->Match(pkt))
+            {
+                reference = i;
+            }
+        }
+
+        uint32_t index = spq.Classify(pkt);
+        if (index != reference)
+        {
+            NS_LOG_UNCOND("\tFAILED: Packet classified to " << index << ", expected " << reference);
+            return false;
+        }
+    }
+    NS_LOG_UNCOND("\tPASSED: Tuple space keeps first-match semantics.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test the decision tree classifier on an ACL-style rule set.
+ * \returns true if the tree is actually cut and agrees with checking every class in order.
+ */
+bool
+DiffservTests::TestDecisionTree()
+{
+    NS_LOG_UNCOND("-- [TestDecisionTree] --");
+
+    std::mt19937 rng(13);
+    auto address = [&rng]() { return Ipv4Address(0x0a000000u | ((rng() % 8) << 16) | ((rng() % 8) << 8) | (rng() % 8)); };
+    auto port = [&rng]() { return static_cast<uint16_t>(1000 + rng() % 16); };
+    const char* masks[] = {"255.0.0.0", "255.255.0.0", "255.255.255.0", "255.255.255.255"};
+
+    // Subnet pairs with optional port and protocol tests, plus one non-contiguous mask
+    std::vector<TrafficClass*> classes;
+    std::vector<std::pair<uint32_t, const Filter*>> rules;
+    for (uint32_t i = 0; i < 400; ++i)
+    {
+        Filter* filter = new Filter();
+        filter->AddFilterElement(new SourceMask(Ipv4Mask(masks[1 + rng() % 3]), address()));
+        filter->AddFilterElement(new DestinationMask(Ipv4Mask(masks[rng() % 4]), address()));
+        if (i % 3 == 0)
+        {
+            filter->AddFilterElement(new DestinationPortNumber(port()));
+        }
+        if (i % 5 == 0)
+        {
+            filter->AddFilterElement(new ProtocolNumber(i % 2 ? 6 : 17));
+        }
+        if (i == 200)
+        {
+            filter->AddFilterElement(new DestinationMask(Ipv4Mask("255.0.255.0"), Ipv4Address("10.0.1.0")));
+        }
+
+        TrafficClass* tc = new TrafficClass();
+        tc->AddFilter(filter);
+        classes.push_back(tc);
+        rules.emplace_back(i, filter);
+    }
+
+    DecisionTree tree;
+    tree.Build(rules);
+    if (tree.GetNodeCount() <= 1 || tree.GetRuleReferences() > rules.size() * DecisionTree::REFERENCES_PER_RULE)
+    {
+        NS_LOG_UNCOND("\tFAILED: Tree has " << tree.GetNodeCount() << " nodes and " << tree.GetRuleReferences() << " rule references.");
+        return false;
+    }
+
+    SPQ spq;
+    spq.SetFlowCacheSize(0);
+    spq.SetClassifierMode(DiffServ::CLASSIFIER_DECISION_TREE);
+    for (TrafficClass* tc : classes)
+    {
+        spq.RegisterQueue(tc);
+    }
+
+    uint32_t matched = 0;
+    for (uint32_t n = 0; n < 3000; ++n)
+    {
+        Ptr<Packet> pkt = MakeUdpPacket(address(), address(), port(), port());
+        FlowKey key = FlowKey::Parse(pkt);
+
+        uint32_t reference = DecisionTree::NO_MATCH;
+        for (uint32_t i = 0; i < classes.size() && reference == DecisionTree::NO_MATCH; ++i)
+        {
+            if (classes[i]->Match(key))
+            {
+                reference = i;
+            }
+        }
+        matched += reference != DecisionTree::NO_MATCH;
+
+        if (tree.Lookup(key) != reference || spq.Classify(pkt) != reference)
+        {
+            NS_LOG_UNCOND("\tFAILED: Tree returned " << tree.Lookup(key) << ", expected " << reference);
+            return false;
+        }
+    }
+
+    if (matched == 0)
+    {
+        NS_LOG_UNCOND("\tFAILED: No packet matched a rule.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Tree with " << tree.GetNodeCount() << " nodes keeps first-match semantics.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test the DscpFilterElement and the 64-entry DSCP fast path.
+ * \returns true if pure DSCP and mixed rule sets both keep first-match semantics.
+ */
+bool
+DiffservTests::TestDscpClassifier()
+{
+    NS_LOG_UNCOND("-- [TestDscpClassifier] --");
+
+    Ipv4Address source("10.0.0.1");
+    Ipv4Address destination("10.0.0.2");
+
+    DscpFilterElement ef(46);
+    if (!ef.Match(MakeUdpPacket(source, destination, 1000, 2000, 100, 46)) ||
+        ef.Match(MakeUdpPacket(source, destination, 1000, 2000, 100, 34)))
+    {
+        NS_LOG_UNCOND("\tFAILED: DscpFilterElement does not match on the DSCP bits.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: DscpFilterElement matches on the DSCP bits.");
+
+    // EF, AF41, AF41 again (shadowed by the class before it) and AF11, then a catch-all class
+    const uint8_t codepoints[] = {46, 34, 34, 10};
+    SPQ spq;
+    std::vector<TrafficClass*> classes;
+    for (uint8_t dscp : codepoints)
+    {
+        Filter* filter = new Filter();
+        filter->AddFilterElement(new DscpFilterElement(dscp));
+        TrafficClass* tc = new TrafficClass();
+        tc->AddFilter(filter);
+        spq.RegisterQueue(tc);
+        classes.push_back(tc);
+    }
+    TrafficClass* catchAll = new TrafficClass();
+    spq.RegisterQueue(catchAll);
+    classes.push_back(catchAll);
+
+    // The reference is a first-match walk over the classes
+    auto check = [&classes](SPQ& scheduler, const std::string& name) {
+        for (uint32_t dscp = 0; dscp < DiffServ::DSCP_COUNT; ++dscp)
+        {
+            // Same flow every time, so a stale flow cache entry would show up as a wrong class
+            Ptr<Packet> pkt = MakeUdpPacket(Ipv4Address("10.0.0.1"), Ipv4Address("10.0.0.2"), 1000, 2000, 100, dscp);
+
+            uint32_t reference = DiffServ::NO_QUEUE;
+            for (uint32_t i = 0; i < classes.size() && reference == DiffServ::NO_QUEUE; ++i)
+            {
+                if (classes[i]->Match(pkt))
+                {
+                    reference = i;
+                }
+            }
+
+            uint32_t index = scheduler.Classify(pkt);
+            if (index != reference)
+            {
+                NS_LOG_UNCOND("\tFAILED: " << name << ": DSCP " << dscp << " classified to " << index << ", expected " << reference);
+                return false;
+            }
+        }
+        return true;
+    };
+
+    if (!check(spq, "DSCP table") || spq.Classify(MakeUdpPacket(source, destination, 1000, 2000, 100, 34)) != 1)
+    {
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: DSCP table keeps first-match semantics.");
+
+    // A port test on top of a DSCP test leaves the table and goes through the indexes
+    Filter* filter = new Filter();
+    filter->AddFilterElement(new DscpFilterElement(0));
+    filter->AddFilterElement(new DestinationPortNumber(2000));
+    classes[3]->AddFilter(filter);
+
+    if (!check(spq, "Indexed") || spq.Classify(MakeUdpPacket(source, destination, 1000, 2000, 100, 0)) != 3)
+    {
+        return false;
+    }
+
+    spq.SetClassifierMode(DiffServ::CLASSIFIER_DECISION_TREE);
+    if (!check(spq, "Decision tree"))
+    {
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Mixed DSCP rules keep first-match semantics.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test the srTCM and trTCM meters and the conditioning stage of DoEnqueue.
+ * \returns true if packets are colored per RFC 2697 / 2698 and remarked or dropped by color.
+ */
+bool
+DiffservTests::TestTrafficConditioner()
+{
+    NS_LOG_UNCOND("-- [TestTrafficConditioner] --");
+
+    // srTCM at 1000 bytes/s with 1000 byte buckets, metering 500 byte packets
+    TrafficConditioner singleRate;
+    singleRate.SetSingleRate(DataRate(8000), 1000, 1000);
+    std::string colors;
+    auto meter = [&colors](TrafficConditioner& conditioner, uint32_t count, Time now) {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            colors += "GYR"[conditioner.Meter(500, now)];
+        }
+    };
+
+    // Full buckets, then one second of committed tokens, then two seconds that overflow into the excess bucket
+    meter(singleRate, 5, Seconds(0));
+    meter(singleRate, 3, Seconds(1));
+    meter(singleRate, 5, Seconds(3));
+    if (colors != "GGYYR" "GGR" "GGYYR")
+    {
+        NS_LOG_UNCOND("\tFAILED: srTCM colored " << colors);
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: srTCM colors by the committed and excess buckets.");
+
+    // trTCM with CIR 1000 bytes/s, CBS 500, PIR 2000 bytes/s, PBS 1000
+    TrafficConditioner twoRate;
+    twoRate.SetTwoRate(DataRate(8000), 500, DataRate(16000), 1000);
+    colors.clear();
+    meter(twoRate, 3, Seconds(0));
+    meter(twoRate, 2, Seconds(0.25));
+    if (colors != "GYR" "YR")
+    {
+        NS_LOG_UNCOND("\tFAILED: trTCM colored " << colors);
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: trTCM colors by the peak and committed buckets.");
+
+    // EF is conditioned at the edge: yellow is downgraded to AF11, red is dropped
+    Ipv4Address source("10.0.0.1");
+    Ipv4Address destination("10.0.0.2");
+    uint32_t length = MakeUdpPacket(source, destination, 1000, 2000, 100, 46)->GetSize();
+
+    TrafficConditioner efConditioner;
+    efConditioner.SetSingleRate(DataRate(8), 2 * length, 2 * length);
+    efConditioner.SetAction(TrafficConditioner::YELLOW, TrafficConditioner::ACTION_REMARK, 10);
+    efConditioner.SetAction(TrafficConditioner::RED, TrafficConditioner::ACTION_DROP);
+
+    SPQ spq;
+    const uint8_t codepoints[] = {46, 10};
+    std::vector<TrafficClass*> classes;
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        Filter* filter = new Filter();
+        filter->AddFilterElement(new DscpFilterElement(codepoints[i]));
+        TrafficClass* tc = new TrafficClass();
+        tc->AddFilter(filter);
+        tc->SetPriorityLevel(i);
+        spq.RegisterQueue(tc);
+        classes.push_back(tc);
+    }
+    classes[0]->SetConditioner(&efConditioner);
+
+    uint32_t accepted = 0;
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        if (spq.Enqueue(MakeUdpPacket(source, destination, 1000, 2000, 100, 46)))
+        {
+            ++accepted;
+        }
+    }
+
+    if (accepted != 4 || classes[0]->GetNPackets() != 2 || classes[1]->GetNPackets() != 2 ||
+        efConditioner.GetPackets(TrafficConditioner::RED) != 2 || efConditioner.GetDrops() != 2)
+    {
+        NS_LOG_UNCOND("\tFAILED: Conditioner accepted " << accepted << ", EF holds " << classes[0]->GetNPackets()
+                      << ", AF11 holds " << classes[1]->GetNPackets());
+        return false;
+    }
+
+    if (FlowKey::Parse(classes[1]->Peek()).dscp != 10 || FlowKey::Parse(classes[0]->Peek()).dscp != 46)
+    {
+        NS_LOG_UNCOND("\tFAILED: Yellow packets were not remarked to AF11.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Yellow packets are remarked and downgraded, red packets are dropped.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test a shaped high-priority class under SPQ.
+ * \returns true if the shaped class sends its burst, yields to the other class while it has no
+ * tokens, and is released by timer events that let the owner dequeue once per packet.
+ */
+bool
+DiffservTests::TestTrafficShaper()
+{
+    NS_LOG_UNCOND("-- [TestTrafficShaper] --");
+
+    Ipv4Address source("10.0.0.1");
+    Ipv4Address destination("10.0.0.2");
+    uint32_t length = MakeUdpPacket(source, destination, 1000, 1, 100)->GetSize();
+
+    // The high-priority class may send a burst of two packets, then one packet per 10 ms
+    TrafficShaper shaper(DataRate(length * 8 * 100), 2 * length);
+
+    SPQ spq;
+    std::vector<TrafficClass*> classes;
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        Filter* filter = new Filter();
+        filter->AddFilterElement(new DestinationPortNumber(i + 1));
+        TrafficClass* tc = new TrafficClass();
+        tc->AddFilter(filter);
+        tc->SetPriorityLevel(i);
+        if (i == 0)
+        {
+            tc->SetShaper(&shaper);
+        }
+        spq.RegisterQueue(tc);
+        classes.push_back(tc);
+    }
+
+    // Stand-in for the queue disc: it drains the scheduler whenever a held class is released
+    std::vector<std::pair<Time, uint16_t>> served;
+    uint32_t releases = 0;
+    auto drain = [&spq, &served]() {
+        while (Ptr<Packet> pkt = spq.Dequeue())
+        {
+            served.emplace_back(Simulator::Now(), FlowKey::Parse(pkt).destinationPort);
+        }
+    };
+    std::function<void()> release = [&releases, &drain]() {
+        ++releases;
+        drain();
+    };
+    spq.SetReleaseCallback(Callback<void>(release));
+
+    for (uint32_t i = 0; i < 5; ++i)
+    {
+        spq.Enqueue(MakeUdpPacket(source, destination, 1000, 1, 100));
+        spq.Enqueue(MakeUdpPacket(source, destination, 1000, 2, 100));
+    }
+
+    // At time 0 the burst goes first, then the unshaped class takes the link
+    drain();
+    std::string order;
+    for (const auto& entry : served)
+    {
+        order += std::to_string(entry.second);
+    }
+    if (order != "1122222" || classes[0]->GetNPackets() != 3)
+    {
+        NS_LOG_UNCOND("\tFAILED: Served " << order << " at time 0.");
+        Simulator::Destroy();
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Shaped class sends its burst and yields when out of tokens.");
+
+    // The rest is released one packet per 10 ms, each release running the owner once
+    Simulator::Run();
+    bool paced = served.size() == 10 && releases == 3 && classes[0]->IsEmpty();
+    for (uint32_t k = 1; paced && k <= 3; ++k)
+    {
+        Time expected = MilliSeconds(10 * k);
+        Time actual = served[6 + k].first;
+        paced = served[6 + k].second == 1 && actual >= expected && actual - expected < MicroSeconds(1);
+    }
+    Simulator::Destroy();
+
+    if (!paced)
+    {
+        NS_LOG_UNCOND("\tFAILED: Shaped packets were not released at the committed rate (" << served.size()
+                      << " served, " << releases << " releases).");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Release events pace the shaped class.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test DiffServ enqueue, dequeue, and peek logic.
+ * \returns true if operations succeed with dummy traffic class.
+ */
+bool
+DiffservTests::TestDiffServ()
+{
+    NS_LOG_UNCOND("-- [TestDiffServ] --");
+
+    class DummyTC : public TrafficClass
+    {
+    public:
+        bool Match(Ptr<Packet>) const  { return true; }
+        bool Enqueue(Ptr<Packet> p)  { m_p = p; return true; }
+        Ptr<Packet> Dequeue()  { return m_p; }
+        Ptr<const Packet> Peek() const { return m_p; }
+    private:
+        Ptr<Packet> m_p;
+    };
+
+    class TestDS : public DiffServ
+    {
+    public:
+        Ptr<const Packet> Schedule() const 
+        {
+            if (!m_pkt) m_pkt = Create<Packet>(30);
+            return m_pkt;
+        }
+        // Single queue, so the scheduled queue is always the first one
+        uint32_t ScheduleQueue() const { return q_class.empty() ? NO_QUEUE : 0; }
+    private:
+        mutable Ptr<Packet> m_pkt;
+    };
+
+    Ptr<Packet> testPkt = Create<Packet>(42);
+    TestDS ds;
+    DummyTC* dtc = new DummyTC();
+    ds.RegisterQueue(dtc);
+
+    if (!ds.Enqueue(testPkt))
+    {
+        NS_LOG_UNCOND("\tFAILED: Enqueue in DiffServ.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Enqueue in DiffServ.");
+
+    Ptr<Packet> rd = ds.Dequeue();
+    if (!rd)
+    {
+        NS_LOG_UNCOND("\tFAILED: Dequeue in DiffServ.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Dequeue in DiffServ.");
+
+    Ptr<const Packet> pk = ds.Peek();
+    if (!pk)
+    {
+        NS_LOG_UNCOND("\tFAILED: Peek in DiffServ.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Peek in DiffServ.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test SPQ scheduling (highest priority first).
+ * \returns true if SPQ schedules correctly.
+ */
+bool
+DiffservTests::TestSPQ()
+{
+    NS_LOG_UNCOND("-- [TestSPQ] --");
+
+    SPQ spq;
+    TrafficClass* high = new TrafficClass(); high->SetPriorityLevel(0);
+    TrafficClass* low  = new TrafficClass(); low->SetPriorityLevel(1);
+    spq.RegisterQueue(high); spq.RegisterQueue(low);
+
+    Ptr<Packet> ph = Create<Packet>(20);
+    Ptr<Packet> pl = Create<Packet>(10);
+    spq.Enqueue(ph); spq.Enqueue(pl);
+
+    Ptr<const Packet> sch = spq.Schedule();
+    NS_LOG_UNCOND("\tScheduled size: " << (sch ? sch->GetSize() : 0));
+    Ptr<Packet> dq = spq.Dequeue();
+    NS_LOG_UNCOND("\tDequeued size: " << (dq ? dq->GetSize() : 0));
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test SPQ with more priority levels than fit in one bitmap word.
+ * \returns true if packets leave in priority order and ties keep registration order.
+ */
+bool
+DiffservTests::TestSPQManyLevels()
+{
+    NS_LOG_UNCOND("-- [TestSPQManyLevels] --");
+
+    SPQ spq;
+    std::vector<TrafficClass*> classes;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        // Priorities run backwards and every pair of queues shares a level
+        TrafficClass* tc = new TrafficClass();
+        tc->SetPriorityLevel(1000 - (i / 2));
+        spq.RegisterQueue(tc);
+        classes.push_back(tc);
+    }
+
+    for (TrafficClass* tc : classes)
+    {
+        tc->Enqueue(Create<Packet>(10));
+    }
+
+    for (uint32_t n = 0; n < classes.size(); ++n)
+    {
+        // Highest level first; within a level the queue registered first
+        uint32_t level = 951 + n / 2;
+        uint32_t expected = 2 * (1000 - level) + (n % 2);
+
+        uint32_t index = spq.ScheduleQueue();
+        if (index != expected || !spq.Dequeue())
+        {
+            NS_LOG_UNCOND("\tFAILED: Expected queue " << expected << " but scheduled " << index);
+            return false;
+        }
+    }
+    NS_LOG_UNCOND("\tPASSED: Queues served in priority order.");
+
+    if (spq.ScheduleQueue() != DiffServ::NO_QUEUE)
+    {
+        NS_LOG_UNCOND("\tFAILED: Expected no queue once drained.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: No queue scheduled once drained.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test DRR scheduling (deficit round robin).
+ * \returns true if expected packet is dequeued.
+ */
+bool
+DiffservTests::TestDRR()
+{
+    NS_LOG_UNCOND("-- [TestDRR] --");
+
+    DRR drr;
+    TrafficClass* tw = new TrafficClass(); tw->SetWeight(70);
+    TrafficClass* tl = new TrafficClass(); tl->SetWeight(50);
+    drr.RegisterQueue(tl); drr.RegisterQueue(tw);
+
+    Ptr<Packet> ph = Create<Packet>(80);
+    Ptr<Packet> pl = Create<Packet>(40);
+    tw->Enqueue(ph); tl->Enqueue(pl);
+
+    Ptr<Packet> dq = drr.Dequeue();
+    NS_LOG_UNCOND("\tDequeued size: " << (dq ? dq->GetSize() : 0));
+    return (dq == pl);
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test that Schedule/Peek do not change the DRR round.
+ * \returns true if repeated peeks agree with the packets that are dequeued.
+ */
+bool
+DiffservTests::TestDRRPeekStability()
+{
+    NS_LOG_UNCOND("-- [TestDRRPeekStability] --");
+
+    DRR drr;
+    TrafficClass* ta = new TrafficClass(); ta->SetWeight(100);
+    TrafficClass* tb = new TrafficClass(); tb->SetWeight(100);
+    drr.RegisterQueue(ta); drr.RegisterQueue(tb);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        ta->Enqueue(Create<Packet>(100));
+        tb->Enqueue(Create<Packet>(100));
+    }
+
+    for (int i = 0; i < 6; ++i)
+    {
+        Ptr<const Packet> first = drr.Schedule();
+        Ptr<const Packet> second = drr.Schedule();
+        drr.Peek();
+
+        if (first != second)
+        {
+            NS_LOG_UNCOND("\tFAILED: Repeated Schedule() returned different packets.");
+            return false;
+        }
+
+        Ptr<Packet> dq = drr.Dequeue();
+        if (dq != first)
+        {
+            NS_LOG_UNCOND("\tFAILED: Dequeue did not return the scheduled packet.");
+            return false;
+        }
+    }
+    NS_LOG_UNCOND("\tPASSED: Schedule/Peek did not disturb the round.");
+
+    if (!ta->IsEmpty() || !tb->IsEmpty())
+    {
+        NS_LOG_UNCOND("\tFAILED: Queues should be drained.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Queues drained.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test that DRR shares bytes by weight when the weights are smaller than the packets.
+ * \returns true if the dequeued byte counts follow the 3:2:1 weight ratio.
+ */
+bool
+DiffservTests::TestDRRWeightedShare()
+{
+    NS_LOG_UNCOND("-- [TestDRRWeightedShare] --");
+
+    DRR drr;
+    std::vector<TrafficClass*> classes;
+    for (double weight : {300.0, 200.0, 100.0})
+    {
+        TrafficClass* tc = new TrafficClass();
+        tc->SetWeight(weight);
+        tc->SetMaxPackets(1000);
+        drr.RegisterQueue(tc);
+        classes.push_back(tc);
+    }
+
+    for (TrafficClass* tc : classes)
+    {
+        for (int i = 0; i < 600; ++i)
+        {
+            tc->Enqueue(Create<Packet>(1000));
+        }
+    }
+
+    std::vector<uint32_t> served(classes.size(), 0);
+    for (int i = 0; i < 600; ++i)
+    {
+        uint32_t index = drr.ScheduleQueue();
+        if (index >= classes.size() || !drr.Dequeue())
+        {
+            NS_LOG_UNCOND("\tFAILED: Dequeue returned no packet while backlogged.");
+            return false;
+        }
+        served[index]++;
+    }
+
+    NS_LOG_UNCOND("\tServed: " << served[0] << " / " << served[1] << " / " << served[2]);
+    if (served[0] != 300 || served[1] != 200 || served[2] != 100)
+    {
+        NS_LOG_UNCOND("\tFAILED: Service does not follow the 3:2:1 weights.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Service follows the 3:2:1 weights.");
+
+    return true;
+}
+
+/**
+ * \brief Test the hierarchical scheduler.
+ * The tree is an SPQ root over a voice class and a DRR node, which shares the link 3:1 between
+ * a class and a WFQ node that splits its share 2:1 between two more classes.
+ * \returns true if the test passes, false otherwise.
+ */
+bool
+DiffservTests::TestHierarchicalScheduler()
+{
+    NS_LOG_UNCOND("-- [TestHierarchicalScheduler] --");
+
+    HierarchicalScheduler scheduler(HierarchicalScheduler::NODE_SPQ);
+    uint32_t drrNode = scheduler.AddNode(HierarchicalScheduler::ROOT, HierarchicalScheduler::NODE_DRR, 1);
+    uint32_t wfqNode = scheduler.AddNode(drrNode, HierarchicalScheduler::NODE_WFQ, 0, 1000);
+
+    // Voice, then A under the DRR node, then B and C under the WFQ node
+    std::vector<TrafficClass*> classes;
+    std::vector<uint32_t> parents = {HierarchicalScheduler::ROOT, drrNode, wfqNode, wfqNode};
+    std::vector<double> weights = {0, 3000, 2, 1};
+    for (uint32_t i = 0; i < parents.size(); ++i)
+    {
+        TrafficClass* tc = new TrafficClass();
+        tc->SetPriorityLevel(0);
+        tc->SetWeight(weights[i]);
+        tc->SetMaxPackets(1000);
+        scheduler.RegisterQueue(tc, parents[i]);
+        classes.push_back(tc);
+    }
+
+    for (int i = 0; i < 3; ++i)
+    {
+        classes[0]->Enqueue(Create<Packet>(1000));
+    }
+    for (uint32_t q = 1; q < classes.size(); ++q)
+    {
+        for (int i = 0; i < 600; ++i)
+        {
+            classes[q]->Enqueue(Create<Packet>(1000));
+        }
+    }
+
+    // The voice class is served first
+    for (int i = 0; i < 3; ++i)
+    {
+        if (scheduler.ScheduleQueue() != 0 || !scheduler.Dequeue())
+        {
+            NS_LOG_UNCOND("\tFAILED: The strict priority class was not served first.");
+            return false;
+        }
+    }
+    NS_LOG_UNCOND("\tPASSED: The strict priority class was served first.");
+
+    std::vector<uint32_t> served(classes.size(), 0);
+    for (int i = 0; i < 400; ++i)
+    {
+        // A voice packet arriving mid-round preempts the weighted subtree
+        if (i == 201)
+        {
+            classes[0]->Enqueue(Create<Packet>(1000));
+            if (scheduler.ScheduleQueue() != 0 || !scheduler.Dequeue())
+            {
+                NS_LOG_UNCOND("\tFAILED: A new voice packet did not preempt the weighted classes.");
+                return false;
+            }
+        }
+
+        uint32_t index = scheduler.ScheduleQueue();
+        if (index >= classes.size() || !scheduler.Dequeue())
+        {
+            NS_LOG_UNCOND("\tFAILED: Dequeue returned no packet while backlogged.");
+            return false;
+        }
+        served[index]++;
+    }
+    NS_LOG_UNCOND("\tPASSED: A new voice packet preempted the weighted classes.");
+
+    NS_LOG_UNCOND("\tServed: " << served[1] << " / " << served[2] << " / " << served[3]);
+    if (served[0] != 0 || served[1] != 300 || served[2] + served[3] != 100)
+    {
+        NS_LOG_UNCOND("\tFAILED: The DRR node does not follow the 3:1 weights.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: The DRR node follows the 3:1 weights.");
+
+    if (served[2] < 66 || served[2] > 67)
+    {
+        NS_LOG_UNCOND("\tFAILED: The WFQ node does not follow the 2:1 weights.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: The WFQ node follows the 2:1 weights.");
+
+    // Draining the classes empties every node on the way up
+    while (scheduler.Dequeue())
+    {
+    }
+    if (scheduler.ScheduleQueue() != DiffServ::NO_QUEUE || !scheduler.IsEmpty())
+    {
+        NS_LOG_UNCOND("\tFAILED: The tree still schedules after draining.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: The tree is idle after draining.");
+
+    return true;
+}
+
+/**
+ * \brief Test the WF2Q+ scheduler.
+ * With equal packet sizes and 3:2:1 weights, every prefix of the service order must stay within
+ * one packet of the ideal fluid share (DRR serves whole quanta and drifts by up to a quantum).
+ * A class that becomes backlogged late must not be owed the service it missed while idle.
+ * \returns true if the test passes, false otherwise.
+ */
+bool
+DiffservTests::TestWF2Q()
+{
+    NS_LOG_UNCOND("-- [TestWF2Q] --");
+
+    WF2Q wf2q;
+    std::vector<TrafficClass*> classes;
+    for (double weight : {300.0, 200.0, 100.0})
+    {
+        TrafficClass* tc = new TrafficClass();
+        tc->SetWeight(weight);
+        tc->SetMaxPackets(1000);
+        wf2q.RegisterQueue(tc);
+        classes.push_back(tc);
+    }
+
+    for (TrafficClass* tc : classes)
+    {
+        for (int i = 0; i < 600; ++i)
+        {
+            tc->Enqueue(Create<Packet>(1000));
+        }
+    }
+
+    std::vector<uint32_t> served(classes.size(), 0);
+    double worstLag = 0;
+    for (int i = 1; i <= 600; ++i)
+    {
+        uint32_t index = wf2q.ScheduleQueue();
+        if (index >= classes.size() || !wf2q.Dequeue())
+        {
+            NS_LOG_UNCOND("\tFAILED: Dequeue returned no packet while backlogged.");
+            return false;
+        }
+        served[index]++;
+
+        for (uint32_t q = 0; q < classes.size(); ++q)
+        {
+            double ideal = i * (3.0 - q) / 6.0;
+            worstLag = std::max(worstLag, std::abs(served[q] - ideal));
+        }
+    }
+
+    NS_LOG_UNCOND("\tServed: " << served[0] << " / " << served[1] << " / " << served[2] << ", worst lag " << worstLag);
+    if (served[0] != 300 || served[1] != 200 || served[2] != 100)
+    {
+        NS_LOG_UNCOND("\tFAILED: Service does not follow the 3:2:1 weights.");
+        return false;
+    }
+    if (worstLag > 1.0)
+    {
+        NS_LOG_UNCOND("\tFAILED: Service drifts more than one packet from the fluid share.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Service follows the 3:2:1 weights within one packet at every step.");
+
+    // Drain the two heavy classes, let the light class run alone, then bring one back
+    while (!classes[0]->IsEmpty() || !classes[1]->IsEmpty())
+    {
+        classes[classes[0]->IsEmpty() ? 1 : 0]->Remove();
+    }
+    for (int i = 0; i < 200; ++i)
+    {
+        wf2q.Dequeue();
+    }
+    for (int i = 0; i < 100; ++i)
+    {
+        classes[0]->Enqueue(Create<Packet>(1000));
+    }
+
+    std::fill(served.begin(), served.end(), 0);
+    for (int i = 0; i < 40; ++i)
+    {
+        served[wf2q.ScheduleQueue()]++;
+        wf2q.Dequeue();
+    }
+
+    NS_LOG_UNCOND("\tAfter idle: " << served[0] << " / " << served[2]);
+    if (served[0] < 29 || served[0] > 31)
+    {
+        NS_LOG_UNCOND("\tFAILED: A returning class is not served at its 3:1 share.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: A returning class is served at its share, with no credit for its idle time.");
+
+    return true;
+}
+
+/**
+ * \brief Test the start-time fair queuing scheduler.
+ * The classes use different packet sizes, so fairness is in bytes: at every step the weighted
+ * service of any two classes must differ by at most one maximum packet of each (Goyal et al.).
+ * \returns true if the test passes, false otherwise.
+ */
+bool
+DiffservTests::TestSTFQ()
+{
+    NS_LOG_UNCOND("-- [TestSTFQ] --");
+
+    STFQ stfq;
+    std::vector<TrafficClass*> classes;
+    std::vector<double> weights = {3, 2, 1};
+    std::vector<uint32_t> sizes = {1500, 500, 1000};
+    for (uint32_t q = 0; q < weights.size(); ++q)
+    {
+        TrafficClass* tc = new TrafficClass();
+        tc->SetWeight(weights[q]);
+        tc->SetMaxPackets(2000);
+        stfq.RegisterQueue(tc);
+        classes.push_back(tc);
+
+        for (int i = 0; i < 2000; ++i)
+        {
+            tc->Enqueue(Create<Packet>(sizes[q]));
+        }
+    }
+
+    std::vector<double> bytes(classes.size(), 0);
+    double worstGap = 0;
+    bool withinBound = true;
+    for (int i = 0; i < 1000; ++i)
+    {
+        uint32_t index = stfq.ScheduleQueue();
+        Ptr<Packet> pkt = stfq.Dequeue();
+        if (index >= classes.size() || !pkt)
+        {
+            NS_LOG_UNCOND("\tFAILED: Dequeue returned no packet while backlogged.");
+            return false;
+        }
+        bytes[index] += pkt->GetSize();
+
+        for (uint32_t a = 0; a < classes.size(); ++a)
+        {
+            for (uint32_t b = a + 1; b < classes.size(); ++b)
+            {
+                double gap = std::abs(bytes[a] / weights[a] - bytes[b] / weights[b]);
+                worstGap = std::max(worstGap, gap);
+                withinBound &= gap <= sizes[a] / weights[a] + sizes[b] / weights[b];
+            }
+        }
+    }
+
+    NS_LOG_UNCOND("\tBytes: " << bytes[0] << " / " << bytes[1] << " / " << bytes[2] << ", worst weighted gap " << worstGap);
+    if (!withinBound)
+    {
+        NS_LOG_UNCOND("\tFAILED: Weighted service drifted past the SFQ fairness bound.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Weighted service stays within the SFQ fairness bound at every step.");
+
+    // The virtual time follows the packet in service, and a class returning from idle starts there
+    while (!classes[1]->IsEmpty())
+    {
+        classes[1]->Remove();
+    }
+    for (int i = 0; i < 50; ++i)
+    {
+        stfq.Dequeue();
+    }
+    classes[1]->Enqueue(Create<Packet>(500));
+    if (stfq.ScheduleQueue() != 1)
+    {
+        NS_LOG_UNCOND("\tFAILED: A class returning from idle did not start at the virtual time.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: A class returning from idle starts at the virtual time.");
+
+    return true;
+}
+
+/**
+ * \brief Test per-flow stochastic fair queuing inside a TrafficClass.
+ * An elephant flow fills most of the class before three mice arrive: the mice are served
+ * within the first round instead of behind the elephant, a full class drops from the elephant
+ * to admit a mouse, and rehashing after a perturbation keeps every flow in order.
+ * \returns true if the test passes, false otherwise.
+ */
+bool
+DiffservTests::TestFlowQueues()
+{
+    NS_LOG_UNCOND("-- [TestFlowQueues] --");
+
+    SPQ spq;
+    TrafficClass* tc = new TrafficClass();
+    tc->SetMaxPackets(20);
+    tc->SetIsDefault(true);
+    StochasticFairQueue* flowQueue = new StochasticFairQueue(64, 300, Seconds(0));
+    tc->SetFlowQueue(flowQueue);
+    spq.RegisterQueue(tc);
+
+    // Pick source ports whose flows land in distinct buckets (the elephant uses the first)
+    std::vector<uint16_t> ports;
+    std::vector<bool> used(flowQueue->GetBuckets(), false);
+    for (uint16_t port = 1000; ports.size() < 5; ++port)
+    {
+        uint32_t bucket = flowQueue->GetBucket(FlowKey::Parse(MakeUdpPacket(Ipv4Address("10.1.1.1"), Ipv4Address("10.1.2.2"), port, 3333)));
+        if (!used[bucket])
+        {
+            used[bucket] = true;
+            ports.push_back(port);
+        }
+    }
+
+    auto makePacket = [](uint16_t port, uint32_t size) {
+        return MakeUdpPacket(Ipv4Address("10.1.1.1"), Ipv4Address("10.1.2.2"), port, 3333, size);
+    };
+
+    // 17 elephant packets (payload 200..216 gives their order), then three single-packet mice
+    for (uint32_t i = 0; i < 17; ++i)
+    {
+        spq.Enqueue(makePacket(ports[0], 200 + i));
+    }
+    for (uint32_t m = 1; m <= 3; ++m)
+    {
+        spq.Enqueue(makePacket(ports[m], 100));
+    }
+
+    // The class is full: the elephant is refused, a new mouse displaces the elephant's oldest packet
+    if (spq.Enqueue(makePacket(ports[0], 300)))
+    {
+        NS_LOG_UNCOND("\tFAILED: The longest flow was admitted into a full class.");
+        return false;
+    }
+    if (!spq.Enqueue(makePacket(ports[4], 100)) || flowQueue->GetDrops() != 1 || spq.GetNPackets() != 20)
+    {
+        NS_LOG_UNCOND("\tFAILED: A new flow did not displace a packet of the longest flow.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: A full class drops from its longest flow, not from new flows.");
+
+    // The elephant holds the first turn for two packets, then every mouse gets its turn
+    uint32_t mice = 0;
+    for (int i = 0; i < 6; ++i)
+    {
+        Ptr<Packet> pkt = spq.Dequeue();
+        if (pkt && pkt->GetSize() < 200)
+        {
+            mice++;
+        }
+    }
+    if (mice != 4)
+    {
+        NS_LOG_UNCOND("\tFAILED: Only " << mice << " of 4 mice were served in the first round.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Every mouse was served in the first round, not behind the elephant.");
+
+    // Rehash with a new seed and check the elephant still leaves in order
+    flowQueue->Perturb();
+    uint32_t last = 0;
+    bool inOrder = true;
+    while (Ptr<Packet> pkt = spq.Dequeue())
+    {
+        inOrder &= pkt->GetSize() > last;
+        last = pkt->GetSize();
+    }
+    if (!inOrder || spq.GetNPackets() != 0 || spq.GetNBytes() != 0 || tc->GetNPackets() != 0)
+    {
+        NS_LOG_UNCOND("\tFAILED: Packets were reordered by the perturbation or the counters drifted.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Perturbation keeps each flow in order and the counters drain to zero.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test the bucketed rank queue against a sorted reference.
+ * Ranks spread well past the window and some are pushed in below its base, so the overflow heap
+ * and the window rebase are exercised along with the bitmap.
+ * \returns true if the test passes, false otherwise.
+ */
+bool
+DiffservTests::TestRankQueue()
+{
+    NS_LOG_UNCOND("-- [TestRankQueue] --");
+
+    static constexpr uint32_t CLASSES = 200;
+
+    RankQueue queue;
+    queue.Resize(CLASSES);
+    std::vector<int64_t> reference(CLASSES, -1);
+    std::mt19937 rng(21);
+
+    for (int step = 0; step < 20000; ++step)
+    {
+        uint32_t index = rng() % CLASSES;
+        if (rng() % 3 == 0)
+        {
+            queue.Erase(index);
+            reference[index] = -1;
+        }
+        else
+        {
+            uint64_t rank = rng() % 2 == 0 ? rng() % 5000 : rng() % 1000000;
+            queue.Push(index, rank);
+            reference[index] = rank;
+        }
+
+        // Pop the smallest now and then so the window drains and rebases
+        if (step % 7 == 0 && !queue.IsEmpty())
+        {
+            reference[queue.Top()] = -1;
+            queue.Erase(queue.Top());
+        }
+
+        int64_t smallest = -1;
+        uint32_t size = 0;
+        for (int64_t rank : reference)
+        {
+            if (rank >= 0)
+            {
+                size++;
+                smallest = (smallest < 0 || rank < smallest) ? rank : smallest;
+            }
+        }
+
+        if (queue.GetSize() != size || (size > 0 && static_cast<int64_t>(queue.TopRank()) != smallest))
+        {
+            NS_LOG_UNCOND("\tFAILED: Step " << step << " expected " << size << " classes with smallest rank " << smallest);
+            return false;
+        }
+    }
+    NS_LOG_UNCOND("\tPASSED: Smallest rank matches the reference across window and overflow.");
+
+    // Equal ranks leave in the order they arrived
+    RankQueue ties;
+    ties.Resize(3);
+    ties.Push(2, 7);
+    ties.Push(0, 7);
+    ties.Push(1, 7);
+    std::string order;
+    while (!ties.IsEmpty())
+    {
+        order += std::to_string(ties.Top());
+        ties.Erase(ties.Top());
+    }
+    if (order != "201")
+    {
+        NS_LOG_UNCOND("\tFAILED: Equal ranks left in order " << order);
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Equal ranks are first come, first served.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test the PIFO scheduler with each built-in rank function and a custom one.
+ * Priority ranks must reproduce SPQ, fair ranks must keep the SFQ bound, deadline ranks must
+ * serve a later but more urgent packet first, and slack ranks must favor the longer packet.
+ * \returns true if the test passes, false otherwise.
+ */
+bool
+DiffservTests::TestPIFO()
+{
+    NS_LOG_UNCOND("-- [TestPIFO] --");
+
+    Ipv4Address source("10.0.0.1");
+    Ipv4Address destination("10.0.0.2");
+
+    // One class per destination port 1 .. n
+    auto build = [](DiffServ& scheduler, uint32_t n, std::function<void(TrafficClass*, uint32_t)> configure) {
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            Filter* filter = new Filter();
+            filter->AddFilterElement(new DestinationPortNumber(i + 1));
+            TrafficClass* tc = new TrafficClass();
+            tc->AddFilter(filter);
+            tc->SetMaxPackets(1000);
+            configure(tc, i);
+            scheduler.RegisterQueue(tc);
+        }
+    };
+    auto drain = [](DiffServ& scheduler) {
+        std::string order;
+        while (Ptr<Packet> pkt = scheduler.Dequeue())
+        {
+            order += std::to_string(FlowKey::Parse(pkt).destinationPort);
+        }
+        return order;
+    };
+
+    // Priority ranks reproduce SPQ
+    std::vector<uint32_t> levels = {2, 0, 1};
+    PIFO priority(PIFO::RANK_PRIORITY);
+    SPQ spq;
+    build(priority, 3, [&levels](TrafficClass* tc, uint32_t i) { tc->SetPriorityLevel(levels[i]); });
+    build(spq, 3, [&levels](TrafficClass* tc, uint32_t i) { tc->SetPriorityLevel(levels[i]); });
+    for (uint32_t n = 0; n < 12; ++n)
+    {
+        uint16_t port = 1 + (n * 7) % 3;
+        priority.Enqueue(MakeUdpPacket(source, destination, 1000, port));
+        spq.Enqueue(MakeUdpPacket(source, destination, 1000, port));
+    }
+    std::string pifoOrder = drain(priority);
+    std::string spqOrder = drain(spq);
+    if (pifoOrder != spqOrder || pifoOrder != "222233331111")
+    {
+        NS_LOG_UNCOND("\tFAILED: Priority ranks served " << pifoOrder << ", SPQ served " << spqOrder);
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Priority ranks reproduce SPQ.");
+
+    // Fair ranks share the link 3:1 within the SFQ bound
+    PIFO fair(PIFO::RANK_FAIR);
+    std::vector<double> weights = {3, 1};
+    build(fair, 2, [&weights](TrafficClass* tc, uint32_t i) { tc->SetWeight(weights[i]); });
+    for (uint32_t n = 0; n < 400; ++n)
+    {
+        fair.Enqueue(MakeUdpPacket(source, destination, 1000, 1 + n % 2, 200));
+    }
+    uint32_t length = MakeUdpPacket(source, destination, 1000, 1, 200)->GetSize();
+    std::vector<double> bytes(2, 0);
+    bool withinBound = true;
+    for (int n = 0; n < 200; ++n)
+    {
+        Ptr<Packet> pkt = fair.Dequeue();
+        bytes[FlowKey::Parse(pkt).destinationPort - 1] += pkt->GetSize();
+        withinBound &= std::abs(bytes[0] / weights[0] - bytes[1] / weights[1]) <= length / weights[0] + length / weights[1];
+    }
+    NS_LOG_UNCOND("\tBytes: " << bytes[0] << " / " << bytes[1]);
+    if (!withinBound)
+    {
+        NS_LOG_UNCOND("\tFAILED: Fair ranks drifted past the SFQ fairness bound.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Fair ranks keep the weighted share within the SFQ bound.");
+
+    // Deadline ranks: a packet arriving at 5 ms with a 2 ms budget beats one from 0 ms with 10 ms
+    PIFO deadline(PIFO::RANK_DEADLINE);
+    std::vector<Time> budgets = {MilliSeconds(10), MilliSeconds(2)};
+    build(deadline, 2, [&budgets](TrafficClass* tc, uint32_t i) { tc->SetDelayBudget(budgets[i]); });
+    deadline.Enqueue(MakeUdpPacket(source, destination, 1000, 1));
+    std::string deadlineOrder;
+    Simulator::Schedule(MilliSeconds(5), [&]() {
+        deadline.Enqueue(MakeUdpPacket(source, destination, 1000, 2));
+        deadlineOrder = drain(deadline);
+    });
+    Simulator::Run();
+    Simulator::Destroy();
+    if (deadlineOrder != "21")
+    {
+        NS_LOG_UNCOND("\tFAILED: Deadline ranks served " << deadlineOrder);
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Deadline ranks serve the earliest deadline first.");
+
+    // Slack ranks: same deadline, so the packet that takes longer to send goes first
+    PIFO slack(PIFO::RANK_SLACK);
+    slack.SetLinkRate(DataRate(1000000));
+    build(slack, 2, [](TrafficClass* tc, uint32_t) { tc->SetDelayBudget(MilliSeconds(20)); });
+    slack.Enqueue(MakeUdpPacket(source, destination, 1000, 1, 100));
+    slack.Enqueue(MakeUdpPacket(source, destination, 1000, 2, 1200));
+    if (drain(slack) != "21")
+    {
+        NS_LOG_UNCOND("\tFAILED: Slack ranks did not favor the longer transmission.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Slack ranks serve the least slack first.");
+
+    // A custom rank function: smallest packet first
+    PIFO custom;
+    std::function<uint64_t(uint32_t, Ptr<const Packet>)> bySize = [](uint32_t, Ptr<const Packet> pkt) {
+        return static_cast<uint64_t>(pkt->GetSize());
+    };
+    custom.SetRankFunction(Callback<uint64_t, uint32_t, Ptr<const Packet>>(bySize));
+    build(custom, 3, [](TrafficClass*, uint32_t) {});
+    custom.Enqueue(MakeUdpPacket(source, destination, 1000, 1, 300));
+    custom.Enqueue(MakeUdpPacket(source, destination, 1000, 2, 100));
+    custom.Enqueue(MakeUdpPacket(source, destination, 1000, 3, 200));
+    if (drain(custom) != "231" || custom.GetNPackets() != 0)
+    {
+        NS_LOG_UNCOND("\tFAILED: The custom rank function was not followed.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: A custom rank function orders the packets.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test the EDF scheduler and its deadline-miss counters.
+ * Packets leave in deadline order whatever their arrival order, and a class drained slower than
+ * its budget allows counts exactly the packets that left late.
+ * \returns true if the test passes, false otherwise.
+ */
+bool
+DiffservTests::TestEDF()
+{
+    NS_LOG_UNCOND("-- [TestEDF] --");
+
+    Ipv4Address source("10.0.0.1");
+    Ipv4Address destination("10.0.0.2");
+
+    EDF edf;
+    std::vector<Time> budgets = {MilliSeconds(30), MilliSeconds(10), MilliSeconds(20)};
+    for (uint32_t i = 0; i < budgets.size(); ++i)
+    {
+        Filter* filter = new Filter();
+        filter->AddFilterElement(new DestinationPortNumber(i + 1));
+        TrafficClass* tc = new TrafficClass();
+        tc->AddFilter(filter);
+        tc->SetDelayBudget(budgets[i]);
+        edf.RegisterQueue(tc);
+    }
+
+    // Earliest deadline first, whatever the arrival order
+    std::string order;
+    for (uint16_t port = 1; port <= 3; ++port)
+    {
+        edf.Enqueue(MakeUdpPacket(source, destination, 1000, port));
+    }
+    while (Ptr<Packet> pkt = edf.Dequeue())
+    {
+        order += std::to_string(FlowKey::Parse(pkt).destinationPort);
+    }
+    if (order != "231" || edf.GetDeadlineMisses(0) + edf.GetDeadlineMisses(1) + edf.GetDeadlineMisses(2) != 0)
+    {
+        NS_LOG_UNCOND("\tFAILED: Served " << order << " instead of deadline order.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Head packets leave in deadline order.");
+
+    // Five packets due at 10 ms drained one per 4 ms: the last three are 2, 6 and 10 ms late
+    for (int n = 0; n < 5; ++n)
+    {
+        edf.Enqueue(MakeUdpPacket(source, destination, 1000, 2));
+    }
+    for (int n = 1; n <= 5; ++n)
+    {
+        Simulator::Schedule(MilliSeconds(4 * n), [&edf]() { edf.Dequeue(); });
+    }
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_LOG_UNCOND("\tServed " << edf.GetServed(1) << ", missed " << edf.GetDeadlineMisses(1) << ", max lateness "
+                  << edf.GetMaxLateness(1).GetMilliSeconds() << " ms");
+    if (edf.GetServed(1) != 6 || edf.GetDeadlineMisses(1) != 3 || edf.GetMaxLateness(1) != MilliSeconds(10) ||
+        edf.GetTotalLateness(1) != MilliSeconds(18))
+    {
+        NS_LOG_UNCOND("\tFAILED: Deadline-miss counters do not match the late packets.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Deadline-miss counters count the late packets and their lateness.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test the PIAS multi-level feedback queue.
+ * A long flow is demoted one level per threshold it crosses, a short flow arriving later is
+ * served ahead of the long flow's demoted packets, and a flow idle past the timeout starts again
+ * at the top level.
+ * \returns true if the test passes, false otherwise.
+ */
+bool
+DiffservTests::TestPIAS()
+{
+    NS_LOG_UNCOND("-- [TestPIAS] --");
+
+    Ipv4Address source("10.0.0.1");
+    Ipv4Address destination("10.0.0.2");
+    uint32_t size = MakeUdpPacket(source, destination, 1000, 80)->GetSize();
+
+    PIAS pias({3 * size, 6 * size});
+    pias.SetFlowIdleTimeout(MilliSeconds(10));
+    for (int level = 0; level < 3; ++level)
+    {
+        pias.RegisterQueue(new TrafficClass());
+    }
+
+    // Eight packets of the long flow fill the levels 3 / 3 / 2, then a short flow arrives
+    for (int n = 0; n < 8; ++n)
+    {
+        pias.Enqueue(MakeUdpPacket(source, destination, 1000, 80));
+    }
+    for (int n = 0; n < 2; ++n)
+    {
+        pias.Enqueue(MakeUdpPacket(source, destination, 2000, 80));
+    }
+    if (pias.GetLevelPackets(0) != 5 || pias.GetLevelPackets(1) != 3 || pias.GetLevelPackets(2) != 2)
+    {
+        NS_LOG_UNCOND("\tFAILED: Levels hold " << pias.GetLevelPackets(0) << " / " << pias.GetLevelPackets(1)
+                      << " / " << pias.GetLevelPackets(2) << " packets instead of 5 / 3 / 2.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: The long flow is demoted at each threshold.");
+
+    std::string order;
+    while (Ptr<Packet> pkt = pias.Dequeue())
+    {
+        order += FlowKey::Parse(pkt).sourcePort == 1000 ? 'L' : 'S';
+    }
+    if (order != "LLLSSLLLLL")
+    {
+        NS_LOG_UNCOND("\tFAILED: Served " << order << " instead of LLLSSLLLLL.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: The short flow is served ahead of the demoted packets.");
+
+    // Past the idle timeout the long flow is new again
+    Simulator::Schedule(MilliSeconds(20), [&pias, source, destination]() {
+        pias.Enqueue(MakeUdpPacket(source, destination, 1000, 80));
+    });
+    Simulator::Run();
+    Simulator::Destroy();
+
+    if (pias.GetLevelPackets(0) != 6 || !pias.Dequeue())
+    {
+        NS_LOG_UNCOND("\tFAILED: The idle flow was not reset to the top level.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: An idle flow starts again at the top level.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test a credit-based shaped class under SPQ.
+ * A sent packet leaves the class in debt until its credit climbs back to zero at the idle slope,
+ * and a class that was idle gets no saved-up burst, unlike a token bucket.
+ * \returns true if the test passes, false otherwise.
+ */
+bool
+DiffservTests::TestCreditBasedShaper()
+{
+    NS_LOG_UNCOND("-- [TestCreditBasedShaper] --");
+
+    Ipv4Address source("10.0.0.1");
+    Ipv4Address destination("10.0.0.2");
+    uint32_t length = MakeUdpPacket(source, destination, 1000, 1, 100)->GetSize();
+
+    // A packet takes 1 ms on the port and the class is reserved a quarter of it, so each packet
+    // costs 4 ms of credit
+    DataRate portRate(length * 8 * 1000);
+    CreditBasedShaper shaper(DataRate(length * 8 * 250), portRate);
+
+    SPQ spq;
+    std::vector<TrafficClass*> classes;
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        Filter* filter = new Filter();
+        filter->AddFilterElement(new DestinationPortNumber(i + 1));
+        TrafficClass* tc = new TrafficClass();
+        tc->AddFilter(filter);
+        tc->SetPriorityLevel(i);
+        if (i == 0)
+        {
+            tc->SetShaper(&shaper);
+        }
+        spq.RegisterQueue(tc);
+        classes.push_back(tc);
+    }
+
+    std::vector<std::pair<Time, uint16_t>> served;
+    uint32_t releases = 0;
+    auto drain = [&spq, &served]() {
+        while (Ptr<Packet> pkt = spq.Dequeue())
+        {
+            served.emplace_back(Simulator::Now(), FlowKey::Parse(pkt).destinationPort);
+        }
+    };
+    std::function<void()> release = [&releases, &drain]() {
+        ++releases;
+        drain();
+    };
+    spq.SetReleaseCallback(Callback<void>(release));
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        spq.Enqueue(MakeUdpPacket(source, destination, 1000, 1, 100));
+        spq.Enqueue(MakeUdpPacket(source, destination, 1000, 2, 100));
+    }
+
+    // One packet at time 0, then the class is in debt and the other class takes the link
+    drain();
+    std::string order;
+    for (const auto& entry : served)
+    {
+        order += std::to_string(entry.second);
+    }
+    if (order != "1222" || shaper.GetCredit(Simulator::Now()) != -double(length * 8))
+    {
+        NS_LOG_UNCOND("\tFAILED: Served " << order << " at time 0.");
+        Simulator::Destroy();
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: A sent packet leaves the class in debt.");
+
+    // After 100 ms of idling three packets arrive: only the first finds credit
+    Simulator::Schedule(MilliSeconds(100), [&]() {
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            spq.Enqueue(MakeUdpPacket(source, destination, 1000, 1, 100));
+        }
+        drain();
+    });
+    Simulator::Run();
+    Simulator::Destroy();
+
+    std::vector<Time> expected = {MilliSeconds(4), MilliSeconds(8), MilliSeconds(100), MilliSeconds(104), MilliSeconds(108)};
+    bool paced = served.size() == 9 && releases == 4 && classes[0]->IsEmpty();
+    for (uint32_t k = 0; paced && k < expected.size(); ++k)
+    {
+        Time actual = served[4 + k].first;
+        paced = served[4 + k].second == 1 && actual >= expected[k] && actual - expected[k] < MicroSeconds(1);
+    }
+    if (!paced)
+    {
+        NS_LOG_UNCOND("\tFAILED: Credit did not pace the class (" << served.size() << " served, " << releases << " releases).");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Release events pace the class at the idle slope and an idle class saves no burst.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test the 802.1Qbv gate control list and its gating of SPQ.
+ * The guard band ends each open window early unless the gate stays open into the next entry,
+ * the next gate change is found directly from the time, and SPQ picks among the open gates with
+ * the link woken once when a gate opens.
+ * \returns true if the test passes, false otherwise.
+ */
+bool
+DiffservTests::TestGateControlList()
+{
+    NS_LOG_UNCOND("-- [TestGateControlList] --");
+
+    // Class 0 is open 0-10 ms and 15-20 ms (running into the next cycle), class 1 10-20 ms
+    GateControlList list;
+    list.AddEntry(MilliSeconds(10), 0x1);
+    list.AddEntry(MilliSeconds(5), 0x2);
+    list.AddEntry(MilliSeconds(5), 0x3);
+    list.SetGuardBand(MilliSeconds(2));
+
+    struct Check
+    {
+        Time now;
+        uint64_t gates;
+        Time next;
+    };
+    std::vector<Check> checks = {
+        {MilliSeconds(1), 0x1, MilliSeconds(8)},
+        {MilliSeconds(9), 0x0, MilliSeconds(10)},
+        {MilliSeconds(16), 0x3, MilliSeconds(18)},
+        {MilliSeconds(19), 0x1, MilliSeconds(28)},
+        {MilliSeconds(49), 0x0, MilliSeconds(50)},
+    };
+    for (const Check& check : checks)
+    {
+        Time next;
+        uint64_t gates = list.GetGateStates(check.now, next);
+        if (gates != check.gates || next != check.next)
+        {
+            NS_LOG_UNCOND("\tFAILED: At " << check.now.GetMilliSeconds() << " ms gates " << gates << " until "
+                          << next.GetMilliSeconds() << " ms.");
+            return false;
+        }
+    }
+    NS_LOG_UNCOND("\tPASSED: Gate states and changes follow the cycle and its guard bands.");
+
+    Ipv4Address source("10.0.0.1");
+    Ipv4Address destination("10.0.0.2");
+
+    // Only class 1 is open for the first 10 ms of each cycle, both for the next 10 ms
+    GateControlList gates;
+    gates.AddEntry(MilliSeconds(10), 0x2);
+    gates.AddEntry(MilliSeconds(10), 0x3);
+
+    SPQ spq;
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        Filter* filter = new Filter();
+        filter->AddFilterElement(new DestinationPortNumber(i + 1));
+        TrafficClass* tc = new TrafficClass();
+        tc->AddFilter(filter);
+        tc->SetPriorityLevel(i);
+        spq.RegisterQueue(tc);
+    }
+    spq.SetGateControlList(&gates);
+
+    std::vector<std::pair<Time, uint16_t>> served;
+    uint32_t releases = 0;
+    auto drain = [&spq, &served]() {
+        while (Ptr<Packet> pkt = spq.Dequeue())
+        {
+            served.emplace_back(Simulator::Now(), FlowKey::Parse(pkt).destinationPort);
+        }
+    };
+    std::function<void()> release = [&releases, &drain]() {
+        ++releases;
+        drain();
+    };
+    spq.SetReleaseCallback(Callback<void>(release));
+
+    // The high-priority class waits behind its gate, then a packet of the open class arrives
+    for (int n = 0; n < 2; ++n)
+    {
+        spq.Enqueue(MakeUdpPacket(source, destination, 1000, 1));
+    }
+    drain();
+    Simulator::Schedule(MilliSeconds(5), [&spq, source, destination]() {
+        spq.Enqueue(MakeUdpPacket(source, destination, 1000, 2));
+    });
+    Simulator::Schedule(MilliSeconds(6), [&spq, source, destination]() {
+        spq.Enqueue(MakeUdpPacket(source, destination, 1000, 2));
+    });
+    Simulator::Run();
+    Simulator::Destroy();
+
+    std::string order;
+    bool onTime = true;
+    for (const auto& entry : served)
+    {
+        order += std::to_string(entry.second);
+        onTime = onTime && entry.first == MilliSeconds(10);
+    }
+    if (order != "1122" || !onTime || releases != 1)
+    {
+        NS_LOG_UNCOND("\tFAILED: Served " << order << " with " << releases << " releases.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: SPQ picks among the open gates and the owner is released at the gate change.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test that the indexed, decision tree and linear classifiers agree on overlapping rules.
+ * \returns true if every mode gives the linear reference's answer: first match in class order, longest prefix among subnet filters.
+ */
+bool
+DiffservTests::TestClassifierModesAgree()
+{
+    NS_LOG_UNCOND("-- [TestClassifierModesAgree] --");
+
+    // Nested subnets of every length under 10.0.0.0/8, in both directions, registered in a random
+    // order and mixed with port rules, multi-field rules and a non-contiguous mask, so the indexed
+    // mode spreads them over the hash index, both prefix tries, the tuple space and the linear rules
+    std::mt19937 rng(29);
+    auto address = [&rng]() { return Ipv4Address(0x0a000000u | ((rng() % 4) << 16) | ((rng() % 4) << 8) | (rng() % 4)); };
+    const char* masks[] = {"255.0.0.0", "255.255.0.0", "255.255.255.0", "255.255.255.255"};
+
+    std::vector<std::vector<FilterElement*>> ruleElements;
+    for (uint32_t i = 0; i < 120; ++i)
+    {
+        std::vector<FilterElement*> elements;
+        switch (rng() % 5)
+        {
+            case 0:
+                elements.push_back(new DestinationMask(Ipv4Mask(masks[rng() % 4]), address()));
+                break;
+            case 1:
+                elements.push_back(new SourceMask(Ipv4Mask(masks[rng() % 4]), address()));
+                break;
+            case 2:
+                elements.push_back(new DestinationPortNumber(1000 + rng() % 4));
+                break;
+            case 3:
+                elements.push_back(new SourceMask(Ipv4Mask(masks[rng() % 4]), address()));
+                elements.push_back(new DestinationMask(Ipv4Mask(masks[rng() % 4]), address()));
+                break;
+            default:
+                elements.push_back(new DestinationMask(Ipv4Mask("255.0.255.0"), address()));
+                break;
+        }
+        ruleElements.push_back(elements);
+    }
+
+    DiffServ::ClassifierMode modes[] = {DiffServ::CLASSIFIER_INDEXED, DiffServ::CLASSIFIER_DECISION_TREE, DiffServ::CLASSIFIER_LINEAR};
+    std::vector<SPQ*> schedulers;
+    for (DiffServ::ClassifierMode mode : modes)
+    {
+        SPQ* spq = new SPQ();
+        spq->SetFlowCacheSize(0);
+        spq->SetClassifierMode(mode);
+        for (const auto& elements : ruleElements)
+        {
+            Filter* filter = new Filter();
+            for (FilterElement* element : elements)
+            {
+                filter->AddFilterElement(element);
+            }
+            TrafficClass* tc = new TrafficClass();
+            tc->AddFilter(filter);
+            spq->RegisterQueue(tc);
+        }
+        schedulers.push_back(spq);
+    }
+
+    uint32_t matched = 0;
+    for (uint32_t n = 0; n < 3000; ++n)
+    {
+        Ptr<Packet> pkt = MakeUdpPacket(address(), address(), 49153, 1000 + rng() % 4);
+        uint32_t reference = schedulers[2]->Classify(pkt);
+        matched += reference != DiffServ::NO_QUEUE;
+
+        for (uint32_t m = 0; m < 2; ++m)
+        {
+            if (schedulers[m]->Classify(pkt) != reference)
+            {
+                NS_LOG_UNCOND("\tFAILED: Mode " << modes[m] << " returned " << schedulers[m]->Classify(pkt) << ", linear returned " << reference);
+                return false;
+            }
+        }
+    }
+
+    if (matched == 0)
+    {
+        NS_LOG_UNCOND("\tFAILED: No packet matched a rule.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Indexed, decision tree and linear modes agree on " << matched << " matched packets.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test that a DiffServ used as a device queue never holds a packet it has admitted.
+ * \returns true if a Dequeue right after every successful Enqueue returns a packet.
+ */
+bool
+DiffservTests::TestDeviceQueueNeverHolds()
+{
+    NS_LOG_UNCOND("-- [TestDeviceQueueNeverHolds] --");
+
+    Ipv4Address source("10.0.0.1");
+    Ipv4Address destination("10.0.0.2");
+    uint32_t length = MakeUdpPacket(source, destination, 1000, 1, 100)->GetSize();
+
+    // One packet per 10 ms with no burst to spare
+    TrafficShaper shaper(DataRate(length * 8 * 100), length);
+
+    SPQ spq;
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        Filter* filter = new Filter();
+        filter->AddFilterElement(new DestinationPortNumber(i + 1));
+        TrafficClass* tc = new TrafficClass();
+        tc->AddFilter(filter);
+        tc->SetPriorityLevel(i);
+        if (i == 0)
+        {
+            tc->SetShaper(&shaper);
+        }
+        spq.RegisterQueue(tc);
+    }
+
+    // PointToPointNetDevice::Send on an idle link: Enqueue, then an unconditional Dequeue
+    for (uint32_t n = 0; n < 6; ++n)
+    {
+        uint16_t port = n % 3 == 2 ? 2 : 1;
+        if (!spq.Enqueue(MakeUdpPacket(source, destination, 1000, port)))
+        {
+            NS_LOG_UNCOND("\tFAILED: Packet " << n << " was refused.");
+            return false;
+        }
+        if (!spq.Dequeue())
+        {
+            NS_LOG_UNCOND("\tFAILED: Nothing to dequeue right after packet " << n << " was admitted.");
+            return false;
+        }
+    }
+    Simulator::Destroy();
+    NS_LOG_UNCOND("\tPASSED: Without a release callback the shaper never holds a packet at the head of the device.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test a shaped scheduler as the root queue disc, driven the way the traffic control layer drives it.
+ * \returns true if held items are sent when released and leave without the PPP header.
+ */
+bool
+DiffservTests::TestDiffServQueueDisc()
+{
+    NS_LOG_UNCOND("-- [TestDiffServQueueDisc] --");
+
+    Ipv4Address source("10.0.0.1");
+    Ipv4Address destination("10.0.0.2");
+    uint32_t length = MakeUdpPacket(source, destination, 1000, 1, 100)->GetSize();
+
+    // The high-priority class sends one packet per 10 ms with no burst to spare
+    TrafficShaper shaper(DataRate(length * 8 * 100), length);
+
+    Ptr<SPQ> spq = CreateObject<SPQ>();
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        Filter* filter = new Filter();
+        filter->AddFilterElement(new DestinationPortNumber(i + 1));
+        TrafficClass* tc = new TrafficClass();
+        tc->AddFilter(filter);
+        tc->SetPriorityLevel(i);
+        if (i == 0)
+        {
+            tc->SetShaper(&shaper);
+        }
+        spq->RegisterQueue(tc);
+    }
+
+    Ptr<DiffServQueueDisc> qdisc = CreateObject<DiffServQueueDisc>();
+    qdisc->SetScheduler(spq);
+
+    // Stand-in for the traffic control layer's send callback: it adds the IPv4 header (which
+    // ns-3 asserts is done only once) and hands the item to the device
+    std::vector<std::pair<Time, Ptr<QueueDiscItem>>> sent;
+    std::function<void(Ptr<QueueDiscItem>)> send = [&sent](Ptr<QueueDiscItem> item) {
+        item->AddHeader();
+        sent.emplace_back(Simulator::Now(), item);
+    };
+    qdisc->SetSendCallback(Callback<void, Ptr<QueueDiscItem>>(send));
+    qdisc->Initialize();
+
+    // The traffic control layer enqueues each item and then runs the queue disc
+    auto arrive = [&qdisc, source, destination](uint16_t port) {
+        qdisc->Enqueue(MakeUdpItem(source, destination, 1000, port));
+        qdisc->Run();
+    };
+    arrive(1);
+    arrive(1);
+    arrive(2);
+
+    // The device adds its own PPP header, so the items must leave as IPv4 packets with one IPv4 header
+    auto port = [](Ptr<QueueDiscItem> item) {
+        Ptr<Packet> copy = item->GetPacket()->Copy();
+        Ipv4Header ipHdr;
+        UdpHeader udpHdr;
+        copy->RemoveHeader(ipHdr);
+        copy->RemoveHeader(udpHdr);
+        return udpHdr.GetDestinationPort();
+    };
+    std::string order;
+    for (const auto& entry : sent)
+    {
+        order += std::to_string(port(entry.second));
+    }
+    if (order != "12")
+    {
+        NS_LOG_UNCOND("\tFAILED: Sent " << order << " at time 0.");
+        qdisc->Dispose();
+        Simulator::Destroy();
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: A run that finds the shaped class held sends nothing and keeps its item.");
+
+    Simulator::Run();
+    bool released = sent.size() == 3 && sent[2].first == MilliSeconds(10) && port(sent[2].second) == 1;
+    for (const auto& entry : sent)
+    {
+        released = released && entry.second->GetPacket()->GetSize() == length - 2;
+    }
+    qdisc->Dispose();
+    Simulator::Destroy();
+
+    if (!released)
+    {
+        NS_LOG_UNCOND("\tFAILED: Sent " << sent.size() << " items, the last at " << sent.back().first.GetMilliSeconds() << " ms.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: The release runs the queue disc and items leave unframed, with a single IPv4 header.");
+
+    // The item mirror has no size limit of its own, so a large backlog keeps every item
+    Ptr<SPQ> deep = CreateObject<SPQ>();
+    TrafficClass backlog;
+    backlog.SetMaxPackets(200);
+    deep->RegisterQueue(&backlog);
+    Ptr<DiffServQueueDisc> deepDisc = CreateObject<DiffServQueueDisc>();
+    deepDisc->SetScheduler(deep);
+    deepDisc->Initialize();
+
+    std::vector<Ptr<QueueDiscItem>> items;
+    for (uint16_t i = 0; i < 150; ++i)
+    {
+        items.push_back(MakeUdpItem(source, destination, 1000, i));
+        deepDisc->Enqueue(items.back());
+    }
+    bool kept = deepDisc->GetInternalQueue(0)->GetNPackets() == 150;
+    for (const Ptr<QueueDiscItem>& item : items)
+    {
+        kept = kept && deepDisc->Dequeue() == item;
+    }
+    deepDisc->Dispose();
+
+    if (!kept)
+    {
+        NS_LOG_UNCOND("\tFAILED: The item mirror lost items of a 150 packet backlog.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: The item mirror keeps a backlog beyond the MaxSize default.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test a credit-based shaped class in debt, on the device and in the queue disc.
+ * \returns true if the device always finds the packet it queued and the queue disc holds the class until its credit is back to zero.
+ */
+bool
+DiffservTests::TestCreditBasedShaperInDebt()
+{
+    NS_LOG_UNCOND("-- [TestCreditBasedShaperInDebt] --");
+
+    Ipv4Address source("10.0.0.1");
+    Ipv4Address destination("10.0.0.2");
+    uint32_t length = MakeUdpPacket(source, destination, 1000, 1, 100)->GetSize();
+
+    // Each packet costs 4 ms of credit, as in TestCreditBasedShaper
+    DataRate portRate(length * 8 * 1000);
+    CreditBasedShaper deviceShaper(DataRate(length * 8 * 250), portRate);
+    CreditBasedShaper queueDiscShaper(DataRate(length * 8 * 250), portRate);
+
+    auto makeScheduler = [](TrafficShaper* shaper) {
+        Ptr<SPQ> spq = CreateObject<SPQ>();
+        for (uint32_t i = 0; i < 2; ++i)
+        {
+            Filter* filter = new Filter();
+            filter->AddFilterElement(new DestinationPortNumber(i + 1));
+            TrafficClass* tc = new TrafficClass();
+            tc->AddFilter(filter);
+            tc->SetPriorityLevel(i);
+            if (i == 0)
+            {
+                tc->SetShaper(shaper);
+            }
+            spq->RegisterQueue(tc);
+        }
+        return spq;
+    };
+
+    // PointToPointNetDevice::Send on an idle link: every packet after the first finds the class in debt
+    Ptr<SPQ> device = makeScheduler(&deviceShaper);
+    for (uint32_t n = 0; n < 4; ++n)
+    {
+        device->Enqueue(MakeUdpPacket(source, destination, 1000, 1));
+        if (!device->Dequeue())
+        {
+            NS_LOG_UNCOND("\tFAILED: Nothing to dequeue right after packet " << n << " was admitted.");
+            return false;
+        }
+    }
+    NS_LOG_UNCOND("\tPASSED: Without a release callback a class in debt is not held at the head of the device.");
+
+    Ptr<DiffServQueueDisc> qdisc = CreateObject<DiffServQueueDisc>();
+    qdisc->SetScheduler(makeScheduler(&queueDiscShaper));
+    std::vector<Time> sent;
+    std::function<void(Ptr<QueueDiscItem>)> send = [&sent](Ptr<QueueDiscItem> item) {
+        item->AddHeader();
+        sent.push_back(Simulator::Now());
+    };
+    qdisc->SetSendCallback(Callback<void, Ptr<QueueDiscItem>>(send));
+    qdisc->Initialize();
+
+    // The first packet puts the class in debt, the second waits in the queue disc for its credit
+    for (uint32_t n = 0; n < 2; ++n)
+    {
+        qdisc->Enqueue(MakeUdpItem(source, destination, 1000, 1));
+        qdisc->Run();
+    }
+    bool held = sent.size() == 1 && queueDiscShaper.GetCredit(Simulator::Now()) < 0;
+    Simulator::Run();
+    qdisc->Dispose();
+    Simulator::Destroy();
+
+    if (!held || sent.size() != 2 || sent[1] < MilliSeconds(4) || sent[1] - MilliSeconds(4) >= MicroSeconds(1))
+    {
+        NS_LOG_UNCOND("\tFAILED: Sent " << sent.size() << " packets, the class " << (held ? "was" : "was not") << " held.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: The queue disc holds the class in debt and sends it once its credit is back to zero.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test a packet that arrives while its gate is closed, on the device and in the queue disc.
+ * \returns true if the device always finds the packet it queued and the queue disc sends it when the gate opens.
+ */
+bool
+DiffservTests::TestGateClosedOnArrival()
+{
+    NS_LOG_UNCOND("-- [TestGateClosedOnArrival] --");
+
+    Ipv4Address source("10.0.0.1");
+    Ipv4Address destination("10.0.0.2");
+
+    // Only class 1 is open for the first 10 ms of each cycle, both for the next 10 ms
+    GateControlList gates;
+    gates.AddEntry(MilliSeconds(10), 0x2);
+    gates.AddEntry(MilliSeconds(10), 0x3);
+
+    auto makeScheduler = [&gates]() {
+        Ptr<SPQ> spq = CreateObject<SPQ>();
+        for (uint32_t i = 0; i < 2; ++i)
+        {
+            Filter* filter = new Filter();
+            filter->AddFilterElement(new DestinationPortNumber(i + 1));
+            TrafficClass* tc = new TrafficClass();
+            tc->AddFilter(filter);
+            tc->SetPriorityLevel(i);
+            spq->RegisterQueue(tc);
+        }
+        spq->SetGateControlList(&gates);
+        return spq;
+    };
+
+    // PointToPointNetDevice::Send on an idle link, with the gate of class 0 closed
+    Ptr<SPQ> device = makeScheduler();
+    device->Enqueue(MakeUdpPacket(source, destination, 1000, 1));
+    if (!device->Dequeue())
+    {
+        NS_LOG_UNCOND("\tFAILED: Nothing to dequeue right after the packet was admitted.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Without a release callback a closed gate does not hold a packet at the head of the device.");
+
+    Ptr<DiffServQueueDisc> qdisc = CreateObject<DiffServQueueDisc>();
+    qdisc->SetScheduler(makeScheduler());
+    std::vector<std::pair<Time, uint32_t>> sent;
+    std::function<void(Ptr<QueueDiscItem>)> send = [&sent](Ptr<QueueDiscItem> item) {
+        item->AddHeader();
+        sent.emplace_back(Simulator::Now(), item->GetSize());
+    };
+    qdisc->SetSendCallback(Callback<void, Ptr<QueueDiscItem>>(send));
+    qdisc->Initialize();
+
+    // A packet of the gated class at 2 ms, a larger one of the open class at 5 ms
+    Simulator::Schedule(MilliSeconds(2), [&]() {
+        qdisc->Enqueue(MakeUdpItem(source, destination, 1000, 1, 100));
+        qdisc->Run();
+    });
+    Simulator::Schedule(MilliSeconds(5), [&]() {
+        qdisc->Enqueue(MakeUdpItem(source, destination, 1000, 2, 200));
+        qdisc->Run();
+    });
+    Simulator::Run();
+    qdisc->Dispose();
+    Simulator::Destroy();
+
+    if (sent.size() != 2 || sent[0].first != MilliSeconds(5) || sent[1].first != MilliSeconds(10) || sent[1].second >= sent[0].second)
+    {
+        NS_LOG_UNCOND("\tFAILED: Sent " << sent.size() << " packets.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: The queue disc keeps the packet behind its closed gate and sends it when the gate opens.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test PIFO with a class whose flow sub-queues serve its packets out of arrival order.
+ * \returns true if the class is keyed by the rank of the packet its flows put at the head.
+ */
+bool
+DiffservTests::TestPIFOFlowQueues()
+{
+    NS_LOG_UNCOND("-- [TestPIFOFlowQueues] --");
+
+    Ipv4Address source("10.0.0.1");
+    Ipv4Address destination("10.0.0.2");
+    uint32_t length = MakeUdpPacket(source, destination, 1000, 1)->GetSize();
+
+    // Both classes have a 10 ms budget; class 0 serves its flows in turn, one packet each
+    PIFO pifo(PIFO::RANK_DEADLINE);
+    StochasticFairQueue* flowQueue = new StochasticFairQueue(64, length, Seconds(0));
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        Filter* filter = new Filter();
+        filter->AddFilterElement(new DestinationPortNumber(i + 1));
+        TrafficClass* tc = new TrafficClass();
+        tc->AddFilter(filter);
+        tc->SetDelayBudget(MilliSeconds(10));
+        if (i == 0)
+        {
+            tc->SetFlowQueue(flowQueue);
+        }
+        pifo.RegisterQueue(tc);
+    }
+
+    // Two flows of class 0 in distinct buckets
+    std::vector<uint16_t> ports;
+    for (uint16_t port = 1000; ports.size() < 2; ++port)
+    {
+        uint32_t bucket = flowQueue->GetBucket(FlowKey::Parse(MakeUdpPacket(source, destination, port, 1)));
+        if (ports.empty() || flowQueue->GetBucket(FlowKey::Parse(MakeUdpPacket(source, destination, ports[0], 1))) != bucket)
+        {
+            ports.push_back(port);
+        }
+    }
+
+    // Flow A at 0 and 1 ms, flow B at 2 ms, and class 1 at 1.5 ms. Class 0 serves A, B, A, so
+    // after the first packet its head is B (deadline 12 ms), behind class 1 (11.5 ms).
+    Simulator::Schedule(MilliSeconds(0), [&]() { pifo.Enqueue(MakeUdpPacket(source, destination, ports[0], 1)); });
+    Simulator::Schedule(MilliSeconds(1), [&]() { pifo.Enqueue(MakeUdpPacket(source, destination, ports[0], 1)); });
+    Simulator::Schedule(MicroSeconds(1500), [&]() { pifo.Enqueue(MakeUdpPacket(source, destination, 3000, 2)); });
+    Simulator::Schedule(MilliSeconds(2), [&]() { pifo.Enqueue(MakeUdpPacket(source, destination, ports[1], 1)); });
+    Simulator::Run();
+
+    std::string order;
+    while (Ptr<Packet> pkt = pifo.Dequeue())
+    {
+        uint16_t port = FlowKey::Parse(pkt).sourcePort;
+        order += port == ports[0] ? "A" : port == ports[1] ? "B" : "C";
+    }
+    Simulator::Destroy();
+
+    if (order != "ACBA")
+    {
+        NS_LOG_UNCOND("\tFAILED: Served " << order << ".");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: The class is keyed by the rank of the packet its flows serve next.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test EDF with a flow-queued class that evicts a packet to admit a new flow.
+ * \returns true if the evicted packet takes its deadline with it.
+ */
+bool
+DiffservTests::TestEDFFlowQueueEviction()
+{
+    NS_LOG_UNCOND("-- [TestEDFFlowQueueEviction] --");
+
+    Ipv4Address source("10.0.0.1");
+    Ipv4Address destination("10.0.0.2");
+
+    // A full class drops the oldest packet of its longest flow to admit a new flow
+    EDF edf;
+    TrafficClass* tc = new TrafficClass();
+    tc->SetIsDefault(true);
+    tc->SetMaxPackets(3);
+    tc->SetDelayBudget(MilliSeconds(10));
+    StochasticFairQueue* flowQueue = new StochasticFairQueue(64, 300, Seconds(0));
+    tc->SetFlowQueue(flowQueue);
+    edf.RegisterQueue(tc);
+
+    uint16_t mouse = 2000;
+    uint32_t elephantBucket = flowQueue->GetBucket(FlowKey::Parse(MakeUdpPacket(source, destination, 1000, 1)));
+    while (flowQueue->GetBucket(FlowKey::Parse(MakeUdpPacket(source, destination, mouse, 1))) == elephantBucket)
+    {
+        ++mouse;
+    }
+
+    // Elephant packets at 0, 0 and 5 ms (deadlines 10, 10, 15), then the mouse at 6 ms evicts the first
+    Simulator::Schedule(MilliSeconds(0), [&]() {
+        edf.Enqueue(MakeUdpPacket(source, destination, 1000, 1));
+        edf.Enqueue(MakeUdpPacket(source, destination, 1000, 1));
+    });
+    Simulator::Schedule(MilliSeconds(5), [&]() { edf.Enqueue(MakeUdpPacket(source, destination, 1000, 1)); });
+    Simulator::Schedule(MilliSeconds(6), [&]() { edf.Enqueue(MakeUdpPacket(source, destination, mouse, 1)); });
+
+    // Everything is served at 20 ms: late by 10, 5 and 4 ms
+    uint32_t count = 0;
+    Simulator::Schedule(MilliSeconds(20), [&]() {
+        while (edf.Dequeue())
+        {
+            ++count;
+        }
+    });
+    Simulator::Run();
+    Simulator::Destroy();
+
+    if (flowQueue->GetDrops() != 1 || count != 3 || edf.GetServed(0) != 3 || edf.GetTotalLateness(0) != MilliSeconds(19))
+    {
+        NS_LOG_UNCOND("\tFAILED: Served " << count << " packets " << edf.GetTotalLateness(0).GetMilliSeconds() << " ms late in total.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: The evicted packet takes its deadline with it.");
+
+    return true;
+}
+
+/**
+ * \ingroup diffserv
+ * \brief Test that PIFO raises a rank below the previous rank of its class.
+ * \returns true if decreasing custom and slack ranks are raised and counted, and an empty class starts afresh.
+ */
+bool
+DiffservTests::TestPIFORankClamp()
+{
+    NS_LOG_UNCOND("-- [TestPIFORankClamp] --");
+
+    Ipv4Address source("10.0.0.1");
+    Ipv4Address destination("10.0.0.2");
+
+    auto build = [](PIFO& pifo, uint32_t count) {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            Filter* filter = new Filter();
+            filter->AddFilterElement(new DestinationPortNumber(i + 1));
+            TrafficClass* tc = new TrafficClass();
+            tc->AddFilter(filter);
+            tc->SetDelayBudget(MilliSeconds(20));
+            pifo.RegisterQueue(tc);
+        }
+    };
+    auto rankOf = [source, destination](uint32_t size) {
+        return static_cast<uint64_t>(MakeUdpPacket(source, destination, 1000, 1, size)->GetSize());
+    };
+
+    // Smallest packet first, but class 1 gets its large packet first
+    PIFO custom;
+    std::function<uint64_t(uint32_t, Ptr<const Packet>)> bySize = [](uint32_t, Ptr<const Packet> pkt) {
+        return static_cast<uint64_t>(pkt->GetSize());
+    };
+    custom.SetRankFunction(Callback<uint64_t, uint32_t, Ptr<const Packet>>(bySize));
+    build(custom, 2);
+    custom.Enqueue(MakeUdpPacket(source, destination, 1000, 1, 300));
+    custom.Enqueue(MakeUdpPacket(source, destination, 1000, 1, 100));
+    custom.Enqueue(MakeUdpPacket(source, destination, 1000, 2, 200));
+
+    std::string order;
+    std::vector<uint64_t> heads;
+    while (Ptr<Packet> pkt = custom.Dequeue())
+    {
+        order += std::to_string(FlowKey::Parse(pkt).destinationPort);
+        heads.push_back(custom.GetHeadRank(0));
+    }
+    if (order != "211" || custom.GetClampedRanks(0) != 1 || custom.GetClampedRanks(1) != 0 || heads[1] != rankOf(300))
+    {
+        NS_LOG_UNCOND("\tFAILED: Served " << order << " with " << custom.GetClampedRanks(0) << " clamped ranks.");
+        return false;
+    }
+
+    // Once the class is empty a lower rank is taken as it is
+    custom.Enqueue(MakeUdpPacket(source, destination, 1000, 1, 50));
+    if (custom.GetHeadRank(0) != rankOf(50) || custom.GetClampedRanks(0) != 1)
+    {
+        NS_LOG_UNCOND("\tFAILED: A rank was raised in an empty class.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: A custom rank below the one queued before it is raised to it.");
+
+    // Slack ranks: a small packet behind a large one in the same class has less slack
+    PIFO slack(PIFO::RANK_SLACK);
+    slack.SetLinkRate(DataRate(1000000));
+    build(slack, 1);
+    slack.Enqueue(MakeUdpPacket(source, destination, 1000, 1, 100));
+    slack.Enqueue(MakeUdpPacket(source, destination, 1000, 1, 1200));
+    slack.Enqueue(MakeUdpPacket(source, destination, 1000, 1, 100));
+    if (slack.GetClampedRanks(0) != 1)
+    {
+        NS_LOG_UNCOND("\tFAILED: " << slack.GetClampedRanks(0) << " slack ranks were raised.");
+        return false;
+    }
+    NS_LOG_UNCOND("\tPASSED: Slack ranks of mixed sizes are raised to keep the class order.");
+
+    return true;
+}
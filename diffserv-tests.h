@@ -25,10 +25,43 @@ class DiffservTests
     bool TestDestinationMask();
     bool TestProtocolNumber();
     bool TestFilter();
+    bool TestFlowKey();
     bool TestTrafficClass();
+    bool TestTrafficClassRing();
+    bool TestByteLimits();
+    bool TestSharedBuffer();
+    bool TestExactMatchIndex();
+    bool TestPrefixTrie();
+    bool TestFlowCache();
+    bool TestTupleSpace();
+    bool TestDecisionTree();
+    bool TestDscpClassifier();
+    bool TestTrafficConditioner();
+    bool TestTrafficShaper();
     bool TestDiffServ();
     bool TestSPQ();
+    bool TestSPQManyLevels();
     bool TestDRR();
+    bool TestDRRPeekStability();
+    bool TestDRRWeightedShare();
+    bool TestHierarchicalScheduler();
+    bool TestWF2Q();
+    bool TestSTFQ();
+    bool TestFlowQueues();
+    bool TestRankQueue();
+    bool TestPIFO();
+    bool TestEDF();
+    bool TestPIAS();
+    bool TestCreditBasedShaper();
+    bool TestGateControlList();
+    bool TestClassifierModesAgree();
+    bool TestDeviceQueueNeverHolds();
+    bool TestDiffServQueueDisc();
+    bool TestCreditBasedShaperInDebt();
+    bool TestGateClosedOnArrival();
+    bool TestPIFOFlowQueues();
+    bool TestEDFFlowQueueEviction();
+    bool TestPIFORankClamp();
   };
 } // namespace ns3
 
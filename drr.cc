@@ -3,6 +3,7 @@
 #include "diff-serv.h"
 #include "ns3/packet.h"
 #include "ns3/queue.h"
+#include <limits>
 
 /**
      * DRR Algorithm Reference 1: https://en.wikipedia.org/wiki/Deficit_round_robin
@@ -24,123 +25,261 @@
      */
 
 namespace ns3 {
-    DRR::DRR() : currentQueue(0) {}
+    DRR::DRR() : activeHead(NO_QUEUE), headCredited(false), decisionValid(false), decisionQueue(NO_QUEUE), decisionLaps(0) {}
 
     /**
-     * \brief Retrieves the list of traffic classes.
-     * \details This function returns the list of traffic classes associated with the DiffServ instance.
+     * \ingroup diffserv
+     * \brief Schedules the next packet to be dequeued based on the DRR algorithm.
+     * \returns A pointer to the next scheduled packet. If no packet is found, returns nullptr.
+     * \note Does not change the DRR state, so it can be called any number of times between dequeues.
+     * 
+     * Reference: https://en.wikipedia.org/wiki/Deficit_round_robin
      */
-    std::vector<TrafficClass*> DRR::GetQueues() const
+    Ptr<const Packet> DRR::Schedule() const
     {
-        return q_class;
+        uint32_t scheduledQueue = ScheduleQueue();
+
+        // If no queue was found, return nullptr
+        if (scheduledQueue == NO_QUEUE)
+        {
+            return nullptr;
+        }
+
+        // Return the packet from the front of the scheduled queue
+        return q_class[scheduledQueue]->Peek();
     }
 
     /**
-     * Dequeues the next scheduled packet and then updates
-     * the active_queue index and next_deficit_counter vector
-     * \returns packet that has been dequeued
+     * \ingroup diffserv
+     * \brief Selects the queue to be served next based on the DRR algorithm.
+     * \details Walks the active list from its head. The head keeps the turn while its deficit covers
+     * the head-of-line packet; every other queue gets its quantum when its turn comes. Instead of
+     * spinning laps until a deficit is large enough, the number of turns each queue still needs is
+     * computed directly, and the queue that needs the fewest turns (earliest in the list on a tie) wins.
+     * When quanta are at least one packet, the walk stops at the first or second queue.
+     * The decision is cached until a queue changes, and only CommitSchedule() updates the committed state.
+     * \returns The index of the scheduled queue, or NO_QUEUE if all queues are empty.
      */
-    Ptr<Packet> DRR::Dequeue()
+    uint32_t DRR::ScheduleQueue() const
     {
-        // Use Schedule to find the next packet to dequeue
-        Ptr<Packet> dequeuePkt = DiffServ::Dequeue();
-
-        // Check if the dequeue operation was successful
-        if (dequeuePkt)
+        // Reuse the cached decision if no queue changed since it was made
+        if (decisionValid)
         {
-            // Update the next active queue and quantum
-            // Basically, we are moving to the next queue
-            // and setting the quantum for the next round
-            currentQueue = nextQueue;
-            queueQuantum = tempDeficitCounter;
+            return decisionQueue;
+        }
+
+        decisionQueue = NO_QUEUE;
+        decisionLaps = 0;
+        decisionValid = true;
 
-            return dequeuePkt;
+        // Only backlogged queues are in the active list
+        if (activeHead == NO_QUEUE)
+        {
+            NS_LOG_UNCOND("All queues are empty.");
+            return NO_QUEUE;
         }
-        // If dequeue failed, log an error message
-        else 
+
+        uint32_t bestTurns = std::numeric_limits<uint32_t>::max();
+        uint32_t candidate = activeHead;
+        bool credited = headCredited;
+
+        do
+        {
+            uint32_t turns = TurnsNeeded(candidate, credited);
+
+            // Earlier queues in the list win ties, so only a strictly smaller count replaces the best
+            if (turns < bestTurns)
+            {
+                decisionQueue = candidate;
+                bestTurns = turns;
+
+                // Nothing later in the list can beat a queue that is served on this turn
+                if (turns == 0)
+                {
+                    break;
+                }
+            }
+
+            credited = false;
+            candidate = activeNext[candidate];
+        } while (candidate != activeHead);
+
+        if (decisionQueue == NO_QUEUE)
         {
-            NS_LOG_UNCOND("Dequeue failed: No packet to dequeue.");
+            NS_LOG_UNCOND("No backlogged queue has a positive weight.");
+            return NO_QUEUE;
         }
 
-        return nullptr;
+        decisionLaps = bestTurns;
+        return decisionQueue;
     }
 
     /**
      * \ingroup diffserv
-     * \brief Schedules the next packet to be dequeued based on the DRR algorithm.
-     * \details This function iterates through the queues and checks if the packet size is less than or equal to the quantum.
-     * If it is, the packet is dequeued and the counter is updated. The function continues until a packet is found or all queues are empty.
-     * \returns A pointer to the next scheduled packet. If no packet is found, returns nullptr.
-     * \note The function uses round-robin scheduling to ensure fair access to the queues.
-     * 
-     * Reference: https://en.wikipedia.org/wiki/Deficit_round_robin
+     * \brief Commits the cached decision before the scheduled packet is popped.
+     * \details Queues ahead of the served queue in the active list finish their turns without sending
+     * and keep the credit they received. The served queue becomes the head of the list, so the queues
+     * it passed move to the tail in order, exactly as in the Shreedhar-Varghese active list.
+     * \param index The queue returned by ScheduleQueue().
      */
-    Ptr<const Packet> DRR::Schedule() const
+    void DRR::CommitSchedule(uint32_t index)
     {
-        // get traffic class queues
-        std::vector<TrafficClass*> queues = GetQueues();
+        // Make sure the cached decision belongs to the queue being popped
+        if (!decisionValid || decisionQueue != index)
+        {
+            decisionValid = false;
+            if (ScheduleQueue() != index)
+            {
+                NS_LOG_UNCOND("DRR::CommitSchedule: queue " << index << " is not the scheduled queue.");
+                return;
+            }
+        }
+
+        uint64_t laps = decisionLaps;
+        uint32_t queue = activeHead;
+        bool credited = headCredited;
 
-        // check that there are queues to serve
-        if (queues.size() == 0)
+        // Queues ahead of the served queue use up (laps + 1) turns without sending
+        while (queue != index)
         {
-            NS_LOG_UNCOND("No queues to serve.");
-            return nullptr;
+            deficitCounter[queue] += GetQuantum(queue) * (laps + 1 - (credited ? 1 : 0));
+            credited = false;
+            queue = activeNext[queue];
         }
 
-        // Reset the next queue and quantum
-        nextQueue = currentQueue;
-        tempDeficitCounter = queueQuantum;
+        // The served queue receives its credit and pays for the head-of-line packet
+        uint64_t credit = deficitCounter[index] + GetQuantum(index) * (laps + 1 - (credited ? 1 : 0));
+        deficitCounter[index] = credit - q_class[index]->Peek()->GetSize();
 
-        // Check if the queues are empty
-        uint32_t empty_count = 0;
-        for (int i = 0; i < queues.size(); i++)
+        // Queues behind the served queue use up laps turns without sending
+        if (laps > 0)
         {
-            if (queues[i]->IsEmpty())
+            for (queue = activeNext[index]; queue != activeHead; queue = activeNext[queue])
             {
-                empty_count++;
+                deficitCounter[queue] += GetQuantum(queue) * laps;
             }
         }
 
-        // If all queues are empty, return nullptr
-        if (empty_count == queues.size())
+        // The served queue keeps the turn while its deficit covers its next packet
+        activeHead = index;
+        headCredited = true;
+        decisionValid = false;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Keeps the active list in sync with the queue and drops the cached decision.
+     * \details A queue that becomes backlogged is appended to the tail of the active list.
+     * A queue that becomes empty leaves the list and loses its remaining deficit.
+     * \param index The queue that changed.
+     */
+    void DRR::NotifyQueueChanged(uint32_t index)
+    {
+        decisionValid = false;
+
+        // A queue held by its shaper leaves the list like an empty one
+        bool backlogged = IsBacklogged(index);
+
+        if (backlogged && !isActive[index])
         {
-            NS_LOG_UNCOND("All queues are empty.");
-            return nullptr;
+            Activate(index);
         }
+        else if (!backlogged && isActive[index])
+        {
+            Deactivate(index);
+        }
+    }
 
-        // Iterate through the queues in a round-robin fashion
-        // and check if the packet size is less than or equal to the quantum
-        // If it is, dequeue the packet and update the quantum
-        // If not, move to the next queue
-        // and add the weight to the quantum
-        while (true)
+    /**
+     * \brief Returns the quantum of a queue, which is its configured weight in bytes.
+     */
+    uint32_t DRR::GetQuantum(uint32_t index) const
+    {
+        return static_cast<uint32_t>(q_class[index]->GetWeight());
+    }
+
+    /**
+     * \brief Computes how many more turns a queue needs before its head-of-line packet fits.
+     * \param index The queue to check.
+     * \param credited true if the queue already received the quantum for its current turn.
+     * \returns 0 if the queue can send on the current turn, or the max value if it can never send.
+     */
+    uint32_t DRR::TurnsNeeded(uint32_t index, bool credited) const
+    {
+        uint32_t packetSize = q_class[index]->Peek()->GetSize();
+        uint32_t deficit = deficitCounter[index];
+
+        // The deficit already covers the packet
+        if (packetSize <= deficit)
         {
-            if (!queues[nextQueue]->IsEmpty())
-            {
-                // Set the quantum for the next queue to the sum of the current quantum and the weight of the queue
-                tempDeficitCounter[nextQueue] = queues[nextQueue]->GetWeight() + tempDeficitCounter[nextQueue];
+            return 0;
+        }
 
-                // Get the packet size from the queue for the next queue
-                uint32_t packet_size = queues[nextQueue]->Peek()->GetSize();
+        uint32_t quantum = GetQuantum(index);
+        if (quantum == 0)
+        {
+            return std::numeric_limits<uint32_t>::max();
+        }
 
-                // Check if the packet size is less than or equal to the quantum
-                if (packet_size <= tempDeficitCounter[nextQueue])
-                {
-                    // Dequeue the packet and update the quantum
-                    tempDeficitCounter[nextQueue] = tempDeficitCounter[nextQueue] - packet_size;
+        // Turns with a fresh quantum needed to cover the missing bytes (rounded up)
+        uint32_t creditedTurns = (packetSize - deficit + quantum - 1) / quantum;
 
-                    // Return a the the packet from the front of the queue
-                    return queues[nextQueue]->Peek();
-                }
-            }
+        // If the current turn was already credited, the first fresh quantum comes on the next turn
+        return creditedTurns - 1 + (credited ? 1 : 0);
+    }
 
-            // Set the next queue to the next one in the round-robin fashion
-            nextQueue = (nextQueue + 1) % queues.size();
+    /**
+     * \brief Appends a queue to the tail of the active list.
+     */
+    void DRR::Activate(uint32_t index)
+    {
+        isActive[index] = true;
+
+        if (activeHead == NO_QUEUE)
+        {
+            activeHead = index;
+            activeNext[index] = index;
+            activePrev[index] = index;
+            headCredited = false;
+            return;
+        }
+
+        // The tail is the queue just before the head in the circular list
+        uint32_t tail = activePrev[activeHead];
+        activeNext[tail] = index;
+        activePrev[index] = tail;
+        activeNext[index] = activeHead;
+        activePrev[activeHead] = index;
+    }
+
+    /**
+     * \brief Removes a queue from the active list and resets its deficit.
+     */
+    void DRR::Deactivate(uint32_t index)
+    {
+        isActive[index] = false;
+        deficitCounter[index] = 0;
+
+        if (activeNext[index] == index)
+        {
+            // The queue was the only backlogged one
+            activeHead = NO_QUEUE;
         }
+        else
+        {
+            activeNext[activePrev[index]] = activeNext[index];
+            activePrev[activeNext[index]] = activePrev[index];
 
-        // If no packet is found, return nullptr
-        NS_LOG_UNCOND("No packet found in the queues.");
-        return nullptr;
+            // If the head emptied, its turn passes to the next queue
+            if (activeHead == index)
+            {
+                activeHead = activeNext[index];
+                headCredited = false;
+            }
+        }
+
+        activeNext[index] = NO_QUEUE;
+        activePrev[index] = NO_QUEUE;
     }
 
     /**
@@ -150,6 +289,16 @@ namespace ns3 {
     void DRR::RegisterQueue(TrafficClass* trafficClass)
     {
         DiffServ::RegisterQueue(trafficClass);
-        queueQuantum.push_back(0);
+        deficitCounter.push_back(0);
+        activeNext.push_back(NO_QUEUE);
+        activePrev.push_back(NO_QUEUE);
+        isActive.push_back(false);
+        decisionValid = false;
+
+        // A class registered with packets already queued joins the active list right away
+        if (IsBacklogged(q_class.size() - 1))
+        {
+            Activate(q_class.size() - 1);
+        }
     }
 } // namespace ns3
\ No newline at end of file
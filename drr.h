@@ -11,6 +11,8 @@ namespace ns3 {
      *
      * This class implements the DRR scheduling algorithm, which distributes
      * bandwidth across multiple traffic classes according to their weight.
+     * Only backlogged classes sit in the active list (Shreedhar & Varghese), so the
+     * cost of a decision does not depend on the number of configured classes.
      */
     class DRR : public DiffServ
     {
@@ -18,43 +20,82 @@ namespace ns3 {
         DRR();
         ~DRR() override = default;
 
-        /**
-         * \brief Dequeue the packet selected by the DRR scheduling logic.
-         * \returns Ptr<Packet> dequeued packet or nullptr if none available.
-         */
-        Ptr<Packet> Dequeue() override;
-
         /**
          * \brief Select the next packet to be dequeued based on DRR.
          * \returns Ptr<const Packet> packet at the front of the scheduled queue.
          */
         Ptr<const Packet> Schedule() const override;
 
+        /**
+         * \brief Select the queue to be served next based on DRR.
+         * \returns The index of the scheduled queue, or NO_QUEUE if all queues are empty.
+         */
+        uint32_t ScheduleQueue() const override;
+
         /**
          * \brief Add a new TrafficClass to the DRR.
          * \param trafficClass pointer to the TrafficClass instance.
          */
         void RegisterQueue(TrafficClass* trafficClass) override;
 
+    protected:
+        /**
+         * \brief Commit the cached DRR decision (active list and deficit counters) for the served queue.
+         * \param index The queue returned by ScheduleQueue().
+         */
+        void CommitSchedule(uint32_t index) override;
+
+        /**
+         * \brief Keep the active list in sync with the queues and drop the cached decision.
+         * \param index The queue that changed.
+         */
+        void NotifyQueueChanged(uint32_t index) override;
+
     private:
-        // The current queue index being served
-        uint32_t currentQueue;
+        // Committed deficit counter (byte credit) for each queue
+        std::vector<uint32_t> deficitCounter;
+
+        // Active list: circular doubly linked list of the backlogged queues, in service order.
+        // activeHead is the queue currently holding the turn (NO_QUEUE when nothing is backlogged).
+        std::vector<uint32_t> activeNext;
+        std::vector<uint32_t> activePrev;
+        std::vector<bool> isActive;
+        uint32_t activeHead;
+
+        // true once the head queue has received the quantum for its current turn
+        bool headCredited;
 
-        // The next queue index to be served
-        mutable uint32_t nextQueue; 
+        // Cached scheduling decision, valid until a queue changes or the decision is committed.
+        // Schedule(), Peek() and Dequeue() all reuse it, so the DRR decision runs once per packet.
+        mutable bool decisionValid;
+        mutable uint32_t decisionQueue;
 
-        // The official quantum for each queue that has been committed
-        std::vector<uint32_t> queueQuantum; 
+        // Number of complete turns every active queue is skipped through before decisionQueue is served.
+        // This is non-zero only when the quanta are smaller than the head-of-line packets.
+        mutable uint32_t decisionLaps;
+
+        /**
+         * \brief Get the quantum (weight in bytes) of a queue.
+         */
+        uint32_t GetQuantum(uint32_t index) const;
 
-        // This is a working array to keep track of the quantum for each queue while searching for the next candidate queue
-        mutable std::vector<uint32_t> tempDeficitCounter;
+        /**
+         * \brief Number of extra turns a queue needs before its head-of-line packet fits its deficit.
+         * \param index The queue to check.
+         * \param credited true if the quantum for the current turn has already been added.
+         */
+        uint32_t TurnsNeeded(uint32_t index, bool credited) const;
+
+        /**
+         * \brief Append a queue to the tail of the active list.
+         */
+        void Activate(uint32_t index);
 
         /**
-         * \brief Get the list of queues in the DiffServ class.
-         * \returns A vector of pointers to TrafficClass objects.
+         * \brief Unlink a queue from the active list and reset its deficit.
          */
-        std::vector<TrafficClass*> GetQueues() const;
+        void Deactivate(uint32_t index);
     };
 } // namespace ns3
 
-#endif // DRR_H
\ No newline at end of file
+#endif // DRR_H
@@ -0,0 +1,46 @@
+#include "dscp-filter-element.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE("DscpFilterElement");
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Constructor for DscpFilterElement.
+     * \param dscp The DSCP codepoint to match.
+     */
+    DscpFilterElement::DscpFilterElement(uint8_t dscp): m_dscp(dscp) {}
+
+    /**
+     * \ingroup diffserv
+     * \brief Match the packet against the stored DSCP codepoint.
+     * \param key The parsed header view of the packet to inspect.
+     * \returns true if the DSCP codepoint matches, false otherwise.
+     */
+    bool
+    DscpFilterElement::Match(const FlowKey& key) const
+    {
+        // If the IPv4 header could not be read, the packet doesn't match.
+        if (!key.hasIpv4)
+        {
+            return false;
+        }
+
+        // Compare the DSCP bits of the ToS field
+        return key.dscp == m_dscp;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Describe the element as an exact match on the DSCP codepoint.
+     * \param field Set to FlowField::DSCP.
+     * \param value Set to the DSCP codepoint to match.
+     * \returns true
+     */
+    bool DscpFilterElement::GetExactMatch(FlowField& field, uint32_t& value) const
+    {
+        field = FlowField::DSCP;
+        value = m_dscp;
+        return true;
+    }
+} // namespace ns3
@@ -0,0 +1,42 @@
+#ifndef DSCP_FILTER_ELEMENT_H
+#define DSCP_FILTER_ELEMENT_H
+
+#include "ns3/packet.h"
+#include "ns3/object.h"
+#include "filter-element.h"
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Class to determine if the specified DSCP codepoint is in the packet IP Header.
+     */
+    class DscpFilterElement : public FilterElement
+    {
+        public:
+            using FilterElement::Match;
+
+            /**
+             * \brief Constructor.
+             * \param dscp The DSCP codepoint to match (the upper 6 bits of the ToS byte, e.g. 46 = EF).
+             */
+            DscpFilterElement(uint8_t dscp);
+
+            /**
+             * \brief Match the packet against the stored DSCP codepoint.
+             * \param key The parsed header view of the packet to check for the DSCP match.
+             * \returns true if the DSCP codepoint is the same, false otherwise.
+             */
+            bool Match(const FlowKey& key) const override;
+
+            /**
+             * \brief Describe the element as an exact match on the DSCP codepoint.
+             * \returns true, so DiffServ can index the element.
+             */
+            bool GetExactMatch(FlowField& field, uint32_t& value) const override;
+
+        private:
+            uint8_t m_dscp;
+    };
+} // namespace ns3
+
+#endif // DSCP_FILTER_ELEMENT_H
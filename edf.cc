@@ -0,0 +1,196 @@
+#include "edf.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "scheduling-tag.h"
+#include <algorithm>
+
+/**
+ * EDF Algorithm Reference:
+ *
+ * Liu, C. L., & Layland, J. W. (1973). Scheduling Algorithms for Multiprogramming in a Hard-Real-Time
+ * Environment. Journal of the ACM, 20(1), 46–61. https://doi.org/10.1145/321738.321743
+ */
+
+namespace ns3 {
+    EDF::EDF() {}
+
+    /**
+     * \ingroup diffserv
+     * \brief Schedules the head-of-line packet with the earliest deadline.
+     * \returns A pointer to the next scheduled packet. If no packet is found, returns nullptr.
+     */
+    Ptr<const Packet> EDF::Schedule() const
+    {
+        uint32_t scheduledQueue = ScheduleQueue();
+
+        // If no queue was found, return nullptr
+        if (scheduledQueue == NO_QUEUE)
+        {
+            return nullptr;
+        }
+
+        // Return the packet from the front of the scheduled queue
+        return q_class[scheduledQueue]->Peek();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Selects the backlogged queue whose head-of-line packet has the earliest deadline.
+     * \returns The index of the scheduled queue, or NO_QUEUE if all queues are empty.
+     */
+    uint32_t EDF::ScheduleQueue() const
+    {
+        if (heads.IsEmpty())
+        {
+            return NO_QUEUE;
+        }
+
+        return heads.Top();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Adds a new TrafficClass to the EDF scheduler.
+     * \details Packets queued before the class was registered are stamped when they reach its
+     * head, as if they arrived then.
+     */
+    void EDF::RegisterQueue(TrafficClass* trafficClass)
+    {
+        DiffServ::RegisterQueue(trafficClass);
+
+        served.push_back(0);
+        misses.push_back(0);
+        maxLateness.push_back(Time());
+        totalLateness.push_back(Time());
+        heads.Resize(q_class.size());
+        NotifyQueueChanged(q_class.size() - 1);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Counts the served packet and checks it against its deadline.
+     * \details The queue leaves the heap and is keyed again by its new head in NotifyQueueChanged(),
+     * once the packet is popped.
+     */
+    void EDF::CommitSchedule(uint32_t index)
+    {
+        Ptr<const Packet> head = q_class[index]->Peek();
+        SchedulingTag tag;
+        if (head && ConstCast<Packet>(head)->RemovePacketTag(tag))
+        {
+            Time lateness = Simulator::Now() - NanoSeconds(tag.GetValue());
+            served[index]++;
+            if (lateness > Time())
+            {
+                misses[index]++;
+                maxLateness[index] = std::max(maxLateness[index], lateness);
+                totalLateness[index] += lateness;
+            }
+        }
+
+        heads.Erase(index);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Keeps the heap in step with the queues.
+     * \details A queue that enters the heap is keyed by the deadline of its head, which is stamped
+     * here if it has none yet. A queue already in the heap keeps its key; an enqueue that changed
+     * its head re-keys it in NotifyEnqueued().
+     */
+    void EDF::NotifyQueueChanged(uint32_t index)
+    {
+        if (IsBacklogged(index))
+        {
+            if (!heads.Contains(index))
+            {
+                heads.Push(index, Stamp(index, q_class[index]->Peek()));
+            }
+        }
+        else
+        {
+            heads.Erase(index);
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Stamps the packet just queued with now + the class's delay budget.
+     * \details A class with flow sub-queues may have dropped packets of its longest flow to admit
+     * this one, head included, so the queue is keyed again by the deadline of its head.
+     */
+    void EDF::NotifyEnqueued(uint32_t index, Ptr<const Packet> pkt)
+    {
+        Stamp(index, pkt);
+
+        if (IsBacklogged(index))
+        {
+            heads.Push(index, Stamp(index, q_class[index]->Peek()));
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Returns the deadline (in ns) tagged on a queued packet, stamping it first if it has none.
+     */
+    uint64_t EDF::Stamp(uint32_t index, Ptr<const Packet> pkt)
+    {
+        SchedulingTag tag;
+        if (!pkt->PeekPacketTag(tag))
+        {
+            int64_t deadline = (Simulator::Now() + q_class[index]->GetDelayBudget()).GetNanoSeconds();
+            tag.SetValue(std::max<int64_t>(deadline, 0));
+            pkt->AddPacketTag(tag);
+        }
+
+        return tag.GetValue();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the deadline of a queue's head-of-line packet.
+     */
+    Time EDF::GetHeadDeadline(uint32_t index) const
+    {
+        Ptr<const Packet> head = q_class[index]->Peek();
+        SchedulingTag tag;
+        return head && head->PeekPacketTag(tag) ? NanoSeconds(tag.GetValue()) : Time();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of packets a queue has had served.
+     */
+    uint64_t EDF::GetServed(uint32_t index) const
+    {
+        return served[index];
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of packets of a queue served after their deadline.
+     */
+    uint64_t EDF::GetDeadlineMisses(uint32_t index) const
+    {
+        return misses[index];
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the largest deadline miss of a queue.
+     */
+    Time EDF::GetMaxLateness(uint32_t index) const
+    {
+        return maxLateness[index];
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the summed deadline misses of a queue.
+     */
+    Time EDF::GetTotalLateness(uint32_t index) const
+    {
+        return totalLateness[index];
+    }
+} // namespace ns3
@@ -0,0 +1,103 @@
+#ifndef EDF_H
+#define EDF_H
+
+#include "diff-serv.h"
+#include "class-heap.h"
+#include "scheduling-tag.h"
+#include "ns3/nstime.h"
+#include <vector>
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief EDF (Earliest Deadline First) scheduler extending DiffServ
+     *
+     * Every packet is stamped on arrival with the absolute deadline arrival time + the delay budget
+     * of its class (TrafficClass::SetDelayBudget), and the head-of-line packet with the earliest
+     * deadline is served. Each packet carries its deadline in a SchedulingTag and only the class
+     * heads sit in a min-heap (ClassHeap): a decision is the top of the heap and every update
+     * O(log n). Deadlines never decrease within a FIFO class; a class with flow sub-queues is keyed
+     * by the deadline of whichever packet its flows put at the head.
+     *
+     * A packet that leaves the scheduler after its deadline counts as a miss of its class, along
+     * with how late it was, so a run shows whether the budgets can be met at the offered load.
+     *
+     * \note Deadlines bound the time spent in this queue; the transmission that follows is not included.
+     * Packets must be enqueued through the scheduler so they are stamped.
+     */
+    class EDF : public DiffServ
+    {
+    public:
+        EDF();
+        ~EDF() override = default;
+
+        /**
+         * \brief Select the next packet to be dequeued based on EDF.
+         * \returns Ptr<const Packet> packet at the front of the scheduled queue.
+         */
+        Ptr<const Packet> Schedule() const override;
+
+        /**
+         * \brief Select the backlogged queue whose head-of-line packet has the earliest deadline.
+         * \returns The index of the scheduled queue, or NO_QUEUE if all queues are empty.
+         */
+        uint32_t ScheduleQueue() const override;
+
+        /**
+         * \brief Add a new TrafficClass to the EDF scheduler.
+         * \param trafficClass pointer to the TrafficClass instance.
+         */
+        void RegisterQueue(TrafficClass* trafficClass) override;
+
+        /**
+         * \brief Deadline of the head-of-line packet of a queue (zero when it holds no stamped packet).
+         */
+        Time GetHeadDeadline(uint32_t index) const;
+
+        /**
+         * \brief Deadline counters of a queue: packets served, packets served after their deadline,
+         * and the largest and total time by which a deadline was missed.
+         */
+        uint64_t GetServed(uint32_t index) const;
+        uint64_t GetDeadlineMisses(uint32_t index) const;
+        Time GetMaxLateness(uint32_t index) const;
+        Time GetTotalLateness(uint32_t index) const;
+
+    protected:
+        /**
+         * \brief Check the served packet against its deadline and drop its stamp.
+         * \param index The queue returned by ScheduleQueue().
+         */
+        void CommitSchedule(uint32_t index) override;
+
+        /**
+         * \brief Key a queue by its new head deadline, or take it out once it is idle or held.
+         * \param index The queue that changed.
+         */
+        void NotifyQueueChanged(uint32_t index) override;
+
+        /**
+         * \brief Stamp the packet just queued with its deadline.
+         * \param index The queue that took the packet.
+         * \param pkt The packet.
+         */
+        void NotifyEnqueued(uint32_t index, Ptr<const Packet> pkt) override;
+
+    private:
+        // Backlogged queues by head deadline
+        ClassHeap heads;
+
+        // Deadline counters per queue
+        std::vector<uint64_t> served;
+        std::vector<uint64_t> misses;
+        std::vector<Time> maxLateness;
+        std::vector<Time> totalLateness;
+
+        /**
+         * \brief Deadline (in ns) of a queued packet, stamping it first if it has none yet.
+         */
+        uint64_t Stamp(uint32_t index, Ptr<const Packet> pkt);
+    };
+} // namespace ns3
+
+#endif // EDF_H
@@ -0,0 +1,71 @@
+#include "exact-match-index.h"
+#include <algorithm>
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Removes every rule from the index.
+     */
+    void ExactMatchIndex::Clear()
+    {
+        m_tables.clear();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Adds an exact-match rule to the table of its header field.
+     */
+    void ExactMatchIndex::Insert(FlowField field, uint32_t value, uint32_t classIndex)
+    {
+        // Find the table for this field, or create it
+        auto table = std::find_if(m_tables.begin(), m_tables.end(),
+                                  [field](const auto& entry) { return entry.first == field; });
+        if (table == m_tables.end())
+        {
+            m_tables.emplace_back(field, std::unordered_map<uint32_t, uint32_t>());
+            table = m_tables.end() - 1;
+        }
+
+        // Keep the first registered class for a value
+        auto inserted = table->second.emplace(value, classIndex);
+        if (!inserted.second)
+        {
+            inserted.first->second = std::min(inserted.first->second, classIndex);
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Probes the table of every indexed field and keeps the lowest class index.
+     */
+    uint32_t ExactMatchIndex::Lookup(const FlowKey& key) const
+    {
+        uint32_t best = NO_MATCH;
+
+        for (const auto& table : m_tables)
+        {
+            // Packets that lack the field never match its rules
+            if (!key.Has(table.first))
+            {
+                continue;
+            }
+
+            auto hit = table.second.find(key.Get(table.first));
+            if (hit != table.second.end())
+            {
+                best = std::min(best, hit->second);
+            }
+        }
+
+        return best;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Checks if no rules are indexed.
+     */
+    bool ExactMatchIndex::IsEmpty() const
+    {
+        return m_tables.empty();
+    }
+} // namespace ns3
@@ -0,0 +1,56 @@
+#ifndef EXACT_MATCH_INDEX_H
+#define EXACT_MATCH_INDEX_H
+
+#include <vector>
+#include <unordered_map>
+#include <limits>
+#include "flow-key.h"
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Hash index from exact header field values to traffic class indexes.
+     *
+     * DiffServ builds one of these from every filter that is a single exact-match element
+     * (e.g. one DestinationPortNumber). There is one hash table per header field, so a
+     * lookup costs one probe per indexed field no matter how many rules are configured.
+     */
+    class ExactMatchIndex
+    {
+        public:
+            // Returned by Lookup() when no indexed rule matches
+            static constexpr uint32_t NO_MATCH = std::numeric_limits<uint32_t>::max();
+
+            /**
+             * \brief Remove every rule.
+             */
+            void Clear();
+
+            /**
+             * \brief Add a rule. If the value is already indexed, the lowest class index is kept
+             * so the first registered class still wins.
+             * \param field The header field the rule tests.
+             * \param value The value the field must equal.
+             * \param classIndex The index of the traffic class that owns the rule.
+             */
+            void Insert(FlowField field, uint32_t value, uint32_t classIndex);
+
+            /**
+             * \brief Find the lowest class index with a rule matching the packet.
+             * \param key The parsed header view of the packet.
+             * \returns The class index, or NO_MATCH.
+             */
+            uint32_t Lookup(const FlowKey& key) const;
+
+            /**
+             * \brief Check if no rules are indexed.
+             */
+            bool IsEmpty() const;
+
+        private:
+            // One table per header field that has at least one rule
+            std::vector<std::pair<FlowField, std::unordered_map<uint32_t, uint32_t>>> m_tables;
+    };
+} // namespace ns3
+
+#endif // EXACT_MATCH_INDEX_H
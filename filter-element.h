@@ -3,6 +3,7 @@
 
 #include "ns3/packet.h"
 #include "ns3/object.h"
+#include "flow-key.h"
 
 namespace ns3 {
     /**
@@ -12,12 +13,48 @@ namespace ns3 {
     class FilterElement : public Object
     {
         public:
+            /**
+             * \brief Decide if the parsed packet headers match the filter element.
+             * \param key The header view parsed once per packet by DiffServ::Classify.
+             * \return true if the packet matches, false otherwise.
+             */
+            virtual bool Match(const FlowKey& key) const = 0;
+
             /**
              * \brief Decide if there is a packet against the filter element.
+             * \details Convenience overload that parses the packet and calls Match(FlowKey).
              * \param pkt The packet to evaluate.
              * \return true if the packet matches, false otherwise.
              */
-            virtual bool Match(Ptr<Packet> pkt) const = 0;
+            bool Match(Ptr<Packet> pkt) const
+            {
+                return Match(FlowKey::Parse(pkt));
+            }
+
+            /**
+             * \brief Describe the element as a single header field test.
+             * \param field Set to the header field the element tests.
+             * \param value Set to the value the field must equal.
+             * \return true if the element is an exact match on one field and can be indexed.
+             * \details DiffServ uses this to build its classifier indexes. Elements that return
+             * false (the default) are always evaluated with Match().
+             */
+            virtual bool GetExactMatch(FlowField& field, uint32_t& value) const
+            {
+                return false;
+            }
+
+            /**
+             * \brief Describe the element as an address prefix test.
+             * \param field Set to the address field the element tests.
+             * \param prefix Set to the address prefix (host order, host bits cleared).
+             * \param length Set to the prefix length in bits.
+             * \return true if the element is a contiguous prefix match and can go in a prefix trie.
+             */
+            virtual bool GetPrefixMatch(FlowField& field, uint32_t& prefix, uint8_t& length) const
+            {
+                return false;
+            }
 
             /**
              * \brief Virtual Destructor. Must be overriden. 
@@ -35,10 +35,20 @@ namespace ns3 {
      * @return true if the packet matches all filter elements.
      */
     bool Filter::Match(Ptr<Packet> packet) {
+        // Parse the headers once and share them with every filter element
+        return Match(FlowKey::Parse(packet));
+    }
+
+    /**
+     * Matches a parsed packet against all (every single) filter elements.
+     * @param key The parsed header view of the packet.
+     * @return true if the packet matches all filter elements.
+     */
+    bool Filter::Match(const FlowKey& key) const {
         for (auto filterElement : m_filterElements) {
 
             // Check if the filter element matches the packet
-            if (!filterElement->Match(packet)) {
+            if (!filterElement->Match(key)) {
 
                 NS_LOG_INFO("Filter::Match: Packet does not match filter element.");
                 return false;
@@ -48,4 +58,12 @@ namespace ns3 {
         NS_LOG_INFO("Filter::Match: Packet matches all filter elements.");
         return true;
     }
+
+    /**
+     * Gets the filter elements.
+     * @return The filter elements in the order they were added.
+     */
+    const std::vector<FilterElement*>& Filter::GetFilterElements() const {
+        return m_filterElements;
+    }
 } // namespace ns3
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <vector>
 #include <memory>
 #include "filter-element.h"
+#include "flow-key.h"
 
 namespace ns3 {
 
@@ -41,6 +42,19 @@ namespace ns3 {
          */
         bool Match(Ptr<Packet> packet);
 
+        /**
+         * \brief Check if the parsed packet headers match the filter elements.
+         * \param key The header view parsed once per packet by DiffServ::Classify.
+         * \return true if the packet matches all filter elements, false if not.
+         */
+        bool Match(const FlowKey& key) const;
+
+        /**
+         * \brief Get the filter elements (used by DiffServ to build its classifier indexes).
+         * \return The filter elements in the order they were added.
+         */
+        const std::vector<FilterElement*>& GetFilterElements() const;
+
     private:
         std::vector<FilterElement*> m_filterElements;
     };
@@ -0,0 +1,176 @@
+#include "flow-cache.h"
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Constructor for FlowCache.
+     */
+    FlowCache::FlowCache(uint32_t capacity)
+    {
+        SetCapacity(capacity);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Resizes the cache to the power of two at or above the requested capacity.
+     * \details The entries are allocated here once, so lookups and inserts never allocate.
+     */
+    void FlowCache::SetCapacity(uint32_t capacity)
+    {
+        m_entries.clear();
+        m_hands.clear();
+        m_setMask = 0;
+        m_epoch = 1;
+
+        if (capacity == 0)
+        {
+            return;
+        }
+
+        uint32_t sets = 1;
+        while (sets * WAYS < capacity)
+        {
+            sets <<= 1;
+        }
+
+        m_entries.assign(sets * WAYS, Entry());
+        m_hands.assign(sets, 0);
+        m_setMask = sets - 1;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of entries.
+     */
+    uint32_t FlowCache::GetCapacity() const
+    {
+        return m_entries.size();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Checks if a valid entry holds the flow of the key.
+     */
+    bool FlowCache::Holds(const Entry& entry, const FlowKey& key) const
+    {
+        return entry.epoch == m_epoch &&
+               entry.sourceAddress == key.sourceAddress.Get() &&
+               entry.destinationAddress == key.destinationAddress.Get() &&
+               entry.sourcePort == key.sourcePort &&
+               entry.destinationPort == key.destinationPort &&
+               entry.protocol == key.protocol &&
+               entry.dscp == key.dscp;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Looks the flow up in its set and gives a hit entry a second chance.
+     */
+    bool FlowCache::Lookup(const FlowKey& key, uint32_t& classIndex)
+    {
+        if (m_entries.empty())
+        {
+            return false;
+        }
+
+        Entry* set = &m_entries[(key.Hash() & m_setMask) * WAYS];
+        for (uint32_t way = 0; way < WAYS; ++way)
+        {
+            if (Holds(set[way], key))
+            {
+                set[way].referenced = true;
+                classIndex = set[way].classIndex;
+                m_hits++;
+                return true;
+            }
+        }
+
+        m_misses++;
+        return false;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Stores the flow in a free way of its set, or evicts with the clock hand.
+     * \details The hand skips (and clears) entries referenced since it last passed, so a flow
+     * that keeps sending survives while one-off flows are evicted first.
+     */
+    void FlowCache::Insert(const FlowKey& key, uint32_t classIndex)
+    {
+        if (m_entries.empty())
+        {
+            return;
+        }
+
+        uint32_t setIndex = key.Hash() & m_setMask;
+        Entry* set = &m_entries[setIndex * WAYS];
+
+        // Prefer a free (stale) way
+        uint32_t victim = WAYS;
+        for (uint32_t way = 0; way < WAYS; ++way)
+        {
+            if (set[way].epoch != m_epoch)
+            {
+                victim = way;
+                break;
+            }
+        }
+
+        // Otherwise run the clock hand of the set
+        if (victim == WAYS)
+        {
+            uint8_t& hand = m_hands[setIndex];
+            while (set[hand].referenced)
+            {
+                set[hand].referenced = false;
+                hand = (hand + 1) % WAYS;
+            }
+            victim = hand;
+            hand = (hand + 1) % WAYS;
+        }
+
+        Entry& entry = set[victim];
+        entry.sourceAddress = key.sourceAddress.Get();
+        entry.destinationAddress = key.destinationAddress.Get();
+        entry.sourcePort = key.sourcePort;
+        entry.destinationPort = key.destinationPort;
+        entry.protocol = key.protocol;
+        entry.dscp = key.dscp;
+        entry.referenced = false;
+        entry.epoch = m_epoch;
+        entry.classIndex = classIndex;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Drops every entry by moving to a new epoch.
+     */
+    void FlowCache::Invalidate()
+    {
+        m_epoch++;
+
+        // On wrap-around old entries could look current again, so clear them for real
+        if (m_epoch == 0)
+        {
+            SetCapacity(m_entries.size());
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of hits.
+     */
+    uint64_t FlowCache::GetHits() const
+    {
+        return m_hits;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of misses.
+     */
+    uint64_t FlowCache::GetMisses() const
+    {
+        return m_misses;
+    }
+} // namespace ns3
@@ -0,0 +1,90 @@
+#ifndef FLOW_CACHE_H
+#define FLOW_CACHE_H
+
+#include <vector>
+#include <cstdint>
+#include "flow-key.h"
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Bounded cache from a flow's 5-tuple and DSCP to the traffic class it was classified into.
+     *
+     * The cache is set associative: the 5-tuple hash picks a set of WAYS entries, and a full set
+     * evicts with the clock (second chance) policy. Entries store the whole 5-tuple and the DSCP (a flow can be re-marked), so a hash
+     * collision is a miss, never a wrong class. Invalidate() bumps an epoch instead of walking
+     * the table, so dropping every entry after a rule change is O(1).
+     */
+    class FlowCache
+    {
+        public:
+            /**
+             * \brief Constructor.
+             * \param capacity Number of entries (rounded up to a power of two); 0 disables the cache.
+             */
+            explicit FlowCache(uint32_t capacity = 0);
+
+            /**
+             * \brief Resize the cache. Drops every entry.
+             */
+            void SetCapacity(uint32_t capacity);
+            uint32_t GetCapacity() const;
+
+            /**
+             * \brief Look up the class of a flow.
+             * \param key The parsed header view of the packet.
+             * \param classIndex Set to the cached class on a hit.
+             * \returns true on a hit.
+             */
+            bool Lookup(const FlowKey& key, uint32_t& classIndex);
+
+            /**
+             * \brief Remember the class of a flow, evicting an entry of its set if needed.
+             */
+            void Insert(const FlowKey& key, uint32_t classIndex);
+
+            /**
+             * \brief Drop every entry (the rules changed).
+             */
+            void Invalidate();
+
+            /**
+             * \brief Hit and miss counters, for sizing the cache.
+             */
+            uint64_t GetHits() const;
+            uint64_t GetMisses() const;
+
+        private:
+            static constexpr uint32_t WAYS = 4;
+
+            struct Entry
+            {
+                uint32_t sourceAddress = 0;
+                uint32_t destinationAddress = 0;
+                uint16_t sourcePort = 0;
+                uint16_t destinationPort = 0;
+                uint8_t protocol = 0;
+                uint8_t dscp = 0;
+                bool referenced = false;
+                uint32_t epoch = 0;
+                uint32_t classIndex = 0;
+            };
+
+            /**
+             * \brief Check if a valid entry holds the flow of the key.
+             */
+            bool Holds(const Entry& entry, const FlowKey& key) const;
+
+            std::vector<Entry> m_entries;
+            std::vector<uint8_t> m_hands;
+            uint32_t m_setMask = 0;
+
+            // Entries from an older epoch are invalid; epoch 0 is never current
+            uint32_t m_epoch = 1;
+
+            uint64_t m_hits = 0;
+            uint64_t m_misses = 0;
+    };
+} // namespace ns3
+
+#endif // FLOW_CACHE_H
@@ -0,0 +1,153 @@
+#include "ns3/ipv4-header.h"
+#include "ns3/tcp-header.h"
+#include "ns3/udp-header.h"
+#include "ns3/ppp-header.h"
+#include "ns3/log.h"
+#include "flow-key.h"
+
+NS_LOG_COMPONENT_DEFINE("FlowKey");
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Parse the headers of a packet into a FlowKey.
+     * \details The packet is copied once so the PPP and IPv4 headers can be stripped
+     * without modifying the original. Fields that cannot be read are left at their defaults
+     * and the hasIpv4 / hasPorts flags are cleared.
+     * \param pkt The packet to parse.
+     * \returns The parsed header view.
+     */
+    FlowKey FlowKey::Parse(Ptr<const Packet> pkt)
+    {
+        FlowKey key;
+        key.length = pkt->GetSize();
+
+        // Make a single copy of the packet to avoid modifying the original
+        Ptr<Packet> packetCopy = pkt->Copy();
+
+        Ipv4Header ipv4Header;
+        PppHeader pppHeader;
+
+        if (!packetCopy->RemoveHeader(pppHeader))
+        {
+            NS_LOG_WARN("Packet does not contain PPP header");
+            return key;
+        }
+
+        if (!packetCopy->RemoveHeader(ipv4Header))
+        {
+            NS_LOG_WARN("Packet does not contain IPv4 header");
+            return key;
+        }
+
+        key.hasIpv4 = true;
+        key.sourceAddress = ipv4Header.GetSource();
+        key.destinationAddress = ipv4Header.GetDestination();
+        key.protocol = ipv4Header.GetProtocol();
+        key.dscp = static_cast<uint8_t>(ipv4Header.GetDscp());
+
+        // Read the ports if the protocol is TCP (6) or UDP (17)
+        if (key.protocol == 6)
+        {
+            TcpHeader tcpHeader;
+            if (!packetCopy->PeekHeader(tcpHeader))
+            {
+                NS_LOG_WARN("Packet does not contain TCP header");
+                return key;
+            }
+
+            key.sourcePort = tcpHeader.GetSourcePort();
+            key.destinationPort = tcpHeader.GetDestinationPort();
+            key.hasPorts = true;
+        }
+        else if (key.protocol == 17)
+        {
+            UdpHeader udpHeader;
+            if (!packetCopy->PeekHeader(udpHeader))
+            {
+                NS_LOG_WARN("Packet does not contain UDP header");
+                return key;
+            }
+
+            key.sourcePort = udpHeader.GetSourcePort();
+            key.destinationPort = udpHeader.GetDestinationPort();
+            key.hasPorts = true;
+        }
+
+        return key;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Check if the packet carries a header field.
+     * \param field The field to check.
+     * \returns true if the field was parsed from the packet.
+     */
+    bool FlowKey::Has(FlowField field) const
+    {
+        switch (field)
+        {
+            case FlowField::SOURCE_ADDRESS:
+            case FlowField::DESTINATION_ADDRESS:
+            case FlowField::PROTOCOL:
+            case FlowField::DSCP:
+                return hasIpv4;
+            case FlowField::SOURCE_PORT:
+            case FlowField::DESTINATION_PORT:
+                return hasPorts;
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Read a header field as an integer.
+     * \param field The field to read.
+     * \returns The field value (addresses in host order), or 0 for FlowField::NONE.
+     */
+    uint32_t FlowKey::Get(FlowField field) const
+    {
+        switch (field)
+        {
+            case FlowField::SOURCE_ADDRESS:
+                return sourceAddress.Get();
+            case FlowField::DESTINATION_ADDRESS:
+                return destinationAddress.Get();
+            case FlowField::SOURCE_PORT:
+                return sourcePort;
+            case FlowField::DESTINATION_PORT:
+                return destinationPort;
+            case FlowField::PROTOCOL:
+                return protocol;
+            case FlowField::DSCP:
+                return dscp;
+            default:
+                return 0;
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Hash the 5-tuple and the DSCP.
+     * \details The fields are folded into 64 bits and finished with the MurmurHash3 mixer,
+     * so flows that differ in a single bit still land far apart.
+     * \param seed Mixed into the hash.
+     * \returns The 32-bit hash.
+     */
+    uint32_t FlowKey::Hash(uint32_t seed) const
+    {
+        uint64_t h = (static_cast<uint64_t>(sourceAddress.Get()) << 32) | destinationAddress.Get();
+        h ^= (static_cast<uint64_t>(sourcePort) << 40) ^ (static_cast<uint64_t>(destinationPort) << 16) ^ protocol;
+        h ^= static_cast<uint64_t>(dscp) << 8;
+        h ^= static_cast<uint64_t>(seed) * 0x9e3779b97f4a7c15ULL;
+
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb93fe53b3e6fULL;
+        h ^= h >> 33;
+
+        return static_cast<uint32_t>(h);
+    }
+} // namespace ns3
@@ -0,0 +1,84 @@
+#ifndef FLOW_KEY_H
+#define FLOW_KEY_H
+
+#include "ns3/packet.h"
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Header fields a FilterElement can test, used by the classifier indexes.
+     */
+    enum class FlowField : uint8_t
+    {
+        NONE,
+        SOURCE_ADDRESS,
+        DESTINATION_ADDRESS,
+        SOURCE_PORT,
+        DESTINATION_PORT,
+        PROTOCOL,
+        DSCP
+    };
+
+    /**
+     * \ingroup diffserv
+     * \brief Parsed view of the packet header fields used by the filter elements.
+     *
+     * DiffServ::Classify parses a packet into a FlowKey once and hands the same view
+     * to every TrafficClass, Filter and FilterElement. This replaces the old behavior
+     * where every FilterElement copied the packet and stripped the PPP/IPv4 headers again.
+     */
+    struct FlowKey
+    {
+        // Source and destination address from the IPv4 header
+        Ipv4Address sourceAddress;
+        Ipv4Address destinationAddress;
+
+        // IP protocol number (6 = TCP, 17 = UDP)
+        uint8_t protocol = 0;
+
+        // L4 ports (only valid when hasPorts is true)
+        uint16_t sourcePort = 0;
+        uint16_t destinationPort = 0;
+
+        // DSCP bits of the IPv4 ToS field
+        uint8_t dscp = 0;
+
+        // Total size of the packet as it sits in the queue (including the PPP header)
+        uint32_t length = 0;
+
+        // true if the PPP and IPv4 headers could be read
+        bool hasIpv4 = false;
+
+        // true if a TCP or UDP header could be read
+        bool hasPorts = false;
+
+        /**
+         * \brief Parse the PPP, IPv4 and TCP/UDP headers of a packet.
+         * \param pkt The packet to parse. It is not modified.
+         * \returns The parsed header view.
+         */
+        static FlowKey Parse(Ptr<const Packet> pkt);
+
+        /**
+         * \brief Check if the packet carries a header field.
+         * \returns true if the field could be parsed (addresses, protocol and DSCP need IPv4, ports need TCP/UDP).
+         */
+        bool Has(FlowField field) const;
+
+        /**
+         * \brief Read a header field as an integer (addresses in host order).
+         * \returns The field value, or 0 for FlowField::NONE.
+         */
+        uint32_t Get(FlowField field) const;
+
+        /**
+         * \brief Hash the 5-tuple (addresses, ports and protocol) and the DSCP.
+         * \param seed Mixed into the hash, so different seeds spread flows differently.
+         * \returns A well-mixed 32-bit hash.
+         */
+        uint32_t Hash(uint32_t seed = 0) const;
+    };
+} // namespace ns3
+
+#endif // FLOW_KEY_H
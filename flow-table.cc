@@ -0,0 +1,134 @@
+#include "flow-table.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Constructor for FlowTable.
+     */
+    FlowTable::FlowTable(uint32_t capacity, Time idleTimeout) : m_idleTimeout(idleTimeout)
+    {
+        SetCapacity(capacity);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Resizes the table to the power of two at or above the requested capacity.
+     * \details The entries are allocated here once, so lookups never allocate.
+     */
+    void FlowTable::SetCapacity(uint32_t capacity)
+    {
+        uint32_t sets = 1;
+        while (sets * WAYS < capacity)
+        {
+            sets <<= 1;
+        }
+
+        m_entries.assign(sets * WAYS, Entry());
+        m_hands.assign(sets, 0);
+        m_setMask = sets - 1;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of entries.
+     */
+    uint32_t FlowTable::GetCapacity() const
+    {
+        return m_entries.size();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the idle timeout.
+     */
+    void FlowTable::SetIdleTimeout(Time idleTimeout)
+    {
+        m_idleTimeout = idleTimeout;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Finds the flow in its set, or claims a free way or the clock hand's victim for it.
+     * \details An expired entry is reused by the lookup that finds it, so an idle flow is new again.
+     */
+    uint32_t FlowTable::Lookup(const FlowKey& key)
+    {
+        int64_t now = Simulator::Now().GetNanoSeconds();
+        uint32_t hash = key.Hash();
+        uint32_t setIndex = hash & m_setMask;
+        uint32_t first = setIndex * WAYS;
+
+        // A hit, or else the first free way
+        uint32_t victim = WAYS;
+        for (uint32_t way = 0; way < WAYS; ++way)
+        {
+            Entry& entry = m_entries[first + way];
+            if (entry.valid && !m_idleTimeout.IsZero() && now - entry.lastSeen > m_idleTimeout.GetNanoSeconds())
+            {
+                entry.valid = false;
+            }
+
+            if (entry.valid && entry.hash == hash)
+            {
+                entry.referenced = true;
+                entry.lastSeen = now;
+                return first + way;
+            }
+
+            if (!entry.valid && victim == WAYS)
+            {
+                victim = way;
+            }
+        }
+
+        // Otherwise run the clock hand of the set
+        if (victim == WAYS)
+        {
+            uint8_t& hand = m_hands[setIndex];
+            while (m_entries[first + hand].referenced)
+            {
+                m_entries[first + hand].referenced = false;
+                hand = (hand + 1) % WAYS;
+            }
+            victim = hand;
+            hand = (hand + 1) % WAYS;
+            m_evictions++;
+        }
+
+        Entry& entry = m_entries[first + victim];
+        entry.hash = hash;
+        entry.valid = true;
+        entry.referenced = false;
+        entry.bytes = 0;
+        entry.lastSeen = now;
+        return first + victim;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the bytes of an entry's flow.
+     */
+    uint64_t FlowTable::GetBytes(uint32_t entry) const
+    {
+        return m_entries[entry].bytes;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Adds bytes to an entry's flow.
+     */
+    void FlowTable::AddBytes(uint32_t entry, uint32_t bytes)
+    {
+        m_entries[entry].bytes += bytes;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of evicted flows.
+     */
+    uint64_t FlowTable::GetEvictions() const
+    {
+        return m_evictions;
+    }
+} // namespace ns3
@@ -0,0 +1,82 @@
+#ifndef FLOW_TABLE_H
+#define FLOW_TABLE_H
+
+#include <vector>
+#include <cstdint>
+#include "ns3/nstime.h"
+#include "flow-key.h"
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Bounded table of bytes seen per flow.
+     *
+     * Like the FlowCache the table is set associative with clock eviction, but an entry keeps only
+     * the flow's 32-bit hash (the set index comes from its low bits), a byte counter and the time
+     * the flow was last seen, so it stays compact for large flow counts. Two flows only share an
+     * entry if their whole hashes collide. A flow idle for longer than the idle timeout starts
+     * again from zero bytes, as does a flow whose entry was evicted.
+     */
+    class FlowTable
+    {
+        public:
+            /**
+             * \brief Constructor.
+             * \param capacity Number of entries (rounded up to a power of two, at least one set).
+             * \param idleTimeout Idle time after which a flow counts as new (zero never expires a flow).
+             */
+            explicit FlowTable(uint32_t capacity = DEFAULT_CAPACITY, Time idleTimeout = Seconds(0));
+
+            /**
+             * \brief Resize the table. Drops every entry.
+             */
+            void SetCapacity(uint32_t capacity);
+            uint32_t GetCapacity() const;
+
+            void SetIdleTimeout(Time idleTimeout);
+
+            /**
+             * \brief Find the entry of a flow, claiming one (at zero bytes) if the flow is new.
+             * \returns The entry, valid until the next Lookup().
+             */
+            uint32_t Lookup(const FlowKey& key);
+
+            /**
+             * \brief Bytes counted for the flow of an entry.
+             */
+            uint64_t GetBytes(uint32_t entry) const;
+
+            /**
+             * \brief Count bytes for the flow of an entry.
+             */
+            void AddBytes(uint32_t entry, uint32_t bytes);
+
+            /**
+             * \brief Number of live flows pushed out of a full set.
+             */
+            uint64_t GetEvictions() const;
+
+            static constexpr uint32_t DEFAULT_CAPACITY = 4096;
+
+        private:
+            static constexpr uint32_t WAYS = 4;
+
+            struct Entry
+            {
+                uint32_t hash = 0;
+                bool valid = false;
+                bool referenced = false;
+                uint64_t bytes = 0;
+                int64_t lastSeen = 0;       // ns
+            };
+
+            std::vector<Entry> m_entries;
+            std::vector<uint8_t> m_hands;
+            uint32_t m_setMask = 0;
+            Time m_idleTimeout;
+
+            uint64_t m_evictions = 0;
+    };
+} // namespace ns3
+
+#endif // FLOW_TABLE_H
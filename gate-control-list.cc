@@ -0,0 +1,234 @@
+#include "gate-control-list.h"
+#include <algorithm>
+
+/**
+ * Time-Aware Shaper Reference:
+ *
+ * IEEE Std 802.1Qbv-2015. IEEE Standard for Local and Metropolitan Area Networks – Bridges and
+ * Bridged Networks Amendment 25: Enhancements for Scheduled Traffic.
+ */
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Appends an entry and recompiles the segments.
+     */
+    void GateControlList::AddEntry(Time duration, uint64_t gates)
+    {
+        m_durations.push_back(std::max<int64_t>(duration.GetNanoSeconds(), 0));
+        m_gates.push_back(gates);
+        m_cycle += m_durations.back();
+        Build();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of entries.
+     */
+    uint32_t GateControlList::GetNEntries() const
+    {
+        return m_durations.size();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the cycle time.
+     */
+    Time GateControlList::GetCycleTime() const
+    {
+        return NanoSeconds(m_cycle);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the base time.
+     */
+    void GateControlList::SetBaseTime(Time baseTime)
+    {
+        m_baseTime = baseTime.GetNanoSeconds();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the base time.
+     */
+    Time GateControlList::GetBaseTime() const
+    {
+        return NanoSeconds(m_baseTime);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the guard band; recompiles the segments.
+     */
+    void GateControlList::SetGuardBand(Time guardBand)
+    {
+        m_guardBand = std::max<int64_t>(guardBand.GetNanoSeconds(), 0);
+        Build();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the guard band.
+     */
+    Time GateControlList::GetGuardBand() const
+    {
+        return NanoSeconds(m_guardBand);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Compiles the entries into segments of constant guarded gate states.
+     * \details Every class's open windows are found on the circular list (a window may run over
+     * the end of the cycle), each is cut short by the guard band, and the cycle is split at every
+     * window start and end.
+     */
+    void GateControlList::Build()
+    {
+        m_segmentStarts.clear();
+        m_segmentGates.clear();
+        if (m_cycle == 0)
+        {
+            return;
+        }
+
+        uint32_t entries = m_durations.size();
+        std::vector<int64_t> starts(entries + 1, 0);
+        for (uint32_t k = 0; k < entries; ++k)
+        {
+            starts[k + 1] = starts[k] + m_durations[k];
+        }
+
+        // Guarded open windows [start, end) of every class, within the cycle
+        struct Window
+        {
+            int64_t start;
+            int64_t end;
+            uint64_t gate;
+        };
+        std::vector<Window> windows;
+
+        uint64_t used = 0;
+        for (uint64_t gates : m_gates)
+        {
+            used |= gates;
+        }
+
+        for (uint64_t remaining = used; remaining; remaining &= remaining - 1)
+        {
+            uint64_t gate = remaining & -remaining;
+
+            // Walk the list once from an entry that closes the gate, so no window is cut in two
+            uint32_t closed = entries;
+            for (uint32_t k = 0; k < entries && closed == entries; ++k)
+            {
+                if (!(m_gates[k] & gate) && m_durations[k] > 0)
+                {
+                    closed = k;
+                }
+            }
+            if (closed == entries)
+            {
+                windows.push_back({0, m_cycle, gate});
+                continue;
+            }
+
+            int64_t windowStart = -1;
+            for (uint32_t step = 1; step <= entries; ++step)
+            {
+                uint32_t k = (closed + step) % entries;
+                int64_t position = starts[k] + (closed + step >= entries ? m_cycle : 0);
+                bool open = (m_gates[k] & gate) && step < entries;
+                if (open && windowStart < 0)
+                {
+                    windowStart = position;
+                }
+                else if (!open && windowStart >= 0 && m_durations[k] > 0)
+                {
+                    // The window ends where this entry starts, less the guard band
+                    int64_t length = position - windowStart - m_guardBand;
+                    if (length > 0)
+                    {
+                        int64_t start = windowStart % m_cycle;
+                        int64_t end = start + length;
+                        windows.push_back({start, std::min(end, m_cycle), gate});
+                        if (end > m_cycle)
+                        {
+                            windows.push_back({0, end - m_cycle, gate});
+                        }
+                    }
+                    windowStart = -1;
+                }
+            }
+        }
+
+        // Split the cycle at every window boundary and merge segments with the same states
+        std::vector<int64_t> boundaries = {0};
+        for (const Window& window : windows)
+        {
+            boundaries.push_back(window.start);
+            if (window.end < m_cycle)
+            {
+                boundaries.push_back(window.end);
+            }
+        }
+        std::sort(boundaries.begin(), boundaries.end());
+        boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+        for (int64_t boundary : boundaries)
+        {
+            uint64_t gates = 0;
+            for (const Window& window : windows)
+            {
+                if (window.start <= boundary && boundary < window.end)
+                {
+                    gates |= window.gate;
+                }
+            }
+
+            if (m_segmentGates.empty() || m_segmentGates.back() != gates)
+            {
+                m_segmentStarts.push_back(boundary);
+                m_segmentGates.push_back(gates);
+            }
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Finds the segment the time falls in and the time it ends.
+     * \details A segment that runs into a first segment with the same states at the end of the
+     * cycle ends where that one does, so every returned change is a real one.
+     */
+    uint64_t GateControlList::GetGateStates(Time now, Time& next) const
+    {
+        if (m_segmentGates.empty())
+        {
+            next = Time::Max();
+            return ~uint64_t(0);
+        }
+
+        uint32_t segments = m_segmentGates.size();
+        if (segments == 1)
+        {
+            next = Time::Max();
+            return m_segmentGates[0];
+        }
+
+        int64_t offset = ((now.GetNanoSeconds() - m_baseTime) % m_cycle + m_cycle) % m_cycle;
+        uint32_t segment = std::upper_bound(m_segmentStarts.begin(), m_segmentStarts.end(), offset) - m_segmentStarts.begin() - 1;
+
+        int64_t end;
+        if (segment + 1 < segments)
+        {
+            end = m_segmentStarts[segment + 1];
+        }
+        else
+        {
+            end = m_cycle + (m_segmentGates[segment] == m_segmentGates[0] ? m_segmentStarts[1] : 0);
+        }
+
+        next = now + NanoSeconds(end - offset);
+        return m_segmentGates[segment];
+    }
+} // namespace ns3
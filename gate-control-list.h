@@ -0,0 +1,77 @@
+#ifndef GATE_CONTROL_LIST_H
+#define GATE_CONTROL_LIST_H
+
+#include <vector>
+#include <cstdint>
+#include "ns3/nstime.h"
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief IEEE 802.1Qbv cyclic gate control list.
+     *
+     * Each entry opens the gates of a set of traffic classes (bit i of the mask is class i) for a
+     * fixed duration, and the list repeats with a cycle time equal to the sum of the durations,
+     * starting at the base time. A guard band ends every open window early, by the transmission
+     * time of the largest frame, so a frame that starts while its gate is open ends before the
+     * gate actually closes. A gate that stays open into the next entry is not cut.
+     *
+     * The list is compiled into the cycle's segments of constant (guarded) gate states whenever it
+     * changes, so the states at any time, and the time of the next change, are found with one
+     * modulo and a binary search instead of stepping through the list.
+     */
+    class GateControlList
+    {
+        public:
+            /**
+             * \brief Append an entry to the cycle.
+             * \param duration How long the entry lasts.
+             * \param gates Bit i set opens the gate of class i.
+             */
+            void AddEntry(Time duration, uint64_t gates);
+
+            uint32_t GetNEntries() const;
+            Time GetCycleTime() const;
+
+            /**
+             * \brief Time the first cycle starts at. The list repeats before it as well.
+             */
+            void SetBaseTime(Time baseTime);
+            Time GetBaseTime() const;
+
+            /**
+             * \brief Time every open window ends early, e.g. the transmission time of a full-sized frame.
+             */
+            void SetGuardBand(Time guardBand);
+            Time GetGuardBand() const;
+
+            /**
+             * \brief Gate states at a time.
+             * \param now The time.
+             * \param next Set to the time of the next change of the states (Time::Max() if they never change).
+             * \returns Bit i set when the gate of class i is open. Every gate is open with an empty list.
+             */
+            uint64_t GetGateStates(Time now, Time& next) const;
+
+        private:
+            // Entry durations (ns) and gate masks
+            std::vector<int64_t> m_durations;
+            std::vector<uint64_t> m_gates;
+            int64_t m_cycle = 0;
+
+            int64_t m_baseTime = 0;
+            int64_t m_guardBand = 0;
+
+            // Start offset (ns into the cycle) and guarded gate states of every segment;
+            // consecutive segments always differ
+            std::vector<int64_t> m_segmentStarts;
+            std::vector<uint64_t> m_segmentGates;
+
+            /**
+             * \brief Compile the entries and the guard band into segments.
+             */
+            void Build();
+    };
+} // namespace ns3
+
+#endif // GATE_CONTROL_LIST_H
@@ -0,0 +1,364 @@
+#include "hierarchical-scheduler.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <numeric>
+
+/**
+ * Hierarchical scheduling references:
+ *
+ * Goyal, P., Guo, X., & Vin, H. M. (1996). A Hierarchical CPU Scheduler for Multimedia Operating Systems.
+ * In Proceedings of OSDI '96. (start-time fair queuing at every node of a scheduling tree)
+ *
+ * Adiseshu, H., Parulkar, G., & Varghese, G. (1996). A Reliable and Scalable Striping Protocol.
+ * In Proceedings of SIGCOMM '96. (surplus round robin, the deficit-after-send form of DRR)
+ */
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Constructor for HierarchicalScheduler. Creates the root node.
+     */
+    HierarchicalScheduler::HierarchicalScheduler(NodeType rootType)
+    {
+        nodes.emplace_back();
+        nodes[ROOT].type = rootType;
+        nodes[ROOT].parent = NO_NODE;
+        nodes[ROOT].slot = NO_SLOT;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Adds an internal node under a parent.
+     */
+    uint32_t HierarchicalScheduler::AddNode(uint32_t parent, NodeType type, uint32_t priority, double weight)
+    {
+        if (parent >= nodes.size())
+        {
+            NS_LOG_UNCOND("HierarchicalScheduler::AddNode: unknown parent node " << parent);
+            return NO_NODE;
+        }
+
+        uint32_t id = nodes.size();
+        uint32_t slot = AddChild(parent, Child{false, id, priority, weight});
+        if (slot == NO_SLOT)
+        {
+            return NO_NODE;
+        }
+
+        nodes.emplace_back();
+        nodes[id].type = type;
+        nodes[id].parent = parent;
+        nodes[id].slot = slot;
+        return id;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Adds a traffic class under the root.
+     */
+    void HierarchicalScheduler::RegisterQueue(TrafficClass* trafficClass)
+    {
+        RegisterQueue(trafficClass, ROOT);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Adds a traffic class as a leaf under a node.
+     */
+    void HierarchicalScheduler::RegisterQueue(TrafficClass* trafficClass, uint32_t parent)
+    {
+        if (parent >= nodes.size())
+        {
+            NS_LOG_UNCOND("HierarchicalScheduler::RegisterQueue: unknown parent node " << parent);
+            return;
+        }
+
+        uint32_t index = q_class.size();
+        uint32_t slot = AddChild(parent, Child{true, index, trafficClass->GetPriorityLevel(), trafficClass->GetWeight()});
+        if (slot == NO_SLOT)
+        {
+            return;
+        }
+
+        leafNode.push_back(parent);
+        leafSlot.push_back(slot);
+        DiffServ::RegisterQueue(trafficClass);
+
+        // A class registered with packets already queued is backlogged right away
+        SetActive(parent, slot, IsBacklogged(index));
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Appends a child to a node. SPQ ranks are recomputed (configuration time only).
+     */
+    uint32_t HierarchicalScheduler::AddChild(uint32_t id, const Child& child)
+    {
+        Node& node = nodes[id];
+        if (node.type == NODE_SPQ && node.children.size() >= MAX_SPQ_CHILDREN)
+        {
+            NS_LOG_UNCOND("HierarchicalScheduler: an SPQ node holds at most " << MAX_SPQ_CHILDREN << " children");
+            return NO_SLOT;
+        }
+
+        uint32_t slot = node.children.size();
+        node.children.push_back(child);
+        node.active.push_back(false);
+        node.next.push_back(NO_SLOT);
+        node.prev.push_back(NO_SLOT);
+        node.deficit.push_back(0);
+        node.startTag.push_back(0);
+        node.finishTag.push_back(0);
+
+        if (node.type == NODE_SPQ)
+        {
+            // Rank by priority level, keeping insertion order for equal levels
+            node.rankChild.resize(node.children.size());
+            std::iota(node.rankChild.begin(), node.rankChild.end(), 0);
+            std::stable_sort(node.rankChild.begin(), node.rankChild.end(), [&node](uint32_t a, uint32_t b) {
+                return node.children[a].priority < node.children[b].priority;
+            });
+
+            node.childRank.resize(node.children.size());
+            node.activeRanks = 0;
+            for (uint32_t rank = 0; rank < node.rankChild.size(); ++rank)
+            {
+                node.childRank[node.rankChild[rank]] = rank;
+                if (node.active[node.rankChild[rank]])
+                {
+                    node.activeRanks |= uint64_t(1) << rank;
+                }
+            }
+        }
+
+        return slot;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Returns the packet at the head of the scheduled leaf.
+     */
+    Ptr<const Packet> HierarchicalScheduler::Schedule() const
+    {
+        uint32_t index = ScheduleQueue();
+        if (index == NO_QUEUE)
+        {
+            return nullptr;
+        }
+
+        return q_class[index]->Peek();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Walks from the root to a leaf, letting each node pick one backlogged child.
+     * \details Every backlogged node has at least one backlogged child, so the walk never backtracks.
+     */
+    uint32_t HierarchicalScheduler::ScheduleQueue() const
+    {
+        if (nodes[ROOT].activeCount == 0)
+        {
+            return NO_QUEUE;
+        }
+
+        const Node* node = &nodes[ROOT];
+        while (true)
+        {
+            const Child& child = node->children[SelectChild(*node)];
+            if (child.leaf)
+            {
+                return child.id;
+            }
+
+            node = &nodes[child.id];
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Picks the child a backlogged node serves next.
+     */
+    uint32_t HierarchicalScheduler::SelectChild(const Node& node) const
+    {
+        switch (node.type)
+        {
+            case NODE_SPQ:
+                return node.rankChild[__builtin_ctzll(node.activeRanks)];
+
+            case NODE_DRR:
+                return node.head;
+
+            default:
+                return node.order.begin()->second;
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Charges the packet about to be popped to every node on the path from its leaf to the root.
+     * \details DRR nodes take the size out of the child's deficit and pass the turn once the deficit
+     * is used up. WFQ nodes move their virtual time to the child's start tag and advance the tag.
+     */
+    void HierarchicalScheduler::CommitSchedule(uint32_t index)
+    {
+        uint32_t size = q_class[index]->Peek()->GetSize();
+        uint32_t id = leafNode[index];
+        uint32_t slot = leafSlot[index];
+
+        while (id != NO_NODE)
+        {
+            Node& node = nodes[id];
+            const Child& child = node.children[slot];
+
+            if (node.type == NODE_DRR)
+            {
+                node.deficit[slot] -= size;
+                if (node.deficit[slot] <= 0)
+                {
+                    AdvanceHead(node, node.next[slot]);
+                }
+            }
+            else if (node.type == NODE_WFQ)
+            {
+                node.virtualTime = node.startTag[slot];
+                node.finishTag[slot] = node.startTag[slot] + size / GetShare(child);
+                node.order.erase({node.startTag[slot], slot});
+                node.startTag[slot] = node.finishTag[slot];
+                node.order.insert({node.startTag[slot], slot});
+            }
+
+            slot = node.slot;
+            id = node.parent;
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Keeps the leaf's parent in sync after an enqueue, a removal or a shaper hold or release.
+     */
+    void HierarchicalScheduler::NotifyQueueChanged(uint32_t index)
+    {
+        SetActive(leafNode[index], leafSlot[index], IsBacklogged(index));
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Marks a child as backlogged or idle in its node.
+     * \details The node itself only changes state when its first child becomes backlogged or its
+     * last child goes idle, and only then is its parent updated, so the cost is bounded by the depth.
+     */
+    void HierarchicalScheduler::SetActive(uint32_t id, uint32_t slot, bool active)
+    {
+        Node& node = nodes[id];
+        if (node.active[slot] == active)
+        {
+            return;
+        }
+
+        node.active[slot] = active;
+        node.activeCount += active ? 1 : -1;
+
+        switch (node.type)
+        {
+            case NODE_SPQ:
+                if (active)
+                {
+                    node.activeRanks |= uint64_t(1) << node.childRank[slot];
+                }
+                else
+                {
+                    node.activeRanks &= ~(uint64_t(1) << node.childRank[slot]);
+                }
+                break;
+
+            case NODE_DRR:
+                if (active)
+                {
+                    node.deficit[slot] = 0;
+                    if (node.head == NO_SLOT)
+                    {
+                        node.next[slot] = slot;
+                        node.prev[slot] = slot;
+                        AdvanceHead(node, slot);
+                    }
+                    else
+                    {
+                        // Append at the tail, just before the head
+                        uint32_t tail = node.prev[node.head];
+                        node.next[tail] = slot;
+                        node.prev[slot] = tail;
+                        node.next[slot] = node.head;
+                        node.prev[node.head] = slot;
+                    }
+                }
+                else
+                {
+                    uint32_t following = node.next[slot];
+                    node.next[node.prev[slot]] = following;
+                    node.prev[following] = node.prev[slot];
+                    node.deficit[slot] = 0;
+
+                    if (node.activeCount == 0)
+                    {
+                        node.head = NO_SLOT;
+                    }
+                    else if (node.head == slot)
+                    {
+                        // The turn passes to the next child in the list
+                        AdvanceHead(node, following);
+                    }
+                }
+                break;
+
+            default:
+                if (active)
+                {
+                    // A child returning from idle starts no earlier than the node's virtual time
+                    node.startTag[slot] = std::max(node.virtualTime, node.finishTag[slot]);
+                    node.order.insert({node.startTag[slot], slot});
+                }
+                else
+                {
+                    node.order.erase({node.startTag[slot], slot});
+                }
+                break;
+        }
+
+        // Propagate only when the node itself turns backlogged or idle
+        bool nodeChanged = active ? node.activeCount == 1 : node.activeCount == 0;
+        if (nodeChanged && node.parent != NO_NODE)
+        {
+            SetActive(node.parent, node.slot, active);
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Gives the DRR turn to the first child, from the given slot on, whose deficit turns positive.
+     * \details Each child passed over receives its quantum, so a child in debt waits out the rounds it
+     * overspent. With quanta of at least one packet the first child takes the turn.
+     */
+    void HierarchicalScheduler::AdvanceHead(Node& node, uint32_t slot)
+    {
+        while (true)
+        {
+            node.deficit[slot] += static_cast<int64_t>(GetShare(node.children[slot]));
+            if (node.deficit[slot] > 0)
+            {
+                node.head = slot;
+                return;
+            }
+
+            slot = node.next[slot];
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Returns the quantum or share of a child, at least 1.
+     */
+    double HierarchicalScheduler::GetShare(const Child& child)
+    {
+        return std::max(child.weight, 1.0);
+    }
+} // namespace ns3
@@ -0,0 +1,175 @@
+#ifndef HIERARCHICAL_SCHEDULER_H
+#define HIERARCHICAL_SCHEDULER_H
+
+#include "diff-serv.h"
+#include "ns3/packet.h"
+#include <vector>
+#include <set>
+#include <limits>
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Hierarchical scheduler: a tree of SPQ, DRR and WFQ nodes over TrafficClass leaves.
+     *
+     * Every internal node schedules among its children (internal nodes or traffic classes) and
+     * only keeps state for its own backlogged children:
+     * - SPQ nodes rank their children by priority (lowest number first) and keep a bitmap of the
+     *   backlogged ranks, so the choice is one count-trailing-zeros.
+     * - DRR nodes keep an active list with a byte deficit per child, in the surplus round robin
+     *   form: a child keeps the turn while its deficit is positive and pays for a packet after
+     *   sending it, so the node never has to look inside a subtree to find its next packet size.
+     * - WFQ nodes keep their backlogged children ordered by virtual start tag. A child's tag
+     *   advances by size / weight for every packet it sends, and the node's virtual time is the
+     *   start tag of the last child served, as in hierarchical start-time fair queuing.
+     *
+     * A decision walks from the root to one leaf, and a dequeue or a queue change only updates the
+     * nodes on the path from that leaf to the root, so neither depends on the number of classes.
+     * Leaves take their priority and weight from the TrafficClass when they are registered;
+     * internal nodes get theirs from AddNode. Shaped classes (TrafficClass::SetShaper) leave their
+     * parent's backlog while they are held, which gives a rate-capped strict-priority class.
+     */
+    class HierarchicalScheduler : public DiffServ
+    {
+        public:
+            enum NodeType
+            {
+                NODE_SPQ,
+                NODE_DRR,
+                NODE_WFQ
+            };
+
+            /**
+             * \brief Constructor.
+             * \param rootType Discipline of the root node.
+             */
+            HierarchicalScheduler(NodeType rootType = NODE_SPQ);
+            ~HierarchicalScheduler() override = default;
+
+            /**
+             * \brief Add an internal node.
+             * \param parent The parent node (ROOT for the root).
+             * \param type Discipline of the new node.
+             * \param priority Rank of the node when the parent is an SPQ node.
+             * \param weight Quantum in bytes when the parent is a DRR node, share when it is a WFQ node.
+             * \returns The id of the new node, or NO_NODE if the parent is unknown or full.
+             */
+            uint32_t AddNode(uint32_t parent, NodeType type, uint32_t priority = 0, double weight = 0);
+
+            /**
+             * \brief Add a traffic class as a leaf under a node.
+             * \details The priority level and weight of the class are read at registration time.
+             */
+            void RegisterQueue(TrafficClass* trafficClass, uint32_t parent);
+
+            /**
+             * \brief Add a traffic class as a leaf under the root.
+             */
+            void RegisterQueue(TrafficClass* trafficClass) override;
+
+            /**
+             * \brief Schedules the packet at the end of the root-to-leaf walk.
+             */
+            Ptr<const Packet> Schedule() const override;
+
+            /**
+             * \brief Walks from the root to the leaf to serve.
+             * \returns The index of the selected queue, or NO_QUEUE if nothing is backlogged.
+             */
+            uint32_t ScheduleQueue() const override;
+
+            // Id of the root node
+            static constexpr uint32_t ROOT = 0;
+
+            // Returned by AddNode on failure
+            static constexpr uint32_t NO_NODE = std::numeric_limits<uint32_t>::max();
+
+            // Maximum number of children of an SPQ node (one bitmap word)
+            static constexpr uint32_t MAX_SPQ_CHILDREN = 64;
+
+        protected:
+            /**
+             * \brief Charge the packet about to be popped to every node on its path.
+             */
+            void CommitSchedule(uint32_t index) override;
+
+            /**
+             * \brief Propagate a leaf's backlog change towards the root.
+             */
+            void NotifyQueueChanged(uint32_t index) override;
+
+        private:
+            // Sentinel for "no child slot"
+            static constexpr uint32_t NO_SLOT = std::numeric_limits<uint32_t>::max();
+
+            struct Child
+            {
+                bool leaf;
+                uint32_t id;        // q_class index for a leaf, node id otherwise
+                uint32_t priority;
+                double weight;
+            };
+
+            struct Node
+            {
+                NodeType type;
+                uint32_t parent;    // NO_NODE for the root
+                uint32_t slot;      // position in the parent's children
+
+                std::vector<Child> children;
+                std::vector<bool> active;
+                uint32_t activeCount = 0;
+
+                // SPQ: children ranked by priority; bit r is set while child rankChild[r] is backlogged
+                std::vector<uint32_t> childRank;
+                std::vector<uint32_t> rankChild;
+                uint64_t activeRanks = 0;
+
+                // DRR: circular list of the backlogged children; head holds the turn with a positive deficit
+                std::vector<uint32_t> next;
+                std::vector<uint32_t> prev;
+                std::vector<int64_t> deficit;
+                uint32_t head = NO_SLOT;
+
+                // WFQ: backlogged children ordered by (start tag, slot)
+                std::vector<double> startTag;
+                std::vector<double> finishTag;
+                std::set<std::pair<double, uint32_t>> order;
+                double virtualTime = 0;
+            };
+
+            std::vector<Node> nodes;
+
+            // Parent node and slot of every leaf, indexed like q_class
+            std::vector<uint32_t> leafNode;
+            std::vector<uint32_t> leafSlot;
+
+            /**
+             * \brief Append a child to a node and size its per-child state.
+             * \returns The slot of the child, or NO_SLOT if the node is full.
+             */
+            uint32_t AddChild(uint32_t node, const Child& child);
+
+            /**
+             * \brief Pick the child a node serves next (the node must be backlogged).
+             */
+            uint32_t SelectChild(const Node& node) const;
+
+            /**
+             * \brief Mark a child as backlogged or idle and propagate the node's own change upwards.
+             */
+            void SetActive(uint32_t node, uint32_t slot, bool active);
+
+            /**
+             * \brief Give the DRR turn to the first child from the given slot whose deficit turns positive.
+             */
+            void AdvanceHead(Node& node, uint32_t slot);
+
+            /**
+             * \brief Quantum (DRR) or share (WFQ) of a child; at least 1 so every child makes progress.
+             */
+            static double GetShare(const Child& child);
+    };
+} // namespace ns3
+
+#endif // HIERARCHICAL_SCHEDULER_H
@@ -1,4 +1,5 @@
 #include "diffserv-tests.h"
+#include "diffserv-benchmarks.h"
 #include "simulation.h"
 #include <iostream>
 #include <string>
@@ -54,6 +55,10 @@ void ns3::RunSimulation(const std::string& configFile)
 
     // Kick off the simulation
     Simulator::Run();
+
+    // Report the scheduler counters before the objects are destroyed
+    simulation.PrintStats();
+
     Simulator::Destroy();
 
     NS_LOG_UNCOND("Simulation finished");
@@ -81,7 +86,7 @@ int main(int argc, char* argv[])
 
     // Add command line arguments for run mode and config file
     ns3::CommandLine cmd;
-    cmd.AddValue ("runMode",    "Mode: \"test\" or \"sim\"", runMode);
+    cmd.AddValue ("runMode",    "Mode: \"test\", \"bench\" or \"sim\"", runMode);
     cmd.AddValue ("configFile", "QoS JSON config (required if runMode==sim)", configFile);
     cmd.Parse (argc, argv);
 
@@ -92,6 +97,13 @@ int main(int argc, char* argv[])
         DiffservTests diffServTests;
         diffServTests.RunAll();
     }
+    // Check if the run mode is set to "bench"
+    else if (runMode == "bench")
+    {
+        // Run the Diffserv benchmarks
+        DiffservBenchmarks diffServBenchmarks;
+        diffServBenchmarks.RunAll();
+    }
     // Check if the run mode is simulation
     else if (runMode == "sim")
     {
@@ -107,7 +119,7 @@ int main(int argc, char* argv[])
     // Otherwise, print an error message
     else
     {
-        NS_LOG_UNCOND("Error: --runMode must be \"test\" or \"sim\"");
+        NS_LOG_UNCOND("Error: --runMode must be \"test\", \"bench\" or \"sim\"");
         return 1;
     }
 
@@ -0,0 +1,127 @@
+#include "pias.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include <algorithm>
+
+/**
+ * PIAS Reference:
+ *
+ * Bai, W., Chen, L., Chen, K., Han, D., Tian, C., & Wang, H. (2015). Information-Agnostic Flow
+ * Scheduling for Commodity Data Centers. In Proceedings of USENIX NSDI '15 (pp. 455–468).
+ */
+
+namespace ns3 {
+    PIAS::PIAS(const std::vector<uint64_t>& thresholds) : classifiedEntry(0)
+    {
+        SetThresholds(thresholds);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Classifies a packet by the size its flow has reached.
+     * \details The flow's entry is remembered so NotifyEnqueued() can count the packet once it
+     * is admitted; a dropped packet does not count against its flow.
+     */
+    uint32_t PIAS::Classify(const FlowKey& key)
+    {
+        if (q_class.empty())
+        {
+            NS_LOG_UNCOND("PIAS::Classify: no levels configured");
+            return NO_QUEUE;
+        }
+
+        classifiedEntry = flowTable.Lookup(key);
+        return GetLevel(flowTable.GetBytes(classifiedEntry));
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Adds a TrafficClass as the next level and ranks it below the levels before it.
+     */
+    void PIAS::RegisterQueue(TrafficClass* trafficClass)
+    {
+        trafficClass->SetPriorityLevel(q_class.size());
+        levelPackets.push_back(0);
+        SPQ::RegisterQueue(trafficClass);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the demotion thresholds (sorted, so a level lookup is a binary search).
+     */
+    void PIAS::SetThresholds(const std::vector<uint64_t>& values)
+    {
+        thresholds = values;
+        std::sort(thresholds.begin(), thresholds.end());
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the demotion thresholds.
+     */
+    const std::vector<uint64_t>& PIAS::GetThresholds() const
+    {
+        return thresholds;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Resizes the flow table (every flow starts again at the top level).
+     */
+    void PIAS::SetFlowTableSize(uint32_t entries)
+    {
+        flowTable.SetCapacity(entries);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the flow idle timeout.
+     */
+    void PIAS::SetFlowIdleTimeout(Time idleTimeout)
+    {
+        flowTable.SetIdleTimeout(idleTimeout);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Returns the number of thresholds at or below the byte count, capped at the lowest level.
+     */
+    uint32_t PIAS::GetLevel(uint64_t bytes) const
+    {
+        uint32_t level = std::upper_bound(thresholds.begin(), thresholds.end(), bytes) - thresholds.begin();
+        if (q_class.empty())
+        {
+            return level;
+        }
+
+        return std::min<uint32_t>(level, q_class.size() - 1);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the packets admitted into a level.
+     */
+    uint64_t PIAS::GetLevelPackets(uint32_t level) const
+    {
+        return levelPackets[level];
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of flows evicted from the flow table.
+     */
+    uint64_t PIAS::GetFlowEvictions() const
+    {
+        return flowTable.GetEvictions();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Counts the admitted packet against the flow classified last.
+     */
+    void PIAS::NotifyEnqueued(uint32_t index, Ptr<const Packet> pkt)
+    {
+        flowTable.AddBytes(classifiedEntry, pkt->GetSize());
+        levelPackets[index]++;
+    }
+} // namespace ns3
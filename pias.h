@@ -0,0 +1,96 @@
+#ifndef PIAS_H
+#define PIAS_H
+
+#include "spq.h"
+#include "flow-table.h"
+#include <vector>
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief PIAS-style multi-level feedback queue extending SPQ
+     *
+     * The registered TrafficClasses are the levels of a strict-priority ladder: the k-th class
+     * registered is level k and gets priority level k, so SPQ serves level 0 first. A compact
+     * FlowTable counts the bytes every flow has queued so far, and a packet goes to the level
+     * whose byte threshold the flow has not yet crossed. Every flow starts at the top and is
+     * demoted as it grows, so short flows finish at the highest priority without any hint from the
+     * application, while long flows share the lower levels (Bai et al., PIAS).
+     *
+     * Demotion never reorders a flow: its older packets sit in a higher level and leave first.
+     * The class filters are not used; only the flow's size decides the level.
+     */
+    class PIAS : public SPQ
+    {
+    public:
+        /**
+         * \brief Constructor.
+         * \param thresholds Byte counts at which a flow moves down one level (increasing).
+         */
+        PIAS(const std::vector<uint64_t>& thresholds = std::vector<uint64_t>());
+        ~PIAS() override = default;
+
+        using SPQ::Classify;
+
+        /**
+         * \brief Pick the level of a packet from the bytes its flow has queued so far.
+         * \param key The header fields parsed once from the packet.
+         * \returns The index of the level, or NO_QUEUE if no level is registered.
+         */
+        uint32_t Classify(const FlowKey& key) override;
+
+        /**
+         * \brief Add a TrafficClass as the next (lower) level of the ladder.
+         * \param trafficClass pointer to the TrafficClass instance; its priority level is set to its level.
+         */
+        void RegisterQueue(TrafficClass* trafficClass) override;
+
+        /**
+         * \brief Byte thresholds between the levels. Flows past the last threshold (or past the
+         * last level) stay in the lowest level.
+         */
+        void SetThresholds(const std::vector<uint64_t>& thresholds);
+        const std::vector<uint64_t>& GetThresholds() const;
+
+        /**
+         * \brief Flow table settings: number of flows tracked and the idle time after which a flow
+         * starts again at the top level.
+         */
+        void SetFlowTableSize(uint32_t entries);
+        void SetFlowIdleTimeout(Time idleTimeout);
+
+        /**
+         * \brief Level a flow that has queued the given number of bytes is in.
+         */
+        uint32_t GetLevel(uint64_t bytes) const;
+
+        /**
+         * \brief Packets admitted into a level.
+         */
+        uint64_t GetLevelPackets(uint32_t level) const;
+
+        /**
+         * \brief Number of live flows pushed out of the flow table.
+         */
+        uint64_t GetFlowEvictions() const;
+
+    protected:
+        /**
+         * \brief Count the packet just queued against its flow.
+         * \param index The level that took the packet.
+         * \param pkt The packet.
+         */
+        void NotifyEnqueued(uint32_t index, Ptr<const Packet> pkt) override;
+
+    private:
+        std::vector<uint64_t> thresholds;
+        FlowTable flowTable;
+
+        // Flow table entry of the packet classified last (the one DoEnqueue admits next)
+        uint32_t classifiedEntry;
+
+        std::vector<uint64_t> levelPackets;
+    };
+} // namespace ns3
+
+#endif // PIAS_H
@@ -0,0 +1,271 @@
+#include "pifo.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "scheduling-tag.h"
+#include <algorithm>
+
+/**
+ * PIFO Reference:
+ *
+ * Sivaraman, A., Subramanian, S., Alizadeh, M., Chole, S., Chuang, S.-T., Agrawal, A., Balakrishnan, H.,
+ * Edsall, T., Katti, S., & McKeown, N. (2016). Programmable Packet Scheduling at Line Rate.
+ * In Proceedings of ACM SIGCOMM '16 (pp. 44–57). https://doi.org/10.1145/2934872.2934899
+ */
+
+namespace ns3 {
+    PIFO::PIFO(RankPolicy policy) : rankPolicy(policy), virtualTime(0), maxFinishTag(0) {}
+
+    /**
+     * \ingroup diffserv
+     * \brief Schedules the packet with the smallest rank.
+     * \returns A pointer to the next scheduled packet. If no packet is found, returns nullptr.
+     */
+    Ptr<const Packet> PIFO::Schedule() const
+    {
+        uint32_t scheduledQueue = ScheduleQueue();
+
+        // If no queue was found, return nullptr
+        if (scheduledQueue == NO_QUEUE)
+        {
+            return nullptr;
+        }
+
+        // Return the packet from the front of the scheduled queue
+        return q_class[scheduledQueue]->Peek();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Selects the backlogged queue whose head-of-line packet has the smallest rank.
+     * \returns The index of the scheduled queue, or NO_QUEUE if all queues are empty.
+     */
+    uint32_t PIFO::ScheduleQueue() const
+    {
+        if (pifo.IsEmpty())
+        {
+            return NO_QUEUE;
+        }
+
+        return pifo.Top();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Adds a new TrafficClass to the PIFO scheduler.
+     * \details Packets queued before the class was registered are ranked when they reach its head.
+     */
+    void PIFO::RegisterQueue(TrafficClass* trafficClass)
+    {
+        DiffServ::RegisterQueue(trafficClass);
+
+        finishTag.push_back(0);
+        lastRank.push_back(0);
+        clampedRanks.push_back(0);
+        pifo.Resize(q_class.size());
+        NotifyQueueChanged(q_class.size() - 1);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Switches to a user-supplied rank function.
+     */
+    void PIFO::SetRankFunction(Callback<uint64_t, uint32_t, Ptr<const Packet>> function)
+    {
+        rankFunction = function;
+        rankPolicy = RANK_CUSTOM;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the rank policy.
+     */
+    PIFO::RankPolicy PIFO::GetRankPolicy() const
+    {
+        return rankPolicy;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the link rate used by the least-slack-time policy.
+     */
+    void PIFO::SetLinkRate(DataRate rate)
+    {
+        linkRate = rate;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the bucket width of the rank queue.
+     */
+    void PIFO::SetGranularity(uint32_t bits)
+    {
+        pifo.SetGranularity(bits);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the rank of a queue's head-of-line packet.
+     */
+    uint64_t PIFO::GetHeadRank(uint32_t index) const
+    {
+        Ptr<const Packet> head = q_class[index]->Peek();
+        SchedulingTag tag;
+        return head && head->PeekPacketTag(tag) ? tag.GetValue() : 0;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of ranks of a queue raised to the rank of the packet before.
+     */
+    uint64_t PIFO::GetClampedRanks(uint32_t index) const
+    {
+        return clampedRanks[index];
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Takes the rank off the packet about to be served.
+     * \details Under RANK_FAIR the served start tag becomes the virtual time. The queue leaves the
+     * PIFO and is put back at its next rank in NotifyQueueChanged(), once the packet is popped.
+     */
+    void PIFO::CommitSchedule(uint32_t index)
+    {
+        Ptr<const Packet> head = q_class[index]->Peek();
+        SchedulingTag tag;
+        if (head && ConstCast<Packet>(head)->RemovePacketTag(tag) && rankPolicy == RANK_FAIR)
+        {
+            virtualTime = tag.GetValue();
+        }
+
+        pifo.Erase(index);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Keeps the PIFO in step with the queues.
+     * \details A queue that enters the PIFO is keyed by the rank of its head, which is ranked
+     * here if it has no rank yet. A queue already in the PIFO keeps its place; an enqueue that
+     * changed its head re-keys it in NotifyEnqueued().
+     */
+    void PIFO::NotifyQueueChanged(uint32_t index)
+    {
+        if (IsBacklogged(index))
+        {
+            if (!pifo.Contains(index))
+            {
+                pifo.Push(index, Stamp(index, q_class[index]->Peek()));
+            }
+        }
+        else
+        {
+            pifo.Erase(index);
+        }
+
+        // End of a busy period
+        if (pifo.IsEmpty())
+        {
+            virtualTime = std::max(virtualTime, maxFinishTag);
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Ranks the packet just queued and keys its queue by its head.
+     * \details A class with flow sub-queues may have dropped packets of its longest flow to admit
+     * this one, head included, so the queue is moved to its head's rank whenever that changed.
+     */
+    void PIFO::NotifyEnqueued(uint32_t index, Ptr<const Packet> pkt)
+    {
+        Stamp(index, pkt);
+
+        if (IsBacklogged(index))
+        {
+            uint64_t rank = Stamp(index, q_class[index]->Peek());
+            if (!pifo.Contains(index) || pifo.GetRank(index) != rank)
+            {
+                pifo.Push(index, rank);
+            }
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Returns the rank tagged on a queued packet, ranking and tagging it first if it has none.
+     * \details The class serves its packets in order, so a rank below that of the packet queued
+     * before it is raised to it; the class head then never claims a rank its class cannot deliver.
+     */
+    uint64_t PIFO::Stamp(uint32_t index, Ptr<const Packet> pkt)
+    {
+        SchedulingTag tag;
+        if (!pkt->PeekPacketTag(tag))
+        {
+            uint64_t rank = Rank(index, pkt);
+            if (q_class[index]->GetNPackets() > 1 && rank < lastRank[index])
+            {
+                rank = lastRank[index];
+                clampedRanks[index]++;
+            }
+            lastRank[index] = rank;
+
+            tag.SetValue(rank);
+            pkt->AddPacketTag(tag);
+        }
+
+        return tag.GetValue();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Computes the rank of a packet under the current policy.
+     */
+    uint64_t PIFO::Rank(uint32_t index, Ptr<const Packet> pkt)
+    {
+        switch (rankPolicy)
+        {
+            case RANK_PRIORITY:
+                return q_class[index]->GetPriorityLevel();
+
+            case RANK_FAIR:
+            {
+                // SFQ tags: a class that was idle starts at the virtual time, a busy one where it left off
+                double start = std::max(virtualTime, finishTag[index]);
+                finishTag[index] = start + pkt->GetSize() / GetQueueWeight(index);
+                maxFinishTag = std::max(maxFinishTag, finishTag[index]);
+                return static_cast<uint64_t>(start);
+            }
+
+            case RANK_DEADLINE:
+            case RANK_SLACK:
+            {
+                int64_t deadline = (Simulator::Now() + q_class[index]->GetDelayBudget()).GetNanoSeconds();
+                if (rankPolicy == RANK_SLACK && linkRate.GetBitRate() > 0)
+                {
+                    // Latest time the packet can start and still finish by its deadline
+                    deadline -= static_cast<int64_t>(pkt->GetSize() * 8 * 1e9 / linkRate.GetBitRate());
+                }
+                return static_cast<uint64_t>(std::max<int64_t>(deadline, 0));
+            }
+
+            case RANK_CUSTOM:
+                if (rankFunction.IsNull())
+                {
+                    NS_LOG_UNCOND("PIFO: no rank function set. Ranking packet as 0.");
+                    return 0;
+                }
+                return rankFunction(index, pkt);
+        }
+
+        return 0;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Returns the weight of a queue; a non-positive weight counts as 1.
+     */
+    double PIFO::GetQueueWeight(uint32_t index) const
+    {
+        double weight = q_class[index]->GetWeight();
+        return weight > 0 ? weight : 1.0;
+    }
+} // namespace ns3
@@ -0,0 +1,159 @@
+#ifndef PIFO_H
+#define PIFO_H
+
+#include "diff-serv.h"
+#include "rank-queue.h"
+#include "scheduling-tag.h"
+#include "ns3/callback.h"
+#include "ns3/data-rate.h"
+#include <vector>
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief PIFO (Push-In First-Out) programmable scheduler extending DiffServ
+     *
+     * Every packet gets a rank from a rank function when it is enqueued, and packets leave in
+     * increasing rank order (equal ranks first come, first served). The policy lives entirely in
+     * the rank function, so the one engine expresses:
+     *  - RANK_PRIORITY: the class priority level, i.e. SPQ (lowest level first);
+     *  - RANK_FAIR:     the SFQ start tag max(v, F) with F += size / weight, i.e. weighted fair queuing;
+     *  - RANK_DEADLINE: arrival time + class delay budget in ns, i.e. earliest deadline first;
+     *  - RANK_SLACK:    the deadline minus the packet's transmission time, i.e. least slack time first;
+     *  - RANK_CUSTOM:   any function of the class index and the packet.
+     *
+     * Each packet carries its rank in a SchedulingTag and only the head rank of each backlogged
+     * class sits in a RankQueue (a bucketed find-first-set queue), so the PIFO holds one entry per
+     * class instead of one per packet. The class metadata used is
+     * TrafficClass::GetPriorityLevel(), GetWeight() and GetDelayBudget().
+     *
+     * A class is a FIFO, so ranks only order the class heads: a packet is never served before
+     * the packets queued ahead of it in its class. Ranks must therefore not decrease within a
+     * class. RANK_PRIORITY, RANK_FAIR and RANK_DEADLINE never do; RANK_SLACK does when a smaller
+     * packet follows a larger one, and a custom function may. A rank below the previous rank of
+     * its class (while that class is backlogged) is raised to it, so the head rank is never an
+     * understatement of what the class holds, and counted in GetClampedRanks().
+     *
+     * \note Packets must be enqueued through the scheduler so they are ranked. With flow sub-queues
+     * the class is keyed by the rank of whichever packet its flows put at the head.
+     */
+    class PIFO : public DiffServ
+    {
+    public:
+        /**
+         * \brief Built-in rank functions.
+         */
+        enum RankPolicy
+        {
+            RANK_PRIORITY,
+            RANK_FAIR,
+            RANK_DEADLINE,
+            RANK_SLACK,
+            RANK_CUSTOM
+        };
+
+        PIFO(RankPolicy policy = RANK_PRIORITY);
+        ~PIFO() override = default;
+
+        /**
+         * \brief Select the packet with the smallest rank.
+         * \returns Ptr<const Packet> packet at the front of the scheduled queue.
+         */
+        Ptr<const Packet> Schedule() const override;
+
+        /**
+         * \brief Select the backlogged queue whose head-of-line packet has the smallest rank.
+         * \returns The index of the scheduled queue, or NO_QUEUE if all queues are empty.
+         */
+        uint32_t ScheduleQueue() const override;
+
+        /**
+         * \brief Add a new TrafficClass to the PIFO scheduler.
+         * \param trafficClass pointer to the TrafficClass instance.
+         */
+        void RegisterQueue(TrafficClass* trafficClass) override;
+
+        /**
+         * \brief Use a user-supplied rank function (switches the policy to RANK_CUSTOM).
+         * \param rankFunction Called with the class index and the packet; lower ranks leave first.
+         */
+        void SetRankFunction(Callback<uint64_t, uint32_t, Ptr<const Packet>> rankFunction);
+
+        RankPolicy GetRankPolicy() const;
+
+        /**
+         * \brief Rate of the link the scheduler feeds, used by RANK_SLACK for transmission times.
+         */
+        void SetLinkRate(DataRate rate);
+
+        /**
+         * \brief Width of a PIFO bucket in rank bits (see RankQueue); set it before any packet is queued.
+         */
+        void SetGranularity(uint32_t bits);
+
+        /**
+         * \brief Rank of the head-of-line packet of a queue (0 when the queue holds no ranked packet).
+         */
+        uint64_t GetHeadRank(uint32_t index) const;
+
+        /**
+         * \brief Number of packets of a queue ranked below the previous packet of the queue, and raised to its rank.
+         */
+        uint64_t GetClampedRanks(uint32_t index) const;
+
+    protected:
+        /**
+         * \brief Drop the served packet's rank and take its queue out of the PIFO until its new head is known.
+         * \param index The queue returned by ScheduleQueue().
+         */
+        void CommitSchedule(uint32_t index) override;
+
+        /**
+         * \brief Put a queue back in the PIFO at its head rank, or take it out once it is idle or held.
+         * \param index The queue that changed.
+         */
+        void NotifyQueueChanged(uint32_t index) override;
+
+        /**
+         * \brief Rank the packet just queued.
+         * \param index The queue that took the packet.
+         * \param pkt The packet.
+         */
+        void NotifyEnqueued(uint32_t index, Ptr<const Packet> pkt) override;
+
+    private:
+        RankPolicy rankPolicy;
+        Callback<uint64_t, uint32_t, Ptr<const Packet>> rankFunction;
+        DataRate linkRate;
+
+        // Backlogged queues by head rank
+        RankQueue pifo;
+
+        // Rank of the last packet ranked per queue, and how many ranks were raised to it
+        std::vector<uint64_t> lastRank;
+        std::vector<uint64_t> clampedRanks;
+
+        // RANK_FAIR state: finish tag of the last packet ranked per queue, the start tag of the
+        // packet in service (the virtual time), and the largest finish tag (v after a busy period)
+        std::vector<double> finishTag;
+        double virtualTime;
+        double maxFinishTag;
+
+        /**
+         * \brief Rank of a queued packet, ranking and tagging it first if it has no rank yet.
+         */
+        uint64_t Stamp(uint32_t index, Ptr<const Packet> pkt);
+
+        /**
+         * \brief Run the rank function of the current policy.
+         */
+        uint64_t Rank(uint32_t index, Ptr<const Packet> pkt);
+
+        /**
+         * \brief Get the weight of a queue (a non-positive weight counts as 1).
+         */
+        double GetQueueWeight(uint32_t index) const;
+    };
+} // namespace ns3
+
+#endif // PIFO_H
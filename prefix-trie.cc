@@ -0,0 +1,105 @@
+#include "prefix-trie.h"
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Constructor for PrefixTrie. Starts with an empty root node.
+     */
+    PrefixTrie::PrefixTrie()
+    {
+        Clear();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Removes every prefix, keeping only an empty root node.
+     */
+    void PrefixTrie::Clear()
+    {
+        m_nodes.assign(1, Node());
+        m_prefixes = 0;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Adds a prefix, expanding it over the entries of the node where it ends.
+     * \details An entry keeps the longest prefix that covers it. Prefixes of equal length
+     * only collide when they are the same prefix, in which case the first class wins.
+     */
+    void PrefixTrie::Insert(uint32_t prefix, uint8_t length, uint32_t classIndex)
+    {
+        if (length > 32)
+        {
+            length = 32;
+        }
+
+        // Walk down one stride at a time until the prefix ends inside the current node
+        uint32_t node = 0;
+        uint32_t depth = 0;
+        while (length > depth + STRIDE)
+        {
+            uint32_t slot = (prefix >> (32 - depth - STRIDE)) & (FANOUT - 1);
+            if (m_nodes[node].entries[slot].child == NO_CHILD)
+            {
+                m_nodes[node].entries[slot].child = m_nodes.size();
+                m_nodes.emplace_back();
+            }
+
+            node = m_nodes[node].entries[slot].child;
+            depth += STRIDE;
+        }
+
+        // The prefix fixes the top (length - depth) bits of the slot, so it covers 2^(rest) slots
+        uint32_t fixedBits = length - depth;
+        uint32_t first = fixedBits == 0 ? 0 : ((prefix >> (32 - depth - STRIDE)) & (FANOUT - 1)) & ~((1u << (STRIDE - fixedBits)) - 1);
+        uint32_t count = 1u << (STRIDE - fixedBits);
+
+        for (uint32_t slot = first; slot < first + count; ++slot)
+        {
+            Entry& entry = m_nodes[node].entries[slot];
+            if (entry.length < length || (entry.length == length && classIndex < entry.classIndex))
+            {
+                entry.length = length;
+                entry.classIndex = classIndex;
+            }
+        }
+
+        m_prefixes++;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Walks down the trie; every rule found deeper is longer than the one before it.
+     */
+    uint32_t PrefixTrie::Lookup(uint32_t address) const
+    {
+        uint32_t best = NO_MATCH;
+        uint32_t node = 0;
+
+        for (uint32_t depth = 0; depth < 32; depth += STRIDE)
+        {
+            const Entry& entry = m_nodes[node].entries[(address >> (32 - depth - STRIDE)) & (FANOUT - 1)];
+            if (entry.length >= 0)
+            {
+                best = entry.classIndex;
+            }
+
+            if (entry.child == NO_CHILD)
+            {
+                break;
+            }
+            node = entry.child;
+        }
+
+        return best;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Checks if no prefixes are stored.
+     */
+    bool PrefixTrie::IsEmpty() const
+    {
+        return m_prefixes == 0;
+    }
+} // namespace ns3
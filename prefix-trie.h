@@ -0,0 +1,74 @@
+#ifndef PREFIX_TRIE_H
+#define PREFIX_TRIE_H
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Multibit trie for longest-prefix matching of IPv4 addresses.
+     *
+     * Each node consumes 4 address bits (16 entries), and prefixes that end inside a node
+     * are expanded over every entry they cover. A lookup therefore visits at most 8 nodes
+     * whatever the number of rules, and the last rule seen on the way down is the longest match.
+     */
+    class PrefixTrie
+    {
+        public:
+            // Returned by Lookup() when no prefix matches
+            static constexpr uint32_t NO_MATCH = std::numeric_limits<uint32_t>::max();
+
+            PrefixTrie();
+
+            /**
+             * \brief Remove every prefix.
+             */
+            void Clear();
+
+            /**
+             * \brief Add a prefix. For the same prefix, the lowest class index is kept.
+             * \param prefix The address prefix in host order (host bits cleared).
+             * \param length The prefix length in bits (0 to 32).
+             * \param classIndex The index of the traffic class that owns the rule.
+             */
+            void Insert(uint32_t prefix, uint8_t length, uint32_t classIndex);
+
+            /**
+             * \brief Find the class of the longest prefix covering an address.
+             * \param address The address in host order.
+             * \returns The class index, or NO_MATCH.
+             */
+            uint32_t Lookup(uint32_t address) const;
+
+            /**
+             * \brief Check if no prefixes are stored.
+             */
+            bool IsEmpty() const;
+
+        private:
+            static constexpr uint32_t STRIDE = 4;
+            static constexpr uint32_t FANOUT = 1 << STRIDE;
+            static constexpr uint32_t NO_CHILD = std::numeric_limits<uint32_t>::max();
+
+            // One slot of a node: the best rule ending here and the node below
+            struct Entry
+            {
+                uint32_t child = NO_CHILD;
+                uint32_t classIndex = NO_MATCH;
+                int32_t length = -1;
+            };
+
+            struct Node
+            {
+                Entry entries[FANOUT];
+            };
+
+            // Node 0 is the root
+            std::vector<Node> m_nodes;
+            uint32_t m_prefixes = 0;
+    };
+} // namespace ns3
+
+#endif // PREFIX_TRIE_H
@@ -1,6 +1,4 @@
-#include "ns3/ipv4-header.h"
 #include "protocol-number.h"
-#include "ns3/ppp-header.h"
 #include "ns3/log.h"
 
 NS_LOG_COMPONENT_DEFINE("ProtocolNumber");  
@@ -16,33 +14,33 @@ namespace ns3 {
     /**
      * \ingroup diffserv
      * \brief Match the packet against the stored protocol number.
-     * \param pkt The packet to inspect.
+     * \param key The parsed header view of the packet to inspect.
      * \returns true if the protocol number matches, false otherwise.
      */
     bool
-    ProtocolNumber::Match(Ptr<Packet> pkt) const
+    ProtocolNumber::Match(const FlowKey& key) const
     {
-        // Make a copy of the packet first to simplify header access
-        Ptr<Packet> packetCopy = pkt->Copy();
-
-        // Use Headers to remove the PPP header and check the protocol number
-        Ipv4Header ipv4Header;
-        PppHeader pppHeader;
-
-        if (!packetCopy->RemoveHeader(pppHeader))
-        {
-            NS_LOG_WARN("Packet does not contain PPP header");
-            return false;
-        }
-
-        // If we can't peek at the IPv4 header, the packet doesn't match.
-        if (!packetCopy->RemoveHeader(ipv4Header))
+        // If the IPv4 header could not be read, the packet doesn't match.
+        if (!key.hasIpv4)
         {
-            NS_LOG_WARN("Packet does not contain IPv4 header");
             return false;
         }
 
         // Compare protocol number from the header
-        return ipv4Header.GetProtocol() == m_protocolNumber;
+        return key.protocol == m_protocolNumber;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Describe the element as an exact match on the protocol number.
+     * \param field Set to FlowField::PROTOCOL.
+     * \param value Set to the protocol number to match.
+     * \returns true
+     */
+    bool ProtocolNumber::GetExactMatch(FlowField& field, uint32_t& value) const
+    {
+        field = FlowField::PROTOCOL;
+        value = m_protocolNumber;
+        return true;
     }
 } // namespace ns3
\ No newline at end of file
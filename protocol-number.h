@@ -13,6 +13,8 @@ namespace ns3 {
     class ProtocolNumber : public FilterElement
     {
         public:
+            using FilterElement::Match;
+
             /**
              * \brief Constructor.
              * \param protocolNumber The protocol number to match (6 = TCP, 17 = UDP).
@@ -21,10 +23,16 @@ namespace ns3 {
 
             /**
              * \brief Match the packet against the stored protocol number.
-             * \param pkt The packet to check for the protocol number match.
+             * \param key The parsed header view of the packet to check for the protocol number match.
              * \returns true if the protocol number is the same, false otherwise.
              */
-            bool Match(Ptr<Packet> pkt) const override;
+            bool Match(const FlowKey& key) const override;
+
+            /**
+             * \brief Describe the element as an exact match on the protocol number.
+             * \returns true, so DiffServ can index the element.
+             */
+            bool GetExactMatch(FlowField& field, uint32_t& value) const override;
 
         private:
             uint8_t m_protocolNumber;
@@ -0,0 +1,284 @@
+#include "rank-queue.h"
+
+/**
+ * PIFO Reference:
+ *
+ * Sivaraman, A., Subramanian, S., Alizadeh, M., Chole, S., Chuang, S.-T., Agrawal, A., Balakrishnan, H.,
+ * Edsall, T., Katti, S., & McKeown, N. (2016). Programmable Packet Scheduling at Line Rate.
+ * In Proceedings of ACM SIGCOMM '16 (pp. 44–57). https://doi.org/10.1145/2934872.2934899
+ *
+ * The bucketed find-first-set queue follows Saeed, A. et al. (2019). Eiffel: Efficient and Flexible
+ * Software Packet Scheduling. In Proceedings of USENIX NSDI '19 (pp. 17–32).
+ */
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Constructor for RankQueue.
+     */
+    RankQueue::RankQueue()
+    {
+        m_head.fill(NONE);
+        m_tail.fill(NONE);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Makes room for more class indices. Queued classes keep their ranks.
+     */
+    void RankQueue::Resize(uint32_t size)
+    {
+        m_rank.resize(size, 0);
+        m_slot.resize(size, NONE);
+        m_next.resize(size, NONE);
+        m_prev.resize(size, NONE);
+        m_overflow.Resize(size);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Sets the bucket width. Ignored while classes are queued, since their slots depend on it.
+     */
+    void RankQueue::SetGranularity(uint32_t bits)
+    {
+        if (m_size == 0)
+        {
+            m_granularity = bits < 63 ? bits : 63;
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the bucket width in bits.
+     */
+    uint32_t RankQueue::GetGranularity() const
+    {
+        return m_granularity;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Inserts a class or moves it to a new rank (behind the classes already in that bucket).
+     * \details An empty window never coexists with a non-empty heap (Rebase() refills it), so a
+     * push into an empty window can start the window at its own bucket.
+     */
+    void RankQueue::Push(uint32_t index, uint64_t rank)
+    {
+        Erase(index);
+
+        uint64_t bucket = rank >> m_granularity;
+        if (m_summary == 0)
+        {
+            m_base = bucket;
+        }
+
+        m_rank[index] = rank;
+        m_size++;
+
+        if (bucket >= m_base && bucket - m_base < WINDOW)
+        {
+            Link(index, bucket - m_base);
+        }
+        else
+        {
+            m_slot[index] = IN_OVERFLOW;
+            m_overflow.Push(index, static_cast<double>(rank));
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Takes a class out of the window or the heap.
+     */
+    void RankQueue::Erase(uint32_t index)
+    {
+        uint32_t slot = m_slot[index];
+        if (slot == NONE)
+        {
+            return;
+        }
+
+        if (slot == IN_OVERFLOW)
+        {
+            m_overflow.Erase(index);
+            m_slot[index] = NONE;
+        }
+        else
+        {
+            Unlink(index);
+            Rebase();
+        }
+
+        m_size--;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Checks if a class is queued.
+     */
+    bool RankQueue::Contains(uint32_t index) const
+    {
+        return index < m_slot.size() && m_slot[index] != NONE;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Checks if no class is queued.
+     */
+    bool RankQueue::IsEmpty() const
+    {
+        return m_size == 0;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of queued classes.
+     */
+    uint32_t RankQueue::GetSize() const
+    {
+        return m_size;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Returns the class with the smallest rank.
+     * \details The heap only holds ranks above the window, or ranks pushed in below its base, so
+     * one comparison of the two minimums decides.
+     */
+    uint32_t RankQueue::Top() const
+    {
+        uint32_t best = WindowTop();
+        if (!m_overflow.IsEmpty())
+        {
+            uint32_t candidate = m_overflow.Top();
+            if (best == NONE || m_rank[candidate] < m_rank[best])
+            {
+                best = candidate;
+            }
+        }
+
+        return best;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Returns the smallest rank.
+     */
+    uint64_t RankQueue::TopRank() const
+    {
+        return m_rank[Top()];
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the rank of a queued class.
+     */
+    uint64_t RankQueue::GetRank(uint32_t index) const
+    {
+        return m_rank[index];
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Appends a class to a window slot and marks the slot non-empty.
+     */
+    void RankQueue::Link(uint32_t index, uint32_t slot)
+    {
+        m_slot[index] = slot;
+        m_next[index] = NONE;
+        m_prev[index] = m_tail[slot];
+
+        if (m_tail[slot] == NONE)
+        {
+            m_head[slot] = index;
+            m_words[slot / 64] |= 1ULL << (slot % 64);
+            m_summary |= 1ULL << (slot / 64);
+        }
+        else
+        {
+            m_next[m_tail[slot]] = index;
+        }
+        m_tail[slot] = index;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Takes a class out of its window slot and clears the slot's bit once it is empty.
+     */
+    void RankQueue::Unlink(uint32_t index)
+    {
+        uint32_t slot = m_slot[index];
+
+        if (m_prev[index] == NONE)
+        {
+            m_head[slot] = m_next[index];
+        }
+        else
+        {
+            m_next[m_prev[index]] = m_next[index];
+        }
+
+        if (m_next[index] == NONE)
+        {
+            m_tail[slot] = m_prev[index];
+        }
+        else
+        {
+            m_prev[m_next[index]] = m_prev[index];
+        }
+
+        m_slot[index] = NONE;
+
+        if (m_head[slot] == NONE)
+        {
+            m_words[slot / 64] &= ~(1ULL << (slot % 64));
+            if (m_words[slot / 64] == 0)
+            {
+                m_summary &= ~(1ULL << (slot / 64));
+            }
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Finds the lowest non-empty slot with two count-trailing-zeros instructions.
+     */
+    uint32_t RankQueue::WindowTop() const
+    {
+        if (m_summary == 0)
+        {
+            return NONE;
+        }
+
+        uint32_t word = __builtin_ctzll(m_summary);
+        uint32_t slot = word * 64 + __builtin_ctzll(m_words[word]);
+        return m_head[slot];
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Starts an empty window at the smallest overflow rank and moves every class that fits.
+     * \details The heap pops in rank order, so the classes of one bucket keep rank order in its FIFO.
+     */
+    void RankQueue::Rebase()
+    {
+        if (m_summary != 0 || m_overflow.IsEmpty())
+        {
+            return;
+        }
+
+        m_base = m_rank[m_overflow.Top()] >> m_granularity;
+        while (!m_overflow.IsEmpty())
+        {
+            uint32_t index = m_overflow.Top();
+            uint64_t bucket = m_rank[index] >> m_granularity;
+            if (bucket - m_base >= WINDOW)
+            {
+                break;
+            }
+
+            m_overflow.Erase(index);
+            Link(index, bucket - m_base);
+        }
+    }
+} // namespace ns3
@@ -0,0 +1,120 @@
+#ifndef RANK_QUEUE_H
+#define RANK_QUEUE_H
+
+#include "class-heap.h"
+#include <vector>
+#include <array>
+#include <cstdint>
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Bounded priority queue of traffic classes keyed by an integer rank (the PIFO engine).
+     *
+     * Ranks are grouped into buckets of 2^granularity consecutive ranks, and a window of WINDOW
+     * buckets starting at a base bucket holds one FIFO list of classes per bucket. A two-level
+     * bitmap marks the non-empty buckets, so push, erase and finding the smallest rank cost a few
+     * count-trailing-zeros instructions whatever the number of classes. Classes in one bucket leave
+     * in the order they arrived, so a granularity above zero trades exact rank order for fewer
+     * buckets (the calendar queue trade-off).
+     *
+     * A rank outside the window (above it, or pushed in below the base) goes to a ClassHeap. When
+     * the window empties it moves to the smallest rank of the heap and takes back the classes that
+     * now fit, so ranks that keep growing (virtual times, deadlines) cost O(log n) only once per
+     * window. Each class index appears at most once.
+     */
+    class RankQueue
+    {
+        public:
+            // Buckets in the window (64 x 64 bitmap)
+            static constexpr uint32_t WINDOW = 64 * 64;
+
+            RankQueue();
+
+            /**
+             * \brief Make room for class indices 0 .. size - 1.
+             */
+            void Resize(uint32_t size);
+
+            /**
+             * \brief Set how many low rank bits a bucket ignores (only while the queue is empty).
+             */
+            void SetGranularity(uint32_t bits);
+            uint32_t GetGranularity() const;
+
+            /**
+             * \brief Insert a class, or move it to a new rank if it is already queued.
+             */
+            void Push(uint32_t index, uint64_t rank);
+
+            /**
+             * \brief Take a class out of the queue (no-op if it is not in it).
+             */
+            void Erase(uint32_t index);
+
+            bool Contains(uint32_t index) const;
+            bool IsEmpty() const;
+            uint32_t GetSize() const;
+
+            /**
+             * \brief Class with the smallest rank (the queue must not be empty).
+             */
+            uint32_t Top() const;
+            uint64_t TopRank() const;
+
+            /**
+             * \brief Rank a queued class was pushed with.
+             */
+            uint64_t GetRank(uint32_t index) const;
+
+        private:
+            static constexpr uint32_t NONE = UINT32_MAX;
+            static constexpr uint32_t IN_OVERFLOW = UINT32_MAX - 1;
+
+            uint32_t m_granularity = 0;
+
+            // Bucket number of the first window slot
+            uint64_t m_base = 0;
+
+            // FIFO of classes per window slot
+            std::array<uint32_t, WINDOW> m_head;
+            std::array<uint32_t, WINDOW> m_tail;
+
+            // Bit s of m_words[s / 64] is set while slot s is non-empty.
+            // Bit w of m_summary is set while m_words[w] is non-zero.
+            std::array<uint64_t, WINDOW / 64> m_words{};
+            uint64_t m_summary = 0;
+
+            // Per class: rank, window slot (or IN_OVERFLOW / NONE) and links in the slot's FIFO
+            std::vector<uint64_t> m_rank;
+            std::vector<uint32_t> m_slot;
+            std::vector<uint32_t> m_next;
+            std::vector<uint32_t> m_prev;
+            uint32_t m_size = 0;
+
+            // Classes whose rank is outside the window
+            ClassHeap m_overflow;
+
+            /**
+             * \brief Append a class to a window slot.
+             */
+            void Link(uint32_t index, uint32_t slot);
+
+            /**
+             * \brief Take a class out of its window slot.
+             */
+            void Unlink(uint32_t index);
+
+            /**
+             * \brief First class of the lowest non-empty window slot, or NONE.
+             */
+            uint32_t WindowTop() const;
+
+            /**
+             * \brief Move an empty window to the smallest overflow rank and refill it from the heap.
+             */
+            void Rebase();
+    };
+} // namespace ns3
+
+#endif // RANK_QUEUE_H
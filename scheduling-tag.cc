@@ -0,0 +1,71 @@
+#include "scheduling-tag.h"
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Constructor for SchedulingTag, with a zero stamp.
+     */
+    SchedulingTag::SchedulingTag() : m_value(0) {}
+
+    /**
+     * \ingroup diffserv
+     * \brief Constructor for SchedulingTag with the given stamp.
+     */
+    SchedulingTag::SchedulingTag(uint64_t value) : m_value(value) {}
+
+    /**
+     * \ingroup diffserv
+     * \brief Registers the tag type with ns-3.
+     */
+    TypeId SchedulingTag::GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::SchedulingTag")
+            .SetParent<Tag>()
+            .SetGroupName("DiffServ")
+            .AddConstructor<SchedulingTag>();
+        return tid;
+    }
+
+    TypeId SchedulingTag::GetInstanceTypeId() const
+    {
+        return GetTypeId();
+    }
+
+    uint32_t SchedulingTag::GetSerializedSize() const
+    {
+        return sizeof(m_value);
+    }
+
+    void SchedulingTag::Serialize(TagBuffer buffer) const
+    {
+        buffer.WriteU64(m_value);
+    }
+
+    void SchedulingTag::Deserialize(TagBuffer buffer)
+    {
+        m_value = buffer.ReadU64();
+    }
+
+    void SchedulingTag::Print(std::ostream& os) const
+    {
+        os << "stamp=" << m_value;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the stamp.
+     */
+    uint64_t SchedulingTag::GetValue() const
+    {
+        return m_value;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the stamp.
+     */
+    void SchedulingTag::SetValue(uint64_t value)
+    {
+        m_value = value;
+    }
+} // namespace ns3
@@ -0,0 +1,40 @@
+#ifndef SCHEDULING_TAG_H
+#define SCHEDULING_TAG_H
+
+#include "ns3/tag.h"
+#include <cstdint>
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Packet tag holding the rank or deadline a scheduler stamped on a packet when it was queued.
+     *
+     * The stamp travels with the packet itself, so it stays right however a class reorders or
+     * evicts its packets (flow sub-queues serve flows in turn and drop from the longest one). The
+     * scheduler takes the tag off again when the packet is served.
+     */
+    class SchedulingTag : public Tag
+    {
+        public:
+            SchedulingTag();
+            explicit SchedulingTag(uint64_t value);
+
+            static TypeId GetTypeId();
+            TypeId GetInstanceTypeId() const override;
+            uint32_t GetSerializedSize() const override;
+            void Serialize(TagBuffer buffer) const override;
+            void Deserialize(TagBuffer buffer) override;
+            void Print(std::ostream& os) const override;
+
+            /**
+             * \brief The stamp: a PIFO rank, or an EDF deadline in ns.
+             */
+            uint64_t GetValue() const;
+            void SetValue(uint64_t value);
+
+        private:
+            uint64_t m_value;
+    };
+} // namespace ns3
+
+#endif // SCHEDULING_TAG_H
@@ -3,7 +3,11 @@
 #include <fstream>
 #include "json.hpp"
 #include "destination-port-number.h"
+#include "credit-based-shaper.h"
 #include <filesystem>
+#include <algorithm>
+#include <map>
+#include <iterator>
 
 // Include the necessary headers for JSON parsing
 using json = nlohmann::json;
@@ -12,6 +16,7 @@ namespace ns3 {
 
     // Define constants for packet size and interval
     const Time Simulation::PACKET_TRANS_INTERVAL = Seconds(0.002);
+    const DataRate Simulation::BOTTLENECK_RATE = DataRate("1Mbps");
 
     // Define constants for the stop, start and interval times
     static constexpr double STOP_TIME        = 50.0;
@@ -53,6 +58,78 @@ namespace ns3 {
         return { preName, postName };
     }
 
+    /**
+     * \brief Parses one node of a hierarchical scheduler tree (and its subtree).
+     * \param input The JSON object of the node.
+     * \param node The parsed node.
+     * \returns true if parsing fails, false otherwise.
+     */
+    static bool ParseSchedulerNode(const json& input, SchedulerNodeConfig& node)
+    {
+        // Priority and Weight describe the node's place in its parent
+        node.priority = input.value("Priority", 0u);
+        node.weight = input.value("Weight", 0u);
+
+        // A leaf names a queue
+        if (input.contains("Queue")) {
+            node.queue = input["Queue"];
+            return false;
+        }
+
+        node.type = input.value("Type", std::string());
+        if (node.type != "SPQ" && node.type != "DRR" && node.type != "WFQ") {
+            NS_LOG_UNCOND("Invalid config file format: Tree nodes need a Queue or a Type of SPQ, DRR or WFQ");
+            return true;
+        }
+
+        if (!input.contains("Children") || input["Children"].empty()) {
+            NS_LOG_UNCOND("Invalid config file format: " << node.type << " tree node without Children");
+            return true;
+        }
+
+        for (const auto& child : input["Children"]) {
+            node.children.emplace_back();
+            if (ParseSchedulerNode(child, node.children.back())) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * \brief Counts how many tree leaves name each queue.
+     */
+    static void CountSchedulerLeaves(const SchedulerNodeConfig& node, std::map<uint32_t, uint32_t>& leaves)
+    {
+        if (node.type.empty()) {
+            leaves[node.queue]++;
+        }
+
+        for (const auto& child : node.children) {
+            CountSchedulerLeaves(child, leaves);
+        }
+    }
+
+    /**
+     * \brief Prints one node of a hierarchical scheduler tree (and its subtree).
+     */
+    static void PrintSchedulerNode(const SchedulerNodeConfig& node, const std::string& indent)
+    {
+        std::ostringstream line;
+        if (node.type.empty()) {
+            line << "Queue " << node.queue;
+        } else {
+            line << node.type;
+        }
+        line << " (Priority " << node.priority << ", Weight " << node.weight << ")";
+        NS_LOG_UNCOND(indent << line.str());
+
+        for (const auto& child : node.children) {
+            PrintSchedulerNode(child, indent + "  ");
+        }
+    }
+
     /**
      * \brief Parses the configuration file and initializes QoS data.
      * \param configFileName The path to the configuration file.
@@ -92,23 +169,91 @@ namespace ns3 {
             return true;
         }
 
-        // Initialize the QoS data structure (Type is either SPQ or DRR)
+        // Initialize the QoS data structure (Type is SPQ, DRR or Hierarchical)
         qosConfig.qosType = configInput["QoS"]["Type"];
 
+        // Optional aggregate byte limit (shared by every queue)
+        qosConfig.totalMaxBytes = configInput["QoS"].value("MaxBytes", 0u);
+
+        // Optional shared buffer pool (in packets)
+        qosConfig.sharedBufferPackets = configInput["QoS"].value("SharedBuffer", 0u);
+
+        // Optional flow cache size
+        qosConfig.flowCacheSize = configInput["QoS"].value("FlowCacheSize", DiffServ::DEFAULT_FLOW_CACHE_SIZE);
+
+        // Optional classifier mode
+        qosConfig.classifierMode = configInput["QoS"].value("Classifier", std::string("Indexed"));
+        if (qosConfig.classifierMode != "Indexed" && qosConfig.classifierMode != "DecisionTree" && qosConfig.classifierMode != "Linear") {
+            NS_LOG_UNCOND("Invalid config file format: Unknown Classifier " << qosConfig.classifierMode);
+            return true;
+        }
+
+        // PIFO rank function
+        if (qosConfig.qosType == "PIFO") {
+            qosConfig.pifoRank = configInput["QoS"].value("Rank", std::string("Priority"));
+            if (qosConfig.pifoRank != "Priority" && qosConfig.pifoRank != "Fair" && qosConfig.pifoRank != "Deadline" && qosConfig.pifoRank != "Slack") {
+                NS_LOG_UNCOND("Invalid config file format: Unknown Rank " << qosConfig.pifoRank);
+                return true;
+            }
+        }
+
+        // PIAS demotion thresholds and flow table
+        if (qosConfig.qosType == "PIAS") {
+            if (!configInput["QoS"].contains("Thresholds")) {
+                NS_LOG_UNCOND("Invalid config file format: PIAS QoS without Thresholds");
+                return true;
+            }
+            qosConfig.piasThresholds = configInput["QoS"]["Thresholds"].get<std::vector<uint64_t>>();
+            qosConfig.flowTableSize = configInput["QoS"].value("FlowTableSize", FlowTable::DEFAULT_CAPACITY);
+            qosConfig.flowIdleTimeout = configInput["QoS"].value("FlowIdleTimeout", 0.0);
+        }
+
         // Set the attribute values for the queues
         for (const auto& queue : configInput["QoS"]["Queues"]) {
 
-            qosConfig.maxPackets.push_back(queue["MaxPackets"]);
+            // With a shared pool MaxPackets is only a hard cap, so it defaults to the pool size
+            if (qosConfig.sharedBufferPackets > 0) {
+                qosConfig.maxPackets.push_back(queue.value("MaxPackets", qosConfig.sharedBufferPackets));
+                if (qosConfig.maxPackets.back() > qosConfig.sharedBufferPackets) {
+                    NS_LOG_UNCOND("Invalid config file format: MaxPackets is above the SharedBuffer");
+                    return true;
+                }
+            } else {
+                qosConfig.maxPackets.push_back(queue["MaxPackets"]);
+            }
+            qosConfig.maxBytes.push_back(queue.value("MaxBytes", 0u));
+            qosConfig.alphas.push_back(queue.value("Alpha", 1.0));
+            qosConfig.shapeRates.push_back(queue.value("ShapeRate", std::string()));
+            qosConfig.shapeBursts.push_back(queue.value("ShapeBurst", PACKET_SIZE * 2));
+            qosConfig.idleSlopes.push_back(queue.value("IdleSlope", std::string()));
+            qosConfig.sendSlopes.push_back(queue.value("SendSlope", std::string()));
+            if (!qosConfig.shapeRates.back().empty() && !qosConfig.idleSlopes.back().empty()) {
+                NS_LOG_UNCOND("Invalid config file format: a queue has either a ShapeRate or an IdleSlope");
+                return true;
+            }
+            qosConfig.flowQueues.push_back(queue.value("FlowQueues", 0u));
+            qosConfig.flowQuanta.push_back(queue.value("FlowQuantum", StochasticFairQueue::DEFAULT_QUANTUM));
+            qosConfig.flowPerturbations.push_back(queue.value("FlowPerturbation", 10.0));
             qosConfig.destinationPorts.push_back(queue["DestPort"]);
             qosConfig.defaults.push_back(queue["Default"]);
+            qosConfig.queueNumbers.push_back(queue.value("no", static_cast<uint32_t>(qosConfig.queueNumbers.size() + 1)));
 
             // Check if the queue has a priority or weight attribute and add it to the respective attribute
             // This is done using the type of the queue (SPQ or DRR)
             if (qosConfig.qosType == "SPQ") {
                 qosConfig.priorities.push_back(queue["Priority"]);
 
-            } else if (qosConfig.qosType == "DRR") {
+            } else if (qosConfig.qosType == "DRR" || qosConfig.qosType == "WF2Q" || qosConfig.qosType == "STFQ") {
                 qosConfig.weights.push_back(queue["Weight"]);
+
+            } else if (qosConfig.qosType == "PIFO") {
+                // Each rank function reads its own metadata, so all of it is optional
+                qosConfig.priorities.push_back(queue.value("Priority", 0u));
+                qosConfig.weights.push_back(queue.value("Weight", 1u));
+                qosConfig.delayBudgets.push_back(queue.value("DelayBudget", 0.0));
+
+            } else if (qosConfig.qosType == "EDF") {
+                qosConfig.delayBudgets.push_back(queue["DelayBudget"]);
             }
         }
 
@@ -116,6 +261,81 @@ namespace ns3 {
         // This is the size of the destination ports vector
         qosConfig.queueCount = qosConfig.destinationPorts.size();
 
+        // The SPQ traffic (also used by PIAS and priority-ranked PIFO) starts one client per queue
+        // at its own offset, so there may not be more queues than offsets
+        bool spqTraffic = qosConfig.qosType == "SPQ" || qosConfig.qosType == "PIAS" ||
+                          (qosConfig.qosType == "PIFO" && qosConfig.pifoRank == "Priority");
+        if (spqTraffic && qosConfig.queueCount > std::size(CLIENT_START_OFFSETS)) {
+            NS_LOG_UNCOND("Invalid config file format: " << qosConfig.qosType << " drives at most "
+                          << std::size(CLIENT_START_OFFSETS) << " queues, one client each");
+            return true;
+        }
+
+        // Optional 802.1Qbv gate control list, gating the queues by their number
+        if (configInput["QoS"].contains("GateControlList")) {
+            const auto& gateControlList = configInput["QoS"]["GateControlList"];
+            if (qosConfig.qosType == "Hierarchical") {
+                NS_LOG_UNCOND("Invalid config file format: a GateControlList cannot gate a Hierarchical tree");
+                return true;
+            }
+            if (!gateControlList.contains("Entries") || gateControlList["Entries"].empty()) {
+                NS_LOG_UNCOND("Invalid config file format: GateControlList without Entries");
+                return true;
+            }
+            if (qosConfig.queueCount > 64) {
+                NS_LOG_UNCOND("Invalid config file format: a GateControlList gates at most 64 queues");
+                return true;
+            }
+
+            qosConfig.gateBaseTime = gateControlList.value("BaseTime", 0.0);
+            qosConfig.gateGuardBand = gateControlList.value("GuardBand", -1.0);
+            for (const auto& entry : gateControlList["Entries"]) {
+                qosConfig.gateDurations.push_back(entry["Duration"]);
+
+                // Bit i opens the i-th queue of the config
+                uint64_t gates = 0;
+                for (uint32_t number : entry["Gates"]) {
+                    auto queue = std::find(qosConfig.queueNumbers.begin(), qosConfig.queueNumbers.end(), number);
+                    if (queue == qosConfig.queueNumbers.end()) {
+                        NS_LOG_UNCOND("Invalid config file format: GateControlList opens unknown queue " << number);
+                        return true;
+                    }
+                    gates |= uint64_t(1) << (queue - qosConfig.queueNumbers.begin());
+                }
+                qosConfig.gateStates.push_back(gates);
+            }
+        }
+
+        // A hierarchical scheduler needs a tree whose leaves name every queue exactly once
+        if (qosConfig.qosType == "Hierarchical") {
+            if (!configInput["QoS"].contains("Tree")) {
+                NS_LOG_UNCOND("Invalid config file format: Hierarchical QoS without a Tree");
+                return true;
+            }
+
+            if (ParseSchedulerNode(configInput["QoS"]["Tree"], qosConfig.tree)) {
+                return true;
+            }
+
+            if (qosConfig.tree.type.empty()) {
+                NS_LOG_UNCOND("Invalid config file format: the Tree root must be an SPQ, DRR or WFQ node");
+                return true;
+            }
+
+            std::map<uint32_t, uint32_t> leaves;
+            CountSchedulerLeaves(qosConfig.tree, leaves);
+            for (uint32_t number : qosConfig.queueNumbers) {
+                if (leaves[number] != 1) {
+                    NS_LOG_UNCOND("Invalid config file format: queue " << number << " must appear exactly once in the Tree");
+                    return true;
+                }
+            }
+            if (leaves.size() != qosConfig.queueCount) {
+                NS_LOG_UNCOND("Invalid config file format: the Tree names a queue that is not in Queues");
+                return true;
+            }
+        }
+
         return false;
     }
 
@@ -129,30 +349,266 @@ namespace ns3 {
         NS_LOG_UNCOND("QoS Configuration:");
         NS_LOG_UNCOND("  Scheduler Type: " << qosConfig.qosType);
         NS_LOG_UNCOND("  Queue Count:    " << qosConfig.queueCount);
+        if (qosConfig.totalMaxBytes > 0) {
+            NS_LOG_UNCOND("  MaxBytes:       " << qosConfig.totalMaxBytes);
+        }
+        if (qosConfig.sharedBufferPackets > 0) {
+            NS_LOG_UNCOND("  SharedBuffer:   " << qosConfig.sharedBufferPackets);
+        }
+        NS_LOG_UNCOND("  FlowCacheSize:  " << qosConfig.flowCacheSize);
+        NS_LOG_UNCOND("  Classifier:     " << qosConfig.classifierMode);
+        if (qosConfig.qosType == "PIFO") {
+            NS_LOG_UNCOND("  Rank:           " << qosConfig.pifoRank);
+        }
+        if (qosConfig.qosType == "PIAS") {
+            std::string thresholds;
+            for (uint64_t threshold : qosConfig.piasThresholds) {
+                thresholds += (thresholds.empty() ? "" : ", ") + std::to_string(threshold);
+            }
+            NS_LOG_UNCOND("  Thresholds:     [" << thresholds << "] bytes");
+            NS_LOG_UNCOND("  FlowTableSize:  " << qosConfig.flowTableSize);
+            NS_LOG_UNCOND("  FlowIdleTimeout: " << qosConfig.flowIdleTimeout << "ms");
+        }
 
         // Print the queue attributes
         for (uint32_t i = 0; i < qosConfig.queueCount; ++i) {
             NS_LOG_UNCOND("  Queue " << i + 1 << ":");
             NS_LOG_UNCOND("    MaxPackets: " << qosConfig.maxPackets[i]);
+            if (qosConfig.maxBytes[i] > 0) {
+                NS_LOG_UNCOND("    MaxBytes:   " << qosConfig.maxBytes[i]);
+            }
+            if (qosConfig.sharedBufferPackets > 0) {
+                NS_LOG_UNCOND("    Alpha:      " << qosConfig.alphas[i]);
+            }
+            if (!qosConfig.shapeRates[i].empty()) {
+                NS_LOG_UNCOND("    ShapeRate:  " << qosConfig.shapeRates[i]);
+                NS_LOG_UNCOND("    ShapeBurst: " << qosConfig.shapeBursts[i]);
+            }
+            if (!qosConfig.idleSlopes[i].empty()) {
+                NS_LOG_UNCOND("    IdleSlope:  " << qosConfig.idleSlopes[i]);
+                NS_LOG_UNCOND("    SendSlope:  " << (qosConfig.sendSlopes[i].empty() ? "port rate - IdleSlope" : qosConfig.sendSlopes[i]));
+            }
+            if (qosConfig.flowQueues[i] > 0) {
+                NS_LOG_UNCOND("    FlowQueues: " << qosConfig.flowQueues[i] << " (quantum " << qosConfig.flowQuanta[i]
+                              << ", perturbation " << qosConfig.flowPerturbations[i] << "s)");
+            }
             NS_LOG_UNCOND("    DestPort:   " << qosConfig.destinationPorts[i]);
             NS_LOG_UNCOND("    Default:    " << (qosConfig.defaults[i] ? "true" : "false"));
             // Print the priority or weight based on the QoS type
             // This is done using the type of the queue (SPQ or DRR)
             if (qosConfig.qosType == "SPQ") {
                 NS_LOG_UNCOND("    Priority:   " << qosConfig.priorities[i]);
-            } else if (qosConfig.qosType == "DRR") {
+            } else if (qosConfig.qosType == "DRR" || qosConfig.qosType == "WF2Q" || qosConfig.qosType == "STFQ") {
                 NS_LOG_UNCOND("    Weight:     " << qosConfig.weights[i]);
+            } else if (qosConfig.qosType == "PIFO") {
+                NS_LOG_UNCOND("    Priority:   " << qosConfig.priorities[i]);
+                NS_LOG_UNCOND("    Weight:     " << qosConfig.weights[i]);
+                NS_LOG_UNCOND("    Budget:     " << qosConfig.delayBudgets[i] << "ms");
+            } else if (qosConfig.qosType == "EDF") {
+                NS_LOG_UNCOND("    Budget:     " << qosConfig.delayBudgets[i] << "ms");
+            }
+        }
+
+        // Print the gate control list
+        if (!qosConfig.gateDurations.empty()) {
+            NS_LOG_UNCOND("  GateControlList (base " << qosConfig.gateBaseTime << "ms, guard band "
+                          << GetGuardBand().GetMicroSeconds() / 1000.0 << "ms):");
+            for (uint32_t k = 0; k < qosConfig.gateDurations.size(); ++k) {
+                std::string open;
+                for (uint32_t i = 0; i < qosConfig.queueCount; ++i) {
+                    if ((qosConfig.gateStates[k] >> i) & 1) {
+                        open += (open.empty() ? "" : ", ") + std::to_string(qosConfig.queueNumbers[i]);
+                    }
+                }
+                NS_LOG_UNCOND("    " << qosConfig.gateDurations[k] << "ms: queues [" << open << "] open");
+            }
+        }
+
+        // Print the scheduler tree of a hierarchical scheduler
+        if (qosConfig.qosType == "Hierarchical") {
+            NS_LOG_UNCOND("  Tree:");
+            PrintSchedulerNode(qosConfig.tree, "    ");
+        }
+    }
+    /**
+     * \brief Prints scheduler statistics to the console.
+     * This function prints the flow cache hits and misses of the QoS scheduler.
+     */
+    void Simulation::PrintStats() const
+    {
+        Ptr<DiffServ> scheduler = GetScheduler();
+        if (!scheduler) {
+            return;
+        }
+
+        NS_LOG_UNCOND("Scheduler Statistics:");
+        NS_LOG_UNCOND("  Flow Cache Hits:   " << scheduler->GetFlowCacheHits());
+        NS_LOG_UNCOND("  Flow Cache Misses: " << scheduler->GetFlowCacheMisses());
+
+        // Whether each queue met its delay budget
+        if (edf) {
+            for (uint32_t i = 0; i < qosConfig.queueCount; ++i) {
+                NS_LOG_UNCOND("  Queue " << i + 1 << " Deadlines: " << edf->GetDeadlineMisses(i) << " of " << edf->GetServed(i)
+                              << " missed (max " << edf->GetMaxLateness(i).GetMilliSeconds() << "ms late)");
+            }
+        }
+
+        // Ranks raised to keep the order within each queue
+        if (pifo) {
+            for (uint32_t i = 0; i < qosConfig.queueCount; ++i) {
+                NS_LOG_UNCOND("  Queue " << i + 1 << " Clamped Ranks: " << pifo->GetClampedRanks(i));
+            }
+        }
+
+        // How the flows spread over the levels
+        if (pias) {
+            for (uint32_t i = 0; i < qosConfig.queueCount; ++i) {
+                NS_LOG_UNCOND("  Level " << i << " Packets: " << pias->GetLevelPackets(i));
+            }
+            NS_LOG_UNCOND("  Flow Table Evictions: " << pias->GetFlowEvictions());
+        }
+    }
+
+    /**
+     * \brief Returns the scheduler built for the configured QoS type.
+     * \returns The scheduler, or a null pointer before InitializeQosScheduler.
+     */
+    Ptr<DiffServ> Simulation::GetScheduler() const
+    {
+        Ptr<DiffServ> scheduler;
+        if (qosConfig.qosType == "SPQ") {
+            scheduler = spq;
+        } else if (qosConfig.qosType == "DRR") {
+            scheduler = drr;
+        } else if (qosConfig.qosType == "WF2Q") {
+            scheduler = wf2q;
+        } else if (qosConfig.qosType == "STFQ") {
+            scheduler = stfq;
+        } else if (qosConfig.qosType == "PIFO") {
+            scheduler = pifo;
+        } else if (qosConfig.qosType == "EDF") {
+            scheduler = edf;
+        } else if (qosConfig.qosType == "PIAS") {
+            scheduler = pias;
+        } else if (qosConfig.qosType == "Hierarchical") {
+            scheduler = hierarchical;
+        }
+
+        return scheduler;
+    }
+
+    /**
+     * \brief Guard band of the gate control list.
+     * \returns The configured guard band, or by default the transmission time of a full-sized
+     * frame on the bottleneck link.
+     */
+    Time Simulation::GetGuardBand() const
+    {
+        if (qosConfig.gateGuardBand >= 0) {
+            return Seconds(qosConfig.gateGuardBand / 1000.0);
+        }
+
+        // Payload plus the IPv4, UDP and PPP headers
+        return BOTTLENECK_RATE.CalculateBytesTxTime(PACKET_SIZE + 20 + 8 + 2);
+    }
+
+    /**
+     * \brief Maps the configured classifier mode name to the DiffServ enum.
+     * \returns The classifier mode (names are checked in parseConfigs).
+     */
+    DiffServ::ClassifierMode Simulation::GetClassifierMode() const
+    {
+        if (qosConfig.classifierMode == "DecisionTree") {
+            return DiffServ::CLASSIFIER_DECISION_TREE;
+        } else if (qosConfig.classifierMode == "Linear") {
+            return DiffServ::CLASSIFIER_LINEAR;
+        }
+
+        return DiffServ::CLASSIFIER_INDEXED;
+    }
+
+    /**
+     * \brief Attaches the optional token bucket or credit-based shaper of a queue.
+     * \param trafficClass The traffic class built for the queue.
+     * \param i The queue index in the configuration.
+     */
+    void Simulation::InitializeShaper(TrafficClass* trafficClass, uint32_t i) const
+    {
+        // Credit-based shaper on the bottleneck port
+        if (!qosConfig.idleSlopes[i].empty())
+        {
+            CreditBasedShaper* shaper = new CreditBasedShaper(DataRate(qosConfig.idleSlopes[i]), BOTTLENECK_RATE);
+            if (!qosConfig.sendSlopes[i].empty())
+            {
+                shaper->SetSendSlope(DataRate(qosConfig.sendSlopes[i]));
             }
+            trafficClass->SetShaper(shaper);
+            return;
         }
+
+        if (qosConfig.shapeRates[i].empty())
+        {
+            return;
+        }
+
+        trafficClass->SetShaper(new TrafficShaper(DataRate(qosConfig.shapeRates[i]), qosConfig.shapeBursts[i]));
     }
+
+    /**
+     * \brief Attaches the optional per-flow sub-queues of a queue.
+     * \param trafficClass The traffic class built for the queue (after its MaxPackets is set).
+     * \param i The queue index in the configuration.
+     */
+    void Simulation::InitializeFlowQueue(TrafficClass* trafficClass, uint32_t i) const
+    {
+        if (qosConfig.flowQueues[i] == 0)
+        {
+            return;
+        }
+
+        trafficClass->SetFlowQueue(new StochasticFairQueue(qosConfig.flowQueues[i], qosConfig.flowQuanta[i], Seconds(qosConfig.flowPerturbations[i])));
+    }
+
     /**
-     * \brief Initializes the DRR queue scheduler.
-     * This function creates an instance of the DRR class and populates it with the parsed data.
+     * \brief Initializes the weighted (DRR, WF2Q+ or SFQ) queue scheduler.
+     * This function creates an instance of the DRR, WF2Q or STFQ class and populates it with the parsed data.
+     * Both read the same weights, so a config can switch between them by Type alone.
      */
-    void Simulation::InitializeDrr()
+    void Simulation::InitializeWeighted()
     {
-        // Create an instance of the DRR class
-        drr = CreateObject<DRR>();
+        // Create an instance of the DRR, WF2Q or STFQ class
+        Ptr<DiffServ> scheduler;
+        if (qosConfig.qosType == "WF2Q")
+        {
+            wf2q = CreateObject<WF2Q>();
+            scheduler = wf2q;
+        }
+        else if (qosConfig.qosType == "STFQ")
+        {
+            stfq = CreateObject<STFQ>();
+            scheduler = stfq;
+        }
+        else
+        {
+            drr = CreateObject<DRR>();
+            scheduler = drr;
+        }
+
+        // Apply the optional aggregate byte limit through the MaxSize attribute
+        if (qosConfig.totalMaxBytes > 0)
+        {
+            scheduler->SetMaxSize(QueueSize(QueueSizeUnit::BYTES, qosConfig.totalMaxBytes));
+        }
+
+        // Let all queues draw from one pool with dynamic thresholds
+        if (qosConfig.sharedBufferPackets > 0)
+        {
+            scheduler->SetSharedBuffer(QueueSize(QueueSizeUnit::PACKETS, qosConfig.sharedBufferPackets));
+        }
+
+        // Size the classifier's flow cache and pick its rule lookup
+        scheduler->SetFlowCacheSize(qosConfig.flowCacheSize);
+        scheduler->SetClassifierMode(GetClassifierMode());
 
         // Set the queue filters and traffic class values
         for (int i = 0; i < qosConfig.queueCount; i++)
@@ -171,14 +627,112 @@ namespace ns3 {
             trafficClass->SetMaxPackets(qosConfig.maxPackets[i]);
             trafficClass->SetWeight(qosConfig.weights[i]);
             trafficClass->SetIsDefault(qosConfig.defaults[i]);
+            trafficClass->SetAlpha(qosConfig.alphas[i]);
+            InitializeShaper(trafficClass, i);
+            InitializeFlowQueue(trafficClass, i);
+
+            // Apply the optional byte budget
+            if (qosConfig.maxBytes[i] > 0)
+            {
+                trafficClass->SetMaxBytes(qosConfig.maxBytes[i]);
+            }
 
             // Add the filter to the traffic class
             // This is done to match the packets against the filter
             trafficClass->AddFilter(filter);
 
-            // Add the traffic class to the DRR queue scheduler
+            // Add the traffic class to the weighted queue scheduler
             // This is done to set up the queue scheduler with the traffic classes
-            drr->RegisterQueue(trafficClass);
+            scheduler->RegisterQueue(trafficClass);
+        }
+    }
+
+    /**
+     * \brief Maps a configured tree node type to the HierarchicalScheduler enum.
+     */
+    static HierarchicalScheduler::NodeType GetSchedulerNodeType(const std::string& type)
+    {
+        if (type == "DRR") {
+            return HierarchicalScheduler::NODE_DRR;
+        } else if (type == "WFQ") {
+            return HierarchicalScheduler::NODE_WFQ;
+        }
+
+        return HierarchicalScheduler::NODE_SPQ;
+    }
+
+    /**
+     * \brief Initializes the hierarchical queue scheduler.
+     * This function builds one traffic class per queue, then adds the configured tree.
+     */
+    void Simulation::InitializeHierarchical()
+    {
+        // Create the scheduler with the root discipline of the tree
+        hierarchical = CreateObject<HierarchicalScheduler>(GetSchedulerNodeType(qosConfig.tree.type));
+
+        // Apply the optional aggregate byte limit through the MaxSize attribute
+        if (qosConfig.totalMaxBytes > 0) {
+            hierarchical->SetMaxSize(QueueSize(QueueSizeUnit::BYTES, qosConfig.totalMaxBytes));
+        }
+
+        // Let all queues draw from one pool with dynamic thresholds
+        if (qosConfig.sharedBufferPackets > 0) {
+            hierarchical->SetSharedBuffer(QueueSize(QueueSizeUnit::PACKETS, qosConfig.sharedBufferPackets));
+        }
+
+        // Size the classifier's flow cache and pick its rule lookup
+        hierarchical->SetFlowCacheSize(qosConfig.flowCacheSize);
+        hierarchical->SetClassifierMode(GetClassifierMode());
+
+        // Build the traffic classes; priority and weight come from their leaves
+        std::vector<TrafficClass*> trafficClasses;
+        for (uint32_t i = 0; i < qosConfig.queueCount; ++i) {
+            Filter* filter = new Filter();
+            filter->AddFilterElement(new DestinationPortNumber(qosConfig.destinationPorts[i]));
+
+            TrafficClass* trafficClass = new TrafficClass();
+            trafficClass->SetMaxPackets(qosConfig.maxPackets[i]);
+            trafficClass->SetIsDefault(qosConfig.defaults[i]);
+            trafficClass->SetAlpha(qosConfig.alphas[i]);
+            InitializeShaper(trafficClass, i);
+            InitializeFlowQueue(trafficClass, i);
+
+            // Apply the optional byte budget
+            if (qosConfig.maxBytes[i] > 0) {
+                trafficClass->SetMaxBytes(qosConfig.maxBytes[i]);
+            }
+
+            trafficClass->AddFilter(filter);
+            trafficClasses.push_back(trafficClass);
+        }
+
+        // Add the children of the root, depth first
+        for (const auto& child : qosConfig.tree.children) {
+            AddSchedulerNode(child, HierarchicalScheduler::ROOT, trafficClasses);
+        }
+    }
+
+    /**
+     * \brief Adds a configured tree node (and its subtree) under a scheduler node.
+     * \param node The configured node.
+     * \param parent The scheduler node to add it under.
+     * \param trafficClasses The traffic classes, indexed like the Queues list.
+     */
+    void Simulation::AddSchedulerNode(const SchedulerNodeConfig& node, uint32_t parent, const std::vector<TrafficClass*>& trafficClasses)
+    {
+        if (node.type.empty()) {
+            // Leaves are checked against the queue numbers in parseConfigs
+            uint32_t i = std::find(qosConfig.queueNumbers.begin(), qosConfig.queueNumbers.end(), node.queue) - qosConfig.queueNumbers.begin();
+
+            trafficClasses[i]->SetPriorityLevel(node.priority);
+            trafficClasses[i]->SetWeight(node.weight);
+            hierarchical->RegisterQueue(trafficClasses[i], parent);
+            return;
+        }
+
+        uint32_t id = hierarchical->AddNode(parent, GetSchedulerNodeType(node.type), node.priority, node.weight);
+        for (const auto& child : node.children) {
+            AddSchedulerNode(child, id, trafficClasses);
         }
     }
 
@@ -189,17 +743,43 @@ namespace ns3 {
     void Simulation::InitializeQosScheduler()
     {
         // Check the QoS type and initialize the corresponding queue scheduler
-        if (qosConfig.qosType == "DRR") {
-            // Initialize the DRR queue scheduler
-            InitializeDrr();
+        if (qosConfig.qosType == "DRR" || qosConfig.qosType == "WF2Q" || qosConfig.qosType == "STFQ") {
+            // Initialize the DRR, WF2Q+ or SFQ queue scheduler
+            InitializeWeighted();
         }
         else if (qosConfig.qosType == "SPQ") {
             // Initialize the SPQ queue scheduler
             InitializeSpq();
         }
+        else if (qosConfig.qosType == "Hierarchical") {
+            // Initialize the hierarchical queue scheduler
+            InitializeHierarchical();
+        }
+        else if (qosConfig.qosType == "PIFO") {
+            // Initialize the PIFO queue scheduler
+            InitializePifo();
+        }
+        else if (qosConfig.qosType == "EDF") {
+            // Initialize the EDF queue scheduler
+            InitializeEdf();
+        }
+        else if (qosConfig.qosType == "PIAS") {
+            // Initialize the PIAS queue scheduler
+            InitializePias();
+        }
         else
             // If the QoS type is not recognized, print an error message
             NS_FATAL_ERROR("Unknown QoS type: " << qosConfig.qosType);
+
+        // Gate the queues with the optional gate control list
+        if (!qosConfig.gateDurations.empty()) {
+            gateControlList.SetBaseTime(Seconds(qosConfig.gateBaseTime / 1000.0));
+            gateControlList.SetGuardBand(GetGuardBand());
+            for (uint32_t k = 0; k < qosConfig.gateDurations.size(); ++k) {
+                gateControlList.AddEntry(Seconds(qosConfig.gateDurations[k] / 1000.0), qosConfig.gateStates[k]);
+            }
+            GetScheduler()->SetGateControlList(&gateControlList);
+        }
     }
 
     /**
@@ -211,6 +791,20 @@ namespace ns3 {
         // Create an instance of the SPQ class
         spq = CreateObject<SPQ>();
 
+        // Apply the optional aggregate byte limit through the MaxSize attribute
+        if (qosConfig.totalMaxBytes > 0) {
+            spq->SetMaxSize(QueueSize(QueueSizeUnit::BYTES, qosConfig.totalMaxBytes));
+        }
+
+        // Let all queues draw from one pool with dynamic thresholds
+        if (qosConfig.sharedBufferPackets > 0) {
+            spq->SetSharedBuffer(QueueSize(QueueSizeUnit::PACKETS, qosConfig.sharedBufferPackets));
+        }
+
+        // Size the classifier's flow cache and pick its rule lookup
+        spq->SetFlowCacheSize(qosConfig.flowCacheSize);
+        spq->SetClassifierMode(GetClassifierMode());
+
         // Set the queue filters and traffic class values
         for (int i = 0; i < qosConfig.queueCount; ++i) {
             DestinationPortNumber* destinationPortFilterElement = new DestinationPortNumber(qosConfig.destinationPorts[i]);
@@ -227,6 +821,14 @@ namespace ns3 {
             trafficClass->SetMaxPackets(qosConfig.maxPackets[i]);
             trafficClass->SetPriorityLevel(qosConfig.priorities[i]);
             trafficClass->SetIsDefault(qosConfig.defaults[i]);
+            trafficClass->SetAlpha(qosConfig.alphas[i]);
+            InitializeShaper(trafficClass, i);
+            InitializeFlowQueue(trafficClass, i);
+
+            // Apply the optional byte budget
+            if (qosConfig.maxBytes[i] > 0) {
+                trafficClass->SetMaxBytes(qosConfig.maxBytes[i]);
+            }
 
             // Add the filter to the traffic class
             trafficClass->AddFilter(filter);
@@ -237,33 +839,233 @@ namespace ns3 {
         }
     }
 
+    /**
+     * \brief Initializes the PIFO queue scheduler.
+     * This function creates an instance of the PIFO class with the configured rank function and
+     * gives every traffic class the priority, weight and delay budget the rank functions read.
+     */
+    void Simulation::InitializePifo()
+    {
+        // Map the configured rank function name to the PIFO policy
+        PIFO::RankPolicy policy = PIFO::RANK_PRIORITY;
+        if (qosConfig.pifoRank == "Fair") {
+            policy = PIFO::RANK_FAIR;
+        } else if (qosConfig.pifoRank == "Deadline") {
+            policy = PIFO::RANK_DEADLINE;
+        } else if (qosConfig.pifoRank == "Slack") {
+            policy = PIFO::RANK_SLACK;
+        }
+
+        pifo = CreateObject<PIFO>(policy);
+        pifo->SetLinkRate(BOTTLENECK_RATE);
+
+        // Apply the optional aggregate byte limit through the MaxSize attribute
+        if (qosConfig.totalMaxBytes > 0) {
+            pifo->SetMaxSize(QueueSize(QueueSizeUnit::BYTES, qosConfig.totalMaxBytes));
+        }
+
+        // Let all queues draw from one pool with dynamic thresholds
+        if (qosConfig.sharedBufferPackets > 0) {
+            pifo->SetSharedBuffer(QueueSize(QueueSizeUnit::PACKETS, qosConfig.sharedBufferPackets));
+        }
+
+        // Size the classifier's flow cache and pick its rule lookup
+        pifo->SetFlowCacheSize(qosConfig.flowCacheSize);
+        pifo->SetClassifierMode(GetClassifierMode());
+
+        // Set the queue filters and traffic class values
+        for (uint32_t i = 0; i < qosConfig.queueCount; ++i) {
+            Filter* filter = new Filter();
+            filter->AddFilterElement(new DestinationPortNumber(qosConfig.destinationPorts[i]));
+
+            TrafficClass* trafficClass = new TrafficClass();
+            trafficClass->SetMaxPackets(qosConfig.maxPackets[i]);
+            trafficClass->SetPriorityLevel(qosConfig.priorities[i]);
+            trafficClass->SetWeight(qosConfig.weights[i]);
+            trafficClass->SetDelayBudget(Seconds(qosConfig.delayBudgets[i] / 1000.0));
+            trafficClass->SetIsDefault(qosConfig.defaults[i]);
+            trafficClass->SetAlpha(qosConfig.alphas[i]);
+            InitializeShaper(trafficClass, i);
+            InitializeFlowQueue(trafficClass, i);
+
+            // Apply the optional byte budget
+            if (qosConfig.maxBytes[i] > 0) {
+                trafficClass->SetMaxBytes(qosConfig.maxBytes[i]);
+            }
+
+            trafficClass->AddFilter(filter);
+            pifo->RegisterQueue(trafficClass);
+        }
+    }
+
+    /**
+     * \brief Initializes the EDF queue scheduler.
+     * This function creates an instance of the EDF class and gives every traffic class its delay budget.
+     */
+    void Simulation::InitializeEdf()
+    {
+        // Create an instance of the EDF class
+        edf = CreateObject<EDF>();
+
+        // Apply the optional aggregate byte limit through the MaxSize attribute
+        if (qosConfig.totalMaxBytes > 0) {
+            edf->SetMaxSize(QueueSize(QueueSizeUnit::BYTES, qosConfig.totalMaxBytes));
+        }
+
+        // Let all queues draw from one pool with dynamic thresholds
+        if (qosConfig.sharedBufferPackets > 0) {
+            edf->SetSharedBuffer(QueueSize(QueueSizeUnit::PACKETS, qosConfig.sharedBufferPackets));
+        }
+
+        // Size the classifier's flow cache and pick its rule lookup
+        edf->SetFlowCacheSize(qosConfig.flowCacheSize);
+        edf->SetClassifierMode(GetClassifierMode());
+
+        // Set the queue filters and traffic class values
+        for (uint32_t i = 0; i < qosConfig.queueCount; ++i) {
+            Filter* filter = new Filter();
+            filter->AddFilterElement(new DestinationPortNumber(qosConfig.destinationPorts[i]));
+
+            TrafficClass* trafficClass = new TrafficClass();
+            trafficClass->SetMaxPackets(qosConfig.maxPackets[i]);
+            trafficClass->SetDelayBudget(Seconds(qosConfig.delayBudgets[i] / 1000.0));
+            trafficClass->SetIsDefault(qosConfig.defaults[i]);
+            trafficClass->SetAlpha(qosConfig.alphas[i]);
+            InitializeShaper(trafficClass, i);
+            InitializeFlowQueue(trafficClass, i);
+
+            // Apply the optional byte budget
+            if (qosConfig.maxBytes[i] > 0) {
+                trafficClass->SetMaxBytes(qosConfig.maxBytes[i]);
+            }
+
+            trafficClass->AddFilter(filter);
+            edf->RegisterQueue(trafficClass);
+        }
+    }
+
+    /**
+     * \brief Initializes the PIAS queue scheduler.
+     * This function creates an instance of the PIAS class with the configured thresholds and
+     * registers the queues as its levels, highest first. The queue filters are not used.
+     */
+    void Simulation::InitializePias()
+    {
+        // Create an instance of the PIAS class
+        pias = CreateObject<PIAS>(qosConfig.piasThresholds);
+        pias->SetFlowTableSize(qosConfig.flowTableSize);
+        pias->SetFlowIdleTimeout(Seconds(qosConfig.flowIdleTimeout / 1000.0));
+
+        // Apply the optional aggregate byte limit through the MaxSize attribute
+        if (qosConfig.totalMaxBytes > 0) {
+            pias->SetMaxSize(QueueSize(QueueSizeUnit::BYTES, qosConfig.totalMaxBytes));
+        }
+
+        // Let all levels draw from one pool with dynamic thresholds
+        if (qosConfig.sharedBufferPackets > 0) {
+            pias->SetSharedBuffer(QueueSize(QueueSizeUnit::PACKETS, qosConfig.sharedBufferPackets));
+        }
+
+        // Set the traffic class values of every level
+        for (uint32_t i = 0; i < qosConfig.queueCount; ++i) {
+            TrafficClass* trafficClass = new TrafficClass();
+            trafficClass->SetMaxPackets(qosConfig.maxPackets[i]);
+            trafficClass->SetAlpha(qosConfig.alphas[i]);
+            InitializeShaper(trafficClass, i);
+            InitializeFlowQueue(trafficClass, i);
+
+            // Apply the optional byte budget
+            if (qosConfig.maxBytes[i] > 0) {
+                trafficClass->SetMaxBytes(qosConfig.maxBytes[i]);
+            }
+
+            pias->RegisterQueue(trafficClass);
+        }
+    }
+
     /**
      * \brief Customizes the topology based on the QoS type.
      * This function sets up the queue scheduler for the second link (router0 to node1).
      */
     void Simulation::InitializeUdpApplication()
     {
-        // Get the point-to-point network device for the second link (router0 to node1)
-        Ptr<PointToPointNetDevice> link1PtpNetworkDevice = router0->GetDevice(1)->GetObject<PointToPointNetDevice>();
+        // Install the scheduler on the second link (router0 to node1)
+        AttachScheduler(GetScheduler());
 
-        // Set the queue scheduler for the second link based on the QoS type
+        // Build the UDP application for the QoS type
         if (qosConfig.qosType == "SPQ") {
-            link1PtpNetworkDevice->SetQueue(spq);
+            InitializeSpqUdpApplication();
+        }
+
+        // DRR, WF2Q+ and SFQ get the same traffic, so they can be compared
+        else if (qosConfig.qosType == "DRR" || qosConfig.qosType == "WF2Q" || qosConfig.qosType == "STFQ") {
+            InitializeDrrUdpApplication();
+        }
+
+        // Priority ranks get the SPQ traffic, every other rank the DRR traffic, for comparison
+        else if (qosConfig.qosType == "PIFO") {
+            if (qosConfig.pifoRank == "Priority") {
+                InitializeSpqUdpApplication();
+            } else {
+                InitializeDrrUdpApplication();
+            }
+        }
+
+        // Every client starts together, so the budgets compete for a saturated link
+        else if (qosConfig.qosType == "EDF") {
+            InitializeDrrUdpApplication();
+        }
 
-            // Build UDP Application for SPQ
+        // The second client starts once the first flow is demoted, so it takes over the top level
+        else if (qosConfig.qosType == "PIAS") {
             InitializeSpqUdpApplication();
         }
-        
-        // Set to DRR if the QoS type is DRR
-        else if (qosConfig.qosType == "DRR") {
-            // Set the queue scheduler for the second link to DRR
-            link1PtpNetworkDevice->SetQueue(drr);
 
-            // Build UDP Application for DRR
+        // Every client starts together, as for DRR, so the tree shares a saturated link
+        else if (qosConfig.qosType == "Hierarchical") {
             InitializeDrrUdpApplication();
         }
     }
 
+    /**
+     * \brief Checks if the configured scheduler may hold packets back.
+     * \returns true if a queue has a token bucket or credit-based shaper, or the config has a
+     * gate control list.
+     */
+    bool Simulation::HoldsPackets() const
+    {
+        for (uint32_t i = 0; i < qosConfig.queueCount; ++i) {
+            if (!qosConfig.shapeRates[i].empty() || !qosConfig.idleSlopes[i].empty()) {
+                return true;
+            }
+        }
+
+        return !qosConfig.gateDurations.empty();
+    }
+
+    /**
+     * \brief Installs the scheduler on the bottleneck device (router0 to node1).
+     * \details A work-conserving scheduler is the device queue itself, as before. A scheduler that
+     * shapes or gates its queues may have nothing to send right after a packet arrives, which an
+     * idle device cannot handle, so it runs in a DiffServQueueDisc above the device instead and the
+     * release of a held queue restarts the queue disc.
+     */
+    void Simulation::AttachScheduler(Ptr<DiffServ> scheduler)
+    {
+        if (!HoldsPackets()) {
+            link1PtpNetworkDevice->SetQueue(scheduler);
+            return;
+        }
+
+        queueDisc = CreateObject<DiffServQueueDisc>();
+        queueDisc->SetScheduler(scheduler);
+
+        // Replace the default queue disc installed with the IP addresses
+        Ptr<TrafficControlLayer> trafficControl = router0->GetObject<TrafficControlLayer>();
+        trafficControl->DeleteRootQueueDiscOnDevice(link1PtpNetworkDevice);
+        trafficControl->SetRootQueueDiscOnDevice(link1PtpNetworkDevice, queueDisc);
+    }
+
     /**
      * \brief Initializes the network topology.
      * Creates nodes, sets up point-to-point links, and assigns IP addresses.
@@ -285,9 +1087,14 @@ namespace ns3 {
         // Set up point-to-point links (per pdf requirements)
         link0Ptp.SetDeviceAttribute("DataRate", StringValue("4Mbps"));
         link0Ptp.SetChannelAttribute("Delay", StringValue("10ms"));
-        link1Ptp.SetDeviceAttribute("DataRate", StringValue("1Mbps"));
+        link1Ptp.SetDeviceAttribute("DataRate", DataRateValue(BOTTLENECK_RATE));
         link1Ptp.SetChannelAttribute("Delay", StringValue("10ms"));
 
+        // A scheduler running in a queue disc leaves the device only the frame behind the one in
+        // flight, so the order is decided by the scheduler (a scheduler installed as the device
+        // queue replaces this one)
+        link1Ptp.SetQueue("ns3::DropTailQueue<Packet>", "MaxSize", QueueSizeValue(QueueSize("1p")));
+
         // Install point-to-point devices
         networkDevice0 = link0Ptp.Install(link0Nodes);
         networkDevice1 = link1Ptp.Install(link1Nodes);
@@ -309,9 +1116,8 @@ namespace ns3 {
         // Set up routing
         Ipv4GlobalRoutingHelper::PopulateRoutingTables();
 
-        // Set up the queue scheduler for the second link (router0 to node1)
-        // This is where we set the queue scheduler for the second link
-        Ptr<PointToPointNetDevice> link1PtpNetworkDevice = router0->GetDevice(1)->GetObject<PointToPointNetDevice>();
+        // Keep the device of the second link (router0 to node1), where the queue scheduler goes
+        link1PtpNetworkDevice = router0->GetDevice(1)->GetObject<PointToPointNetDevice>();
     }
 
     /**
@@ -5,34 +5,134 @@
 #include "ns3/internet-module.h"
 #include "ns3/point-to-point-module.h"
 #include "ns3/applications-module.h"
+#include "ns3/traffic-control-module.h"
 #include "ns3/net-device.h"           
 
 #include "spq.h"
 #include "drr.h"
+#include "wf2q.h"
+#include "stfq.h"
+#include "pifo.h"
+#include "edf.h"
+#include "pias.h"
+#include "hierarchical-scheduler.h"
+#include "diff-serv-queue-disc.h"
 
 namespace ns3 {
 
+    /**
+     * \brief Structure to hold one node of a hierarchical scheduler tree.
+     * Internal nodes have a Type and Children, leaves name a queue.
+     */
+    struct SchedulerNodeConfig {
+        // Node type (SPQ, DRR or WFQ), empty for a leaf
+        std::string type;
+
+        // Leaf only: queue number ("no") in the Queues list
+        uint32_t queue = 0;
+
+        // Rank under an SPQ parent
+        uint32_t priority = 0;
+
+        // Quantum under a DRR parent, share under a WFQ parent
+        uint32_t weight = 0;
+
+        // Child nodes and leaves
+        std::vector<SchedulerNodeConfig> children;
+    };
+
     /**
      * \brief Structure to hold QoS data.
      * This structure is used to parse the configuration file and
      * initialize the QoS mechanism.
      */
     struct QosConfiguration {
-        // QoS type (SPQ or DRR)
+        // QoS type (SPQ, DRR, WF2Q, STFQ, PIFO, EDF, PIAS or Hierarchical)
         std::string qosType;
 
         // Maximum packets for each queue
         std::vector<uint32_t> maxPackets;
 
+        // Optional maximum bytes for each queue (0 = no byte limit)
+        std::vector<uint32_t> maxBytes;
+
+        // Optional aggregate byte limit over all queues (0 = no limit)
+        // Set this to the bandwidth-delay product of the bottleneck link
+        uint32_t totalMaxBytes = 0;
+
+        // Optional shared pool in packets (0 = every queue keeps its own MaxPackets)
+        // When set, each queue is admitted up to Alpha * (free space of the pool)
+        uint32_t sharedBufferPackets = 0;
+
+        // Dynamic threshold multiplier for each queue (only used with a shared pool)
+        std::vector<double> alphas;
+
+        // Number of flows remembered by the classifier (0 disables the flow cache)
+        uint32_t flowCacheSize = DiffServ::DEFAULT_FLOW_CACHE_SIZE;
+
+        // Classifier mode (Indexed, DecisionTree or Linear)
+        std::string classifierMode = "Indexed";
+
+        // Optional shaping rate for each queue ("" = not shaped), e.g. "500Kbps"
+        std::vector<std::string> shapeRates;
+
+        // Shaper bucket size in bytes for each queue (only used with a shaping rate)
+        std::vector<uint32_t> shapeBursts;
+
+        // Optional 802.1Qav idle slope for each queue ("" = no credit-based shaper), e.g. "300Kbps"
+        std::vector<std::string> idleSlopes;
+
+        // Credit-based shaper send slope magnitude for each queue ("" = bottleneck rate - idle slope)
+        std::vector<std::string> sendSlopes;
+
+        // Optional number of per-flow sub-queues (hash buckets) for each queue (0 = single FIFO)
+        std::vector<uint32_t> flowQueues;
+
+        // Bytes a flow sub-queue sends per round (only used with flow sub-queues)
+        std::vector<uint32_t> flowQuanta;
+
+        // Seconds between hash perturbations (only used with flow sub-queues, 0 = never)
+        std::vector<double> flowPerturbations;
+
         // Destination port for each queue
         std::vector<uint32_t> destinationPorts;
 
-        // SPQ specific priority levels
+        // SPQ and PIFO specific priority levels
         std::vector<uint32_t> priorities;
 
-        // DRR specific weights
+        // DRR, WF2Q, STFQ and PIFO specific weights
         std::vector<uint32_t> weights; 
 
+        // PIFO specific rank function (Priority, Fair, Deadline or Slack)
+        std::string pifoRank = "Priority";
+
+        // PIFO and EDF specific queuing delay budget for each queue, in milliseconds
+        std::vector<double> delayBudgets;
+
+        // PIAS specific byte thresholds between the levels (the queues, highest level first)
+        std::vector<uint64_t> piasThresholds;
+
+        // PIAS specific number of flows tracked by the flow table
+        uint32_t flowTableSize = FlowTable::DEFAULT_CAPACITY;
+
+        // PIAS specific idle time after which a flow starts again at the top level, in milliseconds (0 = never)
+        double flowIdleTimeout = 0;
+
+        // Optional gate control list: entry durations in milliseconds, and the queues each entry
+        // opens (bit i for the i-th queue)
+        std::vector<double> gateDurations;
+        std::vector<uint64_t> gateStates;
+
+        // Gate control list base time, and its guard band in milliseconds (negative = a full frame's transmission time)
+        double gateBaseTime = 0;
+        double gateGuardBand = -1;
+
+        // Hierarchical specific scheduler tree
+        SchedulerNodeConfig tree;
+
+        // Queue number ("no") of each queue, used by the tree leaves
+        std::vector<uint32_t> queueNumbers;
+
         // Default queue flags
         // true if the queue is default, false otherwise
         // This is used to determine which queue to use when no other matches
@@ -50,6 +150,12 @@ namespace ns3 {
             // Queue scheduler instances
             Ptr<SPQ> spq;
             Ptr<DRR> drr;
+            Ptr<WF2Q> wf2q;
+            Ptr<STFQ> stfq;
+            Ptr<PIFO> pifo;
+            Ptr<EDF> edf;
+            Ptr<PIAS> pias;
+            Ptr<HierarchicalScheduler> hierarchical;
 
             // Handler for JSON parsing
             bool parseConfigs(const std::string& configFileName);
@@ -63,6 +169,9 @@ namespace ns3 {
             // Set up Qos scheduler (SPQ or )
             void InitializeQosScheduler();
 
+            // Print scheduler statistics (flow cache hits and misses) after the run
+            void PrintStats() const;
+
             // Queue scheduler customization
             // This function sets up the queue scheduler for the second link (router0 to node1)
             void InitializeUdpApplication();
@@ -72,6 +181,9 @@ namespace ns3 {
             static constexpr uint32_t PACKET_SIZE = 1000;
             static const Time PACKET_TRANS_INTERVAL;
 
+            // Rate of the bottleneck link (router0 to node1)
+            static const DataRate BOTTLENECK_RATE;
+
             // Node and topology
             Ptr<Node> node0, router0, node1;
             NodeContainer allNodesContainer;
@@ -96,7 +208,44 @@ namespace ns3 {
 
             // Queue scheduler construction
             void InitializeSpq();
-            void InitializeDrr();
+            void InitializeWeighted();
+            void InitializeHierarchical();
+            void InitializePifo();
+            void InitializeEdf();
+            void InitializePias();
+
+            // Add a configured tree node (and its subtree) under a scheduler node
+            void AddSchedulerNode(const SchedulerNodeConfig& node, uint32_t parent, const std::vector<TrafficClass*>& trafficClasses);
+
+            // Map the configured classifier mode name to the DiffServ enum
+            DiffServ::ClassifierMode GetClassifierMode() const;
+
+            // Attach the optional token bucket or credit-based shaper of a queue
+            void InitializeShaper(TrafficClass* trafficClass, uint32_t i) const;
+
+            // Attach the optional per-flow sub-queues of a queue
+            void InitializeFlowQueue(TrafficClass* trafficClass, uint32_t i) const;
+
+            // Device draining the QoS scheduler (router0 to node1)
+            Ptr<PointToPointNetDevice> link1PtpNetworkDevice;
+
+            // Scheduler built for the configured QoS type
+            Ptr<DiffServ> GetScheduler() const;
+
+            // Guard band of the gate control list
+            Time GetGuardBand() const;
+
+            // Gate control list applied to the scheduler
+            GateControlList gateControlList;
+
+            // Check if a queue is shaped or the queues are gated
+            bool HoldsPackets() const;
+
+            // Install the scheduler on the bottleneck device, through a queue disc if it holds packets
+            void AttachScheduler(Ptr<DiffServ> scheduler);
+
+            // Queue disc running a scheduler that holds packets
+            Ptr<DiffServQueueDisc> queueDisc;
     };
 
 } // namespace ns3
\ No newline at end of file
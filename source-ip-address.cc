@@ -1,6 +1,4 @@
-#include "ns3/ipv4-header.h"
 #include "source-ip-address.h"
-#include "ns3/ppp-header.h"
 #include "ns3/log.h"
 
 NS_LOG_COMPONENT_DEFINE("SourceIPAddress");  
@@ -16,33 +14,33 @@ namespace ns3 {
     /**
      * \ingroup diffserv
      * \brief Match the packet against the source IP address.
-     * \param pkt The packet to check.
+     * \param key The parsed header view of the packet to check.
      * \return true if the packet matches, false otherwise.
      */
     bool
-    SourceIPAddress::Match(Ptr<Packet> pkt) const
+    SourceIPAddress::Match(const FlowKey& key) const
     {
-        // Make a copy of the packet to avoid modifying the original
-        Ptr<Packet> packetCopy = pkt->Copy();
-
-        // Use Headers to remove the PPP header and check the source IP
-        Ipv4Header ipv4Header;
-        PppHeader pppHeader;
-
-        if (!packetCopy->RemoveHeader(pppHeader))
-        {
-            NS_LOG_WARN("Packet does not contain PPP header");
-            return false;
-        }
-
-        // If we can't access the header, return false
-        if (!packetCopy->PeekHeader(ipv4Header))
+        // Packets without an IPv4 header never match
+        if (!key.hasIpv4)
         {
-            NS_LOG_WARN("Packet does not contain IPv4 header");
             return false;
         }
 
         // Check if the source IP address matches
-        return ipv4Header.GetSource() == m_sourceIp;
+        return key.sourceAddress == m_sourceIp;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Describe the element as an exact match on the source address.
+     * \param field Set to FlowField::SOURCE_ADDRESS.
+     * \param value Set to the source address to match.
+     * \returns true
+     */
+    bool SourceIPAddress::GetExactMatch(FlowField& field, uint32_t& value) const
+    {
+        field = FlowField::SOURCE_ADDRESS;
+        value = m_sourceIp.Get();
+        return true;
     }
 } // namespace ns3
\ No newline at end of file
@@ -14,6 +14,8 @@ namespace ns3 {
     {
 
     public:
+        using FilterElement::Match;
+
         /**
          * \brief Constructor.
          * \param sourceIp The source IP address to match.
@@ -22,10 +24,16 @@ namespace ns3 {
 
         /**
          * \brief Match the packet against the source IP address.
-         * \param pkt The packet to check.
+         * \param key The parsed header view of the packet to check.
          * \return true if the packet matches, false otherwise.
          */
-        bool Match(Ptr<Packet> pkt) const override;
+        bool Match(const FlowKey& key) const override;
+
+        /**
+         * \brief Describe the element as an exact match on the source address.
+         * \returns true, so DiffServ can index the element.
+         */
+        bool GetExactMatch(FlowField& field, uint32_t& value) const override;
 
     private:
         Ipv4Address m_sourceIp;
@@ -13,6 +13,8 @@ namespace ns3 {
     class SourceMask : public FilterElement
     {
         public:
+            using FilterElement::Match;
+
             /**
              * \brief Constructor.
              * \param mask The source IP mask to apply.
@@ -27,10 +29,16 @@ namespace ns3 {
 
             /**
              * \brief Match the packet's source IP Address using the provided mask.
-             * \param pkt The packet to inspect.
+             * \param key The parsed header view of the packet to inspect.
              * \returns true if the masked source IP matches, false otherwise.
              */
-            bool Match(Ptr<Packet> pkt) const override;
+            bool Match(const FlowKey& key) const override;
+
+            /**
+             * \brief Describe the element as a source address prefix.
+             * \returns true if the mask is contiguous, so DiffServ can put the element in its prefix trie.
+             */
+            bool GetPrefixMatch(FlowField& field, uint32_t& prefix, uint8_t& length) const override;
 
         private:
             Ipv4Mask m_mask;
@@ -13,6 +13,8 @@ namespace ns3 {
     class SourcePortNumber : public FilterElement
     {
         public:
+            using FilterElement::Match;
+
             /**
              * \brief Constructor.
              * \param sourcePort The source port number to match.
@@ -26,10 +28,16 @@ namespace ns3 {
 
             /**
              * \brief Match the packet against the referenced source port number.
-             * \param pkt The packet to inspect.
+             * \param key The parsed header view of the packet to inspect.
              * \returns true if the source port matches, false otherwise.
              */
-            bool Match(Ptr<Packet> pkt) const override;
+            bool Match(const FlowKey& key) const override;
+
+            /**
+             * \brief Describe the element as an exact match on the source port.
+             * \returns true, so DiffServ can index the element.
+             */
+            bool GetExactMatch(FlowField& field, uint32_t& value) const override;
 
         private:
             uint32_t m_sourcePort;
@@ -1,7 +1,8 @@
 #include "spq.h"
 #include <vector>
 #include <limits>
-#include <optional>
+#include <algorithm>
+#include <numeric>
 #include "ns3/log.h"
 
 /**
@@ -20,81 +21,133 @@ namespace ns3 {
     // This is used to enable or disable logging for the SPQ class
     static const bool SPQ_LOG_ENABLED = false;
 
-    SPQ::SPQ() {}
-
-    /**
-     * \brief Retrieves the list of traffic classes.
-     * \details This function returns the list of traffic classes associated with the DiffServ instance.
-     * Note: This should really be a method in the  parent class DiffServ.
-     */
-    std::vector<TrafficClass*> SPQ::GetQueues() const
-    {
-        return q_class;
-    }
+    SPQ::SPQ() : backlogSummary(0) {}
 
     /**
      * \brief Schedule the next packet from the highest-priority non-empty queue.
      * \returns Ptr<const Packet> The packet at the head of the highest priority non-empty queue.
-     * The trick here is that the best priority is actually the queue with the lowest priority level number.
-     * This is because we are using strict priority scheduling, where lower numbers indicate higher priority.
      */
     Ptr<const Packet>
     SPQ::Schedule() const
     {
-        // Get the list of queues
-        auto const& queues = GetQueues();
+        uint32_t selectedQueue = ScheduleQueue();
 
-        // Check if there are any queues available
-        if (queues.empty())
+        // If no queue was found, return nullptr
+        if (selectedQueue == NO_QUEUE)
         {
-            NS_LOG_UNCOND("SPQ::Schedule: no queues configured");
             return nullptr;
         }
 
-        // Start with the assumption that no queue is available
-        // and the best priority is set to the maximum possible value
-        std::optional<size_t> selectedQueue;
-        int optimalPriority = std::numeric_limits<int>::max();
+        // Return the packet at the head of the selected queue
+        return q_class[selectedQueue]->Peek();
+    }
 
-        // Iterate through the queues to find the one with the ideal priority
-        for (size_t i = 0; i < queues.size(); ++i)
+    /**
+     * \brief Select the highest-priority non-empty queue.
+     * \returns The index of the selected queue, or NO_QUEUE if every queue is empty.
+     * The trick here is that the best priority is actually the queue with the lowest priority level number.
+     * Ranks are ordered by priority level (lowest number first) and then by registration order, so the
+     * lowest set bit of the backlog bitmap is the queue to serve.
+     */
+    uint32_t
+    SPQ::ScheduleQueue() const
+    {
+        // Check if there are any queues available
+        if (q_class.empty())
         {
-            auto trafficClass = queues[i];
-
-            // Check if the queue is not empty and has a higher priority than the current best (or optimal)
-            if (!trafficClass->IsEmpty())
-            {
-                int trafficClassPriority = trafficClass->GetPriorityLevel();
-                
-                // If the current queue has a higher priority (lower number) than the best one found so far
-                if (trafficClassPriority < optimalPriority)
-                {
-                    // Update the optimal priority and index
-                    optimalPriority = trafficClassPriority;
-                    selectedQueue = i;
-                }
-            }
+            NS_LOG_UNCOND("SPQ::Schedule: no queues configured");
+            return NO_QUEUE;
         }
 
-        // If no queue was found, return nullptr
-        if (!selectedQueue.has_value())
+        // If no queue is backlogged, return NO_QUEUE
+        if (backlogSummary == 0)
         {
             NS_LOG_UNCOND("SPQ::Schedule: all queues empty");
-            return nullptr;
+            return NO_QUEUE;
         }
 
-        // Finally, return the packet at the head of the best queue
-        auto pkt = queues[*selectedQueue]->Peek();
+        // The first non-empty word, then the first backlogged rank inside it
+        uint32_t word = __builtin_ctzll(backlogSummary);
+        uint32_t rank = word * 64 + __builtin_ctzll(backlogWords[word]);
+        uint32_t selectedQueue = rankQueue[rank];
 
         // If debug mode is enabled, log the selected queue and its properties
         if (SPQ_LOG_ENABLED)
         {
-            NS_LOG_UNCOND("SPQ::Schedule: selected queue " << *selectedQueue
-                        << " priority=" << optimalPriority
-                        << " packetSize=" << (pkt ? pkt->GetSize() : 0));
+            NS_LOG_UNCOND("SPQ::Schedule: selected queue " << selectedQueue
+                        << " priority=" << q_class[selectedQueue]->GetPriorityLevel());
         }
 
-        // Return the packet at the head of the selected queue
-        return pkt;
+        return selectedQueue;
+    }
+
+    /**
+     * \brief Adds a TrafficClass and recomputes the priority ranks.
+     * \details Ranking happens once per registration (configuration time), so the
+     * per-packet work is only a bit update on enqueue/dequeue and two ctz on schedule.
+     * \param trafficClass TrafficClass to add
+     */
+    void SPQ::RegisterQueue(TrafficClass* trafficClass)
+    {
+        if (q_class.size() >= MAX_QUEUES)
+        {
+            NS_LOG_UNCOND("SPQ::RegisterQueue: at most " << MAX_QUEUES << " queues are supported");
+            return;
+        }
+
+        DiffServ::RegisterQueue(trafficClass);
+
+        // Rank queues by priority level, keeping registration order for equal levels
+        rankQueue.resize(q_class.size());
+        std::iota(rankQueue.begin(), rankQueue.end(), 0);
+        std::stable_sort(rankQueue.begin(), rankQueue.end(), [this](uint32_t a, uint32_t b) {
+            return q_class[a]->GetPriorityLevel() < q_class[b]->GetPriorityLevel();
+        });
+
+        queueRank.resize(q_class.size());
+        for (uint32_t rank = 0; rank < rankQueue.size(); ++rank)
+        {
+            queueRank[rankQueue[rank]] = rank;
+        }
+
+        // Rebuild the bitmap for the new ranks
+        backlogWords.assign((q_class.size() + 63) / 64, 0);
+        backlogSummary = 0;
+        for (uint32_t i = 0; i < q_class.size(); ++i)
+        {
+            SetBacklogged(queueRank[i], IsBacklogged(i));
+        }
+    }
+
+    /**
+     * \brief Keeps the backlog bitmap in sync after an enqueue or removal, or a shaper hold or release.
+     * \param index The queue that changed.
+     */
+    void SPQ::NotifyQueueChanged(uint32_t index)
+    {
+        SetBacklogged(queueRank[index], IsBacklogged(index));
+    }
+
+    /**
+     * \brief Sets or clears the backlog bit of a rank and the summary bit of its word.
+     */
+    void SPQ::SetBacklogged(uint32_t rank, bool backlogged)
+    {
+        uint32_t word = rank / 64;
+        uint64_t bit = uint64_t(1) << (rank % 64);
+
+        if (backlogged)
+        {
+            backlogWords[word] |= bit;
+            backlogSummary |= uint64_t(1) << word;
+        }
+        else
+        {
+            backlogWords[word] &= ~bit;
+            if (backlogWords[word] == 0)
+            {
+                backlogSummary &= ~(uint64_t(1) << word);
+            }
+        }
     }
 } // namespace ns3
\ No newline at end of file
@@ -3,11 +3,17 @@
 
 #include "diff-serv.h"
 #include "ns3/packet.h"
+#include <vector>
 
 namespace ns3 {
     /**
      * \ingroup diffserv
      * \brief SPQ (Strict Priority Queue) implementation of DiffServ scheduler.
+     *
+     * Queues are ranked by (priority level, registration order) when they are registered, and a
+     * two-level bitmap over those ranks tracks which queues are backlogged. The highest-priority
+     * backlogged queue is then found with two count-trailing-zeros instructions, whatever the
+     * number of queues or priority levels.
      */
     class SPQ : public DiffServ
     {
@@ -20,14 +26,45 @@ namespace ns3 {
              * \return A pointer to the next scheduled packet. (Override of the base class method)
              */
             Ptr<const Packet> Schedule() const override;
-        
+
+            /**
+             * \brief Selects the highest-priority non-empty queue.
+             * \return The index of the selected queue, or NO_QUEUE if all queues are empty.
+             */
+            uint32_t ScheduleQueue() const override;
+
+            /**
+             * \brief Add a new TrafficClass to the SPQ and rank it by its priority level.
+             * \param trafficClass pointer to the TrafficClass instance.
+             * \note The priority level is read at registration time.
+             */
+            void RegisterQueue(TrafficClass* trafficClass) override;
+
+            // Maximum number of queues covered by the two-level bitmap
+            static constexpr uint32_t MAX_QUEUES = 64 * 64;
+
+        protected:
+            /**
+             * \brief Set or clear the backlog bit of a queue after an enqueue or removal.
+             * \param index The queue that changed.
+             */
+            void NotifyQueueChanged(uint32_t index) override;
+
         private:
+            // Rank of each queue by (priority level, registration order), and the reverse mapping
+            std::vector<uint32_t> queueRank;
+            std::vector<uint32_t> rankQueue;
+
+            // Bit r of backlogWords[r / 64] is set while the queue of rank r is non-empty.
+            // Bit w of backlogSummary is set while backlogWords[w] is non-zero.
+            std::vector<uint64_t> backlogWords;
+            uint64_t backlogSummary;
+
             /**
-             * \brief Get the list of queues in the DiffServ class.
-             * \returns A vector of pointers to TrafficClass objects.
+             * \brief Set or clear the backlog bit for a rank.
              */
-            std::vector<TrafficClass*> GetQueues() const;
+            void SetBacklogged(uint32_t rank, bool backlogged);
     };
 } // namespace ns3
 
-#endif // SPQ_H
\ No newline at end of file
+#endif // SPQ_H
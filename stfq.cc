@@ -0,0 +1,144 @@
+#include "stfq.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include <algorithm>
+
+/**
+ * SFQ Algorithm Reference:
+ *
+ * Goyal, P., Vin, H. M., & Cheng, H. (1997). Start-time Fair Queueing: A Scheduling Algorithm for
+ * Integrated Services Packet Switching Networks. IEEE/ACM Transactions on Networking, 5(5), 690–704.
+ * https://doi.org/10.1109/90.649569
+ */
+
+namespace ns3 {
+    STFQ::STFQ() : virtualTime(0), maxFinishTag(0), servedQueue(NO_QUEUE) {}
+
+    /**
+     * \ingroup diffserv
+     * \brief Schedules the next packet to be dequeued based on SFQ.
+     * \returns A pointer to the next scheduled packet. If no packet is found, returns nullptr.
+     * \note Does not change the SFQ state, so it can be called any number of times between dequeues.
+     */
+    Ptr<const Packet> STFQ::Schedule() const
+    {
+        uint32_t scheduledQueue = ScheduleQueue();
+
+        // If no queue was found, return nullptr
+        if (scheduledQueue == NO_QUEUE)
+        {
+            return nullptr;
+        }
+
+        // Return the packet from the front of the scheduled queue
+        return q_class[scheduledQueue]->Peek();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Selects the backlogged queue whose head-of-line packet has the smallest start tag.
+     * \returns The index of the scheduled queue, or NO_QUEUE if all queues are empty.
+     */
+    uint32_t STFQ::ScheduleQueue() const
+    {
+        if (backlog.IsEmpty())
+        {
+            return NO_QUEUE;
+        }
+
+        return backlog.Top();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Adds a new TrafficClass to the SFQ scheduler.
+     */
+    void STFQ::RegisterQueue(TrafficClass* trafficClass)
+    {
+        DiffServ::RegisterQueue(trafficClass);
+
+        startTag.push_back(0);
+        finishTag.push_back(0);
+        isActive.push_back(false);
+        backlog.Resize(q_class.size());
+
+        // A class registered with packets already queued is backlogged right away
+        NotifyQueueChanged(q_class.size() - 1);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Charges the packet about to be popped.
+     * \details The packet's start tag becomes the virtual time (the packet is now in service) and
+     * its finish tag is where the next packet of the queue will start. The new head is only known
+     * once the packet is popped, so the queue is tagged again in NotifyQueueChanged().
+     */
+    void STFQ::CommitSchedule(uint32_t index)
+    {
+        virtualTime = startTag[index];
+        finishTag[index] = startTag[index] + q_class[index]->Peek()->GetSize() / GetQueueWeight(index);
+        maxFinishTag = std::max(maxFinishTag, finishTag[index]);
+
+        backlog.Erase(index);
+        servedQueue = index;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Keeps the heap in step with the queues.
+     * \details The queue just served continues at its finish tag. A queue that becomes backlogged
+     * starts at max(v, F), so it is never owed the service it missed while idle. When the last
+     * queue goes idle the busy period is over and v jumps to the largest finish tag served.
+     */
+    void STFQ::NotifyQueueChanged(uint32_t index)
+    {
+        bool backlogged = IsBacklogged(index);
+
+        if (index == servedQueue)
+        {
+            servedQueue = NO_QUEUE;
+            isActive[index] = backlogged;
+            if (backlogged)
+            {
+                startTag[index] = finishTag[index];
+                backlog.Push(index, startTag[index]);
+            }
+        }
+        else if (backlogged && !isActive[index])
+        {
+            isActive[index] = true;
+            startTag[index] = std::max(virtualTime, finishTag[index]);
+            backlog.Push(index, startTag[index]);
+        }
+        else if (!backlogged && isActive[index])
+        {
+            isActive[index] = false;
+            backlog.Erase(index);
+        }
+
+        // End of a busy period
+        if (backlog.IsEmpty() && servedQueue == NO_QUEUE)
+        {
+            virtualTime = maxFinishTag;
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Returns the weight of a queue; a non-positive weight counts as 1.
+     */
+    double STFQ::GetQueueWeight(uint32_t index) const
+    {
+        double weight = q_class[index]->GetWeight();
+        return weight > 0 ? weight : 1.0;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the system virtual time.
+     */
+    double STFQ::GetVirtualTime() const
+    {
+        return virtualTime;
+    }
+} // namespace ns3
@@ -0,0 +1,89 @@
+#ifndef STFQ_H
+#define STFQ_H
+
+#include "diff-serv.h"
+#include "class-heap.h"
+#include <vector>
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Start-time Fair Queuing (SFQ, Goyal et al.) scheduler extending DiffServ
+     *
+     * Every packet gets a start tag S = max(v, F of the previous packet of its class) and a finish
+     * tag F = S + size / weight, and packets are served in increasing start tag order. The system
+     * virtual time v is the start tag of the packet in service, so nothing depends on the link
+     * rate: the fairness guarantee holds on links whose capacity changes over time, where WFQ and
+     * WF2Q+ (which emulate a fixed-rate fluid server) do not.
+     *
+     * Within a backlogged class the next start tag is the previous finish tag, so tags are kept
+     * per class for the head-of-line packet. Backlogged classes sit in a min-heap by start tag,
+     * so a decision is O(1) and every update O(log n). Weights are TrafficClass::GetWeight().
+     * Named STFQ to keep it apart from stochastic fair queuing.
+     */
+    class STFQ : public DiffServ
+    {
+    public:
+        STFQ();
+        ~STFQ() override = default;
+
+        /**
+         * \brief Select the next packet to be dequeued based on SFQ.
+         * \returns Ptr<const Packet> packet at the front of the scheduled queue.
+         */
+        Ptr<const Packet> Schedule() const override;
+
+        /**
+         * \brief Select the backlogged queue with the smallest start tag.
+         * \returns The index of the scheduled queue, or NO_QUEUE if all queues are empty.
+         */
+        uint32_t ScheduleQueue() const override;
+
+        /**
+         * \brief Add a new TrafficClass to the SFQ scheduler.
+         * \param trafficClass pointer to the TrafficClass instance.
+         */
+        void RegisterQueue(TrafficClass* trafficClass) override;
+
+        /**
+         * \brief Getter for the system virtual time.
+         */
+        double GetVirtualTime() const;
+
+    protected:
+        /**
+         * \brief Take the served packet's start tag as the virtual time and compute its finish tag.
+         * \param index The queue returned by ScheduleQueue().
+         */
+        void CommitSchedule(uint32_t index) override;
+
+        /**
+         * \brief Tag a queue that became backlogged (or got a new head) and untag one that went idle.
+         * \param index The queue that changed.
+         */
+        void NotifyQueueChanged(uint32_t index) override;
+
+    private:
+        // Start tag of the head-of-line packet and finish tag of the last packet served, per queue
+        std::vector<double> startTag;
+        std::vector<double> finishTag;
+        std::vector<bool> isActive;
+
+        // Backlogged queues by start tag
+        ClassHeap backlog;
+
+        // Start tag of the packet in service, and the largest finish tag served (v after a busy period)
+        double virtualTime;
+        double maxFinishTag;
+
+        // Queue charged by CommitSchedule whose new head is tagged once it has been popped
+        uint32_t servedQueue;
+
+        /**
+         * \brief Get the weight of a queue (a non-positive weight counts as 1).
+         */
+        double GetQueueWeight(uint32_t index) const;
+    };
+} // namespace ns3
+
+#endif // STFQ_H
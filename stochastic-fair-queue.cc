@@ -0,0 +1,352 @@
+#include "stochastic-fair-queue.h"
+#include "ns3/simulator.h"
+#include <algorithm>
+#include <limits>
+
+/**
+ * SFQ Reference:
+ *
+ * McKenney, P. E. (1990). Stochastic Fairness Queueing. In Proceedings of IEEE INFOCOM '90 (pp. 733–740).
+ * (hashed buckets, periodic perturbation; the Linux sfq qdisc adds the per-turn byte quantum and
+ * drops from the longest bucket)
+ */
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Constructor for StochasticFairQueue.
+     */
+    StochasticFairQueue::StochasticFairQueue(uint32_t buckets, uint32_t quantum, Time perturbation)
+        : m_quantum(std::max(quantum, 1u)), m_perturbation(perturbation), m_nextPerturbation(Simulator::Now() + perturbation),
+          m_buckets(std::max(buckets, 1u)) {}
+
+    /**
+     * \ingroup diffserv
+     * \brief Grows the slot pool; new slots go on the free list.
+     */
+    void StochasticFairQueue::Reserve(uint32_t capacity)
+    {
+        for (uint32_t slot = m_slots.size(); slot < capacity; ++slot)
+        {
+            m_slots.emplace_back();
+            m_slotHash.push_back(0);
+            m_slotNext.push_back(m_freeSlot);
+            m_freeSlot = slot;
+        }
+        m_order.reserve(m_slots.size());
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Queues a packet in its flow's bucket.
+     */
+    void StochasticFairQueue::Push(Ptr<Packet> pkt, const FlowKey& key)
+    {
+        CheckPerturbation();
+
+        // The pool is sized by the class limit up to the preallocation cap; past it the pool doubles
+        if (m_freeSlot == NONE)
+        {
+            uint64_t grown = std::max<uint64_t>(2 * uint64_t(m_slots.size()), 1);
+            Reserve(static_cast<uint32_t>(std::min<uint64_t>(grown, std::numeric_limits<uint32_t>::max())));
+        }
+
+        uint32_t slot = m_freeSlot;
+        m_freeSlot = m_slotNext[slot];
+
+        m_slots[slot] = pkt;
+        m_slotHash[slot] = key.Hash();
+        Link(slot);
+        m_packets++;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Returns the head packet of the bucket holding the turn.
+     */
+    Ptr<Packet> StochasticFairQueue::Peek() const
+    {
+        if (m_activeHead == NONE)
+        {
+            return nullptr;
+        }
+
+        return m_slots[m_buckets[m_activeHead].head];
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Takes the next packet. The bucket pays for it and passes the turn once its credit is used up.
+     */
+    Ptr<Packet> StochasticFairQueue::Pop()
+    {
+        if (m_activeHead == NONE)
+        {
+            return nullptr;
+        }
+
+        uint32_t bucket = m_activeHead;
+        uint32_t following = m_buckets[bucket].next;
+        uint32_t slot = Unlink(bucket);
+        Ptr<Packet> pkt = m_slots[slot];
+
+        m_slots[slot] = nullptr;
+        m_slotNext[slot] = m_freeSlot;
+        m_freeSlot = slot;
+        m_packets--;
+
+        // An emptied bucket already gave up the turn in Unlink()
+        if (m_buckets[bucket].packets > 0)
+        {
+            m_buckets[bucket].deficit -= pkt->GetSize();
+            if (m_buckets[bucket].deficit <= 0)
+            {
+                AdvanceHead(following);
+            }
+        }
+
+        return pkt;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Head-drops the longest bucket unless the arriving flow owns it.
+     * \details Finding the longest bucket walks the backlogged buckets, but only on overflow.
+     */
+    Ptr<Packet> StochasticFairQueue::Evict(const FlowKey& key)
+    {
+        CheckPerturbation();
+
+        if (m_activeHead == NONE)
+        {
+            return nullptr;
+        }
+
+        uint32_t arriving = BucketOf(key.Hash());
+        uint32_t longest = m_activeHead;
+        uint32_t bucket = m_activeHead;
+        do
+        {
+            if (m_buckets[bucket].packets > m_buckets[longest].packets)
+            {
+                longest = bucket;
+            }
+            bucket = m_buckets[bucket].next;
+        } while (bucket != m_activeHead);
+
+        // The arriving flow is (one of) the heaviest, so it pays with its own packet
+        if (m_buckets[arriving].packets >= m_buckets[longest].packets)
+        {
+            return nullptr;
+        }
+
+        // A drop is not service: the bucket keeps its credit, and the turn if it had it
+        uint32_t slot = Unlink(longest);
+        Ptr<Packet> pkt = m_slots[slot];
+
+        m_slots[slot] = nullptr;
+        m_slotNext[slot] = m_freeSlot;
+        m_freeSlot = slot;
+        m_packets--;
+        m_drops++;
+        return pkt;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Rehashes the queued packets with a new seed.
+     * \details Buckets are walked in service order and each bucket in FIFO order, so the packets of
+     * a flow (which all sat in one bucket) keep their order in their new bucket. Credits restart.
+     */
+    void StochasticFairQueue::Perturb()
+    {
+        // A splitmix step gives a reproducible sequence of seeds
+        m_seed = static_cast<uint32_t>((m_seed + 0x9e3779b97f4a7c15ULL) * 0xbf58476d1ce4e5b9ULL >> 32);
+
+        m_order.clear();
+        while (m_activeHead != NONE)
+        {
+            m_order.push_back(Unlink(m_activeHead));
+        }
+
+        for (uint32_t slot : m_order)
+        {
+            Link(slot);
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of buckets.
+     */
+    uint32_t StochasticFairQueue::GetBuckets() const
+    {
+        return m_buckets.size();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the per-turn quantum in bytes.
+     */
+    uint32_t StochasticFairQueue::GetQuantum() const
+    {
+        return m_quantum;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of backlogged buckets.
+     */
+    uint32_t StochasticFairQueue::GetActiveBuckets() const
+    {
+        return m_activeBuckets;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of packets dropped from the longest bucket.
+     */
+    uint64_t StochasticFairQueue::GetDrops() const
+    {
+        return m_drops;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Returns the bucket a flow hashes to under the current seed.
+     */
+    uint32_t StochasticFairQueue::GetBucket(const FlowKey& key) const
+    {
+        return BucketOf(key.Hash());
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Mixes the seed into a stored flow hash and reduces it to a bucket.
+     */
+    uint32_t StochasticFairQueue::BucketOf(uint32_t hash) const
+    {
+        uint64_t h = (static_cast<uint64_t>(hash ^ m_seed) + m_seed) * 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return static_cast<uint32_t>(h % m_buckets.size());
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Appends a slot to its bucket. A bucket that was empty joins the tail of the round.
+     */
+    void StochasticFairQueue::Link(uint32_t slot)
+    {
+        uint32_t index = BucketOf(m_slotHash[slot]);
+        Bucket& bucket = m_buckets[index];
+
+        m_slotNext[slot] = NONE;
+        if (bucket.tail == NONE)
+        {
+            bucket.head = slot;
+        }
+        else
+        {
+            m_slotNext[bucket.tail] = slot;
+        }
+        bucket.tail = slot;
+
+        if (bucket.packets++ > 0)
+        {
+            return;
+        }
+
+        bucket.deficit = 0;
+        m_activeBuckets++;
+        if (m_activeHead == NONE)
+        {
+            bucket.next = index;
+            bucket.prev = index;
+            AdvanceHead(index);
+        }
+        else
+        {
+            uint32_t tail = m_buckets[m_activeHead].prev;
+            m_buckets[tail].next = index;
+            bucket.prev = tail;
+            bucket.next = m_activeHead;
+            m_buckets[m_activeHead].prev = index;
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Takes the first slot out of a bucket. An emptied bucket leaves the round and, if it
+     * held the turn, passes it on.
+     */
+    uint32_t StochasticFairQueue::Unlink(uint32_t index)
+    {
+        Bucket& bucket = m_buckets[index];
+        uint32_t slot = bucket.head;
+
+        bucket.head = m_slotNext[slot];
+        if (bucket.head == NONE)
+        {
+            bucket.tail = NONE;
+        }
+
+        if (--bucket.packets > 0)
+        {
+            return slot;
+        }
+
+        m_activeBuckets--;
+        bucket.deficit = 0;
+        if (bucket.next == index)
+        {
+            m_activeHead = NONE;
+        }
+        else
+        {
+            m_buckets[bucket.prev].next = bucket.next;
+            m_buckets[bucket.next].prev = bucket.prev;
+            if (m_activeHead == index)
+            {
+                AdvanceHead(bucket.next);
+            }
+        }
+
+        return slot;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Gives the turn to the first bucket, from the given one on, whose credit turns positive.
+     * \details Every bucket passed over receives a quantum, so a bucket in debt waits out the turns
+     * it overspent. With a quantum of at least one packet the first bucket takes the turn.
+     */
+    void StochasticFairQueue::AdvanceHead(uint32_t index)
+    {
+        while (true)
+        {
+            m_buckets[index].deficit += m_quantum;
+            if (m_buckets[index].deficit > 0)
+            {
+                m_activeHead = index;
+                return;
+            }
+
+            index = m_buckets[index].next;
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Perturbs the seed once the interval has passed (checked lazily on the data path).
+     */
+    void StochasticFairQueue::CheckPerturbation()
+    {
+        if (m_perturbation.IsZero() || Simulator::Now() < m_nextPerturbation)
+        {
+            return;
+        }
+
+        m_nextPerturbation = Simulator::Now() + m_perturbation;
+        Perturb();
+    }
+} // namespace ns3
@@ -0,0 +1,144 @@
+#ifndef STOCHASTIC_FAIR_QUEUE_H
+#define STOCHASTIC_FAIR_QUEUE_H
+
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "flow-key.h"
+#include <vector>
+#include <cstdint>
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Stochastic fair queuing (McKenney) inside one TrafficClass.
+     *
+     * Flows are hashed on their 5-tuple into a fixed number of buckets and the backlogged buckets
+     * are served round robin, a quantum of bytes per turn (surplus round robin: a bucket keeps the
+     * turn while its credit is positive), so one elephant flow cannot take the whole class's share.
+     * The hash seed is perturbed periodically so flows that collide do not stay together; the
+     * queued packets are rehashed in order, so a flow is never reordered.
+     *
+     * All buckets draw from one pool of packet slots sized by the class's MaxPackets, so memory is
+     * bounded by the class limit and not by the number of flows. When the class is full the
+     * oldest packet of the longest bucket is dropped to make room, unless the arriving packet
+     * belongs to that bucket.
+     */
+    class StochasticFairQueue
+    {
+        public:
+            static constexpr uint32_t DEFAULT_BUCKETS = 128;
+            static constexpr uint32_t DEFAULT_QUANTUM = 1514;
+
+            /**
+             * \brief Constructor.
+             * \param buckets Number of hash buckets.
+             * \param quantum Bytes a bucket may send per turn.
+             * \param perturbation Interval between hash seed changes (zero disables it).
+             */
+            StochasticFairQueue(uint32_t buckets = DEFAULT_BUCKETS, uint32_t quantum = DEFAULT_QUANTUM, Time perturbation = Seconds(10));
+
+            /**
+             * \brief Size the slot pool (never shrinks below the packets queued).
+             */
+            void Reserve(uint32_t capacity);
+
+            /**
+             * \brief Queue a packet in its flow's bucket (the pool must have a free slot).
+             */
+            void Push(Ptr<Packet> pkt, const FlowKey& key);
+
+            /**
+             * \brief Packet the next Pop() returns, or nullptr when empty.
+             */
+            Ptr<Packet> Peek() const;
+
+            /**
+             * \brief Take the next packet in round robin order.
+             */
+            Ptr<Packet> Pop();
+
+            /**
+             * \brief Drop the oldest packet of the longest bucket to make room for a new packet.
+             * \param key The flow of the arriving packet.
+             * \returns The dropped packet, or nullptr if the arriving flow's bucket is the longest
+             * (the arriving packet is the one to drop).
+             */
+            Ptr<Packet> Evict(const FlowKey& key);
+
+            /**
+             * \brief Rehash every queued packet with a new seed.
+             */
+            void Perturb();
+
+            uint32_t GetBuckets() const;
+            uint32_t GetQuantum() const;
+            uint32_t GetActiveBuckets() const;
+            uint64_t GetDrops() const;
+
+            /**
+             * \brief Bucket a flow currently hashes to.
+             */
+            uint32_t GetBucket(const FlowKey& key) const;
+
+        private:
+            static constexpr uint32_t NONE = UINT32_MAX;
+
+            struct Bucket
+            {
+                uint32_t head = NONE;       // first and last slot of the bucket's FIFO
+                uint32_t tail = NONE;
+                uint32_t packets = 0;
+                int64_t deficit = 0;        // byte credit of the current turn
+                uint32_t next = NONE;       // circular list of the backlogged buckets
+                uint32_t prev = NONE;
+            };
+
+            uint32_t m_quantum;
+            Time m_perturbation;
+            Time m_nextPerturbation;
+            uint32_t m_seed = 0;
+
+            std::vector<Bucket> m_buckets;
+            uint32_t m_activeHead = NONE;
+            uint32_t m_activeBuckets = 0;
+
+            // Slot pool shared by all buckets: packet, unperturbed flow hash and FIFO link per slot
+            std::vector<Ptr<Packet>> m_slots;
+            std::vector<uint32_t> m_slotHash;
+            std::vector<uint32_t> m_slotNext;
+            uint32_t m_freeSlot = NONE;
+            uint32_t m_packets = 0;
+
+            // Scratch list used by Perturb() so rehashing does not allocate
+            std::vector<uint32_t> m_order;
+
+            uint64_t m_drops = 0;
+
+            /**
+             * \brief Bucket of a stored flow hash under the current seed.
+             */
+            uint32_t BucketOf(uint32_t hash) const;
+
+            /**
+             * \brief Append a slot to its bucket, activating the bucket if it was empty.
+             */
+            void Link(uint32_t slot);
+
+            /**
+             * \brief Take the first slot out of a bucket, deactivating the bucket if it empties.
+             */
+            uint32_t Unlink(uint32_t bucket);
+
+            /**
+             * \brief Give the turn to the first bucket, from the given one on, whose credit turns positive.
+             */
+            void AdvanceHead(uint32_t bucket);
+
+            /**
+             * \brief Perturb the seed if the interval has passed.
+             */
+            void CheckPerturbation();
+    };
+} // namespace ns3
+
+#endif // STOCHASTIC_FAIR_QUEUE_H
@@ -2,6 +2,7 @@
 #include "ns3/log.h"
 #include "filter.h"
 #include "traffic-class.h"
+#include <algorithm>
 
 namespace ns3 {
     /**
@@ -10,7 +11,10 @@ namespace ns3 {
      *
      * Initializes the traffic class with default values.
      */
-    TrafficClass::TrafficClass(): m_packets(0), m_maxPackets(100), m_weight(0), m_priorityLevel(0), m_isDefault(false) {}
+    TrafficClass::TrafficClass(): m_packets(0), m_maxPackets(100), m_bytes(0), m_maxBytes(std::numeric_limits<uint32_t>::max()), m_weight(0), m_alpha(1.0), m_priorityLevel(0), m_isDefault(false)
+    {
+        ResizeRing(m_maxPackets);
+    }
 
     /**
      * \ingroup diffserv
@@ -28,6 +32,12 @@ namespace ns3 {
     void TrafficClass::SetIsDefault(bool default_queue)
     {
         m_isDefault = default_queue;
+
+        // The owning DiffServ caches which class is the default
+        if (!m_classifierChangedCallback.IsNull())
+        {
+            m_classifierChangedCallback();
+        }
     }
 
     /** 
@@ -36,11 +46,31 @@ namespace ns3 {
      */
     bool TrafficClass::Enqueue(Ptr<Packet> pkt)
     {
-        // Add the packet to the queue if it is not full
-        if (m_packets < m_maxPackets)
+        // Flow sub-queues need the flow of the packet
+        if (m_flowQueue)
         {
-            m_queue.push(pkt);
+            return Enqueue(pkt, FlowKey::Parse(pkt));
+        }
+
+        // Add the packet to the queue if it is not full in packets or in bytes
+        if (m_packets < m_maxPackets && m_bytes <= m_maxBytes && pkt->GetSize() <= m_maxBytes - m_bytes)
+        {
+            // A limit above the preallocated slots is reached by doubling the ring
+            if (m_packets == m_ring.size())
+            {
+                ResizeRing(m_packets + 1);
+            }
+
+            // Write into the slot after the last packet (the ring size is a power of two)
+            m_ring[(m_head + m_packets) & (m_ring.size() - 1)] = pkt;
             m_packets++;
+            m_bytes += pkt->GetSize();
+
+            // Let the owning scheduler know the queue changed
+            if (!m_queueChangedCallback.IsNull())
+            {
+                m_queueChangedCallback(m_index);
+            }
 
             return true;
         }
@@ -48,6 +78,55 @@ namespace ns3 {
         return false;
     }
 
+    /**
+     * \ingroup diffserv
+     * \brief Enqueues a packet whose headers were already parsed.
+     * \details Without flow sub-queues this is the plain FIFO enqueue. With them, a full class
+     * drops the oldest packet of its longest flow bucket until the new packet fits, unless the
+     * new packet's own bucket is the longest, in which case the new packet is refused.
+     */
+    bool TrafficClass::Enqueue(Ptr<Packet> pkt, const FlowKey& key)
+    {
+        if (!m_flowQueue)
+        {
+            return Enqueue(pkt);
+        }
+
+        if (pkt->GetSize() > m_maxBytes || m_maxPackets == 0)
+        {
+            return false;
+        }
+
+        while (m_packets >= m_maxPackets || m_bytes > m_maxBytes - pkt->GetSize())
+        {
+            Ptr<Packet> dropped = m_flowQueue->Evict(key);
+            if (!dropped)
+            {
+                return false;
+            }
+
+            m_packets--;
+            m_bytes -= dropped->GetSize();
+
+            if (!m_dropCallback.IsNull())
+            {
+                m_dropCallback(dropped);
+            }
+        }
+
+        m_flowQueue->Push(pkt, key);
+        m_packets++;
+        m_bytes += pkt->GetSize();
+
+        // Let the owning scheduler know the queue changed
+        if (!m_queueChangedCallback.IsNull())
+        {
+            m_queueChangedCallback(m_index);
+        }
+
+        return true;
+    }
+
     /**
      * \ingroup diffserv
      * \brief Removes a packet from the traffic class.
@@ -57,17 +136,36 @@ namespace ns3 {
     Ptr<Packet> TrafficClass::Remove()
     {
         // Return null pointer on empty queue
-        if (m_queue.empty())
+        if (IsEmpty())
         {
             return nullptr;
         }
 
-        // Remove the packet and update the packet count
-        Ptr<Packet> pkt = m_queue.front();
-        
-        // Pop the packet from the queue and decrement the packet count
-        m_queue.pop();
+        Ptr<Packet> pkt;
+        if (m_flowQueue)
+        {
+            // The flow sub-queues pick the packet round robin
+            pkt = m_flowQueue->Pop();
+        }
+        else
+        {
+            // Take the packet out of its slot so the slot no longer holds a reference
+            pkt = m_ring[m_head];
+            m_ring[m_head] = nullptr;
+
+            // Advance the head
+            m_head = (m_head + 1) & (m_ring.size() - 1);
+        }
+
+        // Decrement the packet count
         m_packets--;
+        m_bytes -= pkt->GetSize();
+
+        // Let the owning scheduler know the queue changed
+        if (!m_queueChangedCallback.IsNull())
+        {
+            m_queueChangedCallback(m_index);
+        }
         
         return pkt;
     }
@@ -100,6 +198,25 @@ namespace ns3 {
         return m_packets == 0;
     }
 
+    /** 
+     * \ingroup diffserv
+     * \brief Getter for the number of queued packets.
+     */
+    uint32_t TrafficClass::GetNPackets() const
+    {
+        return m_packets;
+    }
+
+    /** 
+     * \ingroup diffserv
+     * \brief Getter for the number of queued bytes.
+     * \details Kept up to date on every enqueue and removal, so this is O(1).
+     */
+    uint32_t TrafficClass::GetNBytes() const
+    {
+        return m_bytes;
+    }
+
     /**
      * \ingroup diffserv
      * \brief Getter for maximum number of packets allowed in queue.
@@ -122,12 +239,30 @@ namespace ns3 {
             return nullptr;
         }
 
+        // The flow sub-queues know which bucket holds the turn
+        if (m_flowQueue)
+        {
+            return m_flowQueue->Peek();
+        }
+
         // Else, return the front packet
-        Ptr<Packet> pkt = m_queue.front();
+        Ptr<Packet> pkt = m_ring[m_head];
         
         return pkt;
     }
 
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the owner notification callback
+     * \param callback Invoked after every enqueue or removal.
+     * \param index The index passed back to the callback (the position in the owner's q_class).
+     */
+    void TrafficClass::SetQueueChangedCallback(Callback<void, uint32_t> callback, uint32_t index)
+    {
+        m_queueChangedCallback = callback;
+        m_index = index;
+    }
+
     /**
      * \ingroup diffserv
      * \brief Add a singular filter
@@ -135,6 +270,111 @@ namespace ns3 {
     void TrafficClass::AddFilter(Filter *filter)
     {
         m_filters.push_back(filter);
+
+        // Let the owning DiffServ know its classifier is out of date
+        if (!m_classifierChangedCallback.IsNull())
+        {
+            m_classifierChangedCallback();
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the filters
+     */
+    const std::vector<Filter*>& TrafficClass::GetFilters() const
+    {
+        return m_filters;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the edge conditioner (nullptr removes it)
+     */
+    void TrafficClass::SetConditioner(TrafficConditioner* conditioner)
+    {
+        m_conditioner = conditioner;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the edge conditioner
+     */
+    TrafficConditioner* TrafficClass::GetConditioner() const
+    {
+        return m_conditioner;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the token bucket shaper (nullptr removes it)
+     */
+    void TrafficClass::SetShaper(TrafficShaper* shaper)
+    {
+        m_shaper = shaper;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the token bucket shaper
+     */
+    TrafficShaper* TrafficClass::GetShaper() const
+    {
+        return m_shaper;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the flow sub-queues (nullptr returns to a single FIFO)
+     * \details The sub-queues take their slot pool from MaxPackets, so the FIFO ring is released.
+     */
+    void TrafficClass::SetFlowQueue(StochasticFairQueue* flowQueue)
+    {
+        if (!IsEmpty())
+        {
+            NS_LOG_UNCOND("TrafficClass::SetFlowQueue: the class must be empty.");
+            return;
+        }
+
+        m_flowQueue = flowQueue;
+        if (m_flowQueue)
+        {
+            m_flowQueue->Reserve(std::min(m_maxPackets, MAX_PREALLOCATED_PACKETS));
+            std::vector<Ptr<Packet>>().swap(m_ring);
+        }
+        else
+        {
+            ResizeRing(std::min(m_maxPackets, MAX_PREALLOCATED_PACKETS));
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the flow sub-queues
+     */
+    StochasticFairQueue* TrafficClass::GetFlowQueue() const
+    {
+        return m_flowQueue;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the classifier notification callback
+     * \param callback Invoked after every AddFilter or SetIsDefault.
+     */
+    void TrafficClass::SetClassifierChangedCallback(Callback<void> callback)
+    {
+        m_classifierChangedCallback = callback;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the drop notification callback
+     * \param callback Invoked with every queued packet evicted by the flow sub-queues.
+     */
+    void TrafficClass::SetDropCallback(Callback<void, Ptr<const Packet>> callback)
+    {
+        m_dropCallback = callback;
     }
 
     /** 
@@ -144,6 +384,65 @@ namespace ns3 {
     void TrafficClass::SetMaxPackets(uint32_t max)
     {
         m_maxPackets = max;
+
+        // Size the ring (or the flow sub-queues' slot pool) once here so the data path never
+        // allocates. A huge limit (e.g. UINT32_MAX for "unbounded") only preallocates the cap.
+        uint32_t slots = std::min(max, MAX_PREALLOCATED_PACKETS);
+        if (m_flowQueue)
+        {
+            m_flowQueue->Reserve(slots);
+        }
+        else
+        {
+            ResizeRing(slots);
+        }
+    }
+
+    /** 
+     * \ingroup diffserv
+     * \brief Setter for max number of bytes
+     */
+    void TrafficClass::SetMaxBytes(uint32_t max)
+    {
+        m_maxBytes = max;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for maximum number of bytes allowed in queue.
+     */
+    uint32_t TrafficClass::GetMaxBytes() const
+    {
+        return m_maxBytes;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Resizes the packet ring to the power of two at or above the requested capacity.
+     * \details Packets already queued are kept in order. The ring never shrinks below them.
+     */
+    void TrafficClass::ResizeRing(uint32_t capacity)
+    {
+        uint64_t slots = 1;
+        while (slots < std::max(capacity, m_packets))
+        {
+            slots <<= 1;
+        }
+
+        if (slots == m_ring.size())
+        {
+            return;
+        }
+
+        // Copy the queued packets to the start of the new ring
+        std::vector<Ptr<Packet>> ring(slots);
+        for (uint32_t i = 0; i < m_packets; ++i)
+        {
+            ring[i] = m_ring[(m_head + i) & (m_ring.size() - 1)];
+        }
+
+        m_ring.swap(ring);
+        m_head = 0;
     }
 
     /**
@@ -164,6 +463,24 @@ namespace ns3 {
         return m_weight;
     }
 
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the dynamic threshold multiplier
+     */
+    void TrafficClass::SetAlpha(double alpha)
+    {
+        m_alpha = alpha;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the dynamic threshold multiplier
+     */
+    double TrafficClass::GetAlpha() const
+    {
+        return m_alpha;
+    }
+
     /** 
      * \ingroup diffserv
      * \brief Setter for priority level
@@ -182,11 +499,39 @@ namespace ns3 {
         return m_priorityLevel;
     }
 
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the queuing delay budget
+     */
+    void TrafficClass::SetDelayBudget(Time budget)
+    {
+        m_delayBudget = budget;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the queuing delay budget
+     */
+    Time TrafficClass::GetDelayBudget() const
+    {
+        return m_delayBudget;
+    }
+
     /** 
      * \ingroup diffserv
      * \brief Matches a packet to each Filter in filters vector.
      */
     bool TrafficClass::Match(Ptr<Packet> pkt) const
+    {
+        // Parse the headers once and share them with every filter
+        return Match(FlowKey::Parse(pkt));
+    }
+
+    /** 
+     * \ingroup diffserv
+     * \brief Matches a parsed packet to each Filter in filters vector.
+     */
+    bool TrafficClass::Match(const FlowKey& key) const
     {
         // If not filters, always match
         if (m_filters.empty())
@@ -198,7 +543,7 @@ namespace ns3 {
         for (Filter *filter : m_filters)
         {
             // If the filter matches, return true
-            if (filter->Match(pkt))
+            if (filter->Match(key))
             {
                 return true;
             }
@@ -2,10 +2,16 @@
 #define TRAFFIC_CLASS_H
 
 #include "ns3/packet.h"
-#include <queue>
+#include "ns3/callback.h"
+#include "ns3/nstime.h"
 #include <vector>
 #include <string>
+#include <limits>
 #include "filter.h"
+#include "flow-key.h"
+#include "traffic-conditioner.h"
+#include "traffic-shaper.h"
+#include "stochastic-fair-queue.h"
 
 namespace ns3 {
     /**
@@ -29,10 +35,29 @@ namespace ns3 {
 
             /**
              * Maximum number of packets in the traffic class.
+             * Slots for up to MAX_PREALLOCATED_PACKETS packets are allocated here; a larger
+             * limit is honored by growing the queue on demand.
              */
             void SetMaxPackets(uint32_t num);
             uint32_t GetMaxPackets() const;
 
+            // Packet slots allocated up front by SetMaxPackets (512 KiB of packet pointers)
+            static constexpr uint32_t MAX_PREALLOCATED_PACKETS = 65536;
+
+            /**
+             * Maximum number of bytes in the traffic class.
+             * Defaults to no limit, so only MaxPackets applies unless a byte budget is set.
+             */
+            void SetMaxBytes(uint32_t num);
+            uint32_t GetMaxBytes() const;
+
+            /**
+             * Dynamic threshold multiplier used when the owning DiffServ runs a shared buffer.
+             * The class may queue up to Alpha times the free space of the pool (default 1.0).
+             */
+            void SetAlpha(double alpha);
+            double GetAlpha() const;
+
             /**
              * Weight of the traffic class.
              */
@@ -45,36 +70,119 @@ namespace ns3 {
             void SetPriorityLevel(uint32_t level);
             uint32_t GetPriorityLevel() const;
 
+            /**
+             * Queuing delay budget of the traffic class (zero by default).
+             * Deadline-driven schedulers stamp each packet with its arrival time plus this budget.
+             */
+            void SetDelayBudget(Time budget);
+            Time GetDelayBudget() const;
+
             /** 
              * Filters -
              * Set, Get or Add filters to the traffic class.
              */
             void AddFilter(Filter* filter);
+            const std::vector<Filter*>& GetFilters() const;
+
+            /**
+             * Optional edge conditioner (meter and marker) run by the owning DiffServ
+             * on every packet classified into this class, before it is queued.
+             */
+            void SetConditioner(TrafficConditioner* conditioner);
+            TrafficConditioner* GetConditioner() const;
+
+            /**
+             * Optional shaper (a token bucket, or a CreditBasedShaper). While it has no tokens
+             * or credit for the head-of-line packet, the class is not eligible in the owning scheduler.
+             * Set it before the class is registered.
+             */
+            void SetShaper(TrafficShaper* shaper);
+            TrafficShaper* GetShaper() const;
+
+            /**
+             * Optional per-flow sub-queues. Flows are hashed into buckets served round robin
+             * inside the class, sharing the class's MaxPackets and MaxBytes.
+             * Set it while the class is empty.
+             */
+            void SetFlowQueue(StochasticFairQueue* flowQueue);
+            StochasticFairQueue* GetFlowQueue() const;
 
             /** 
              * Queue Operations - Important!
+             * Enqueue(pkt, key) reuses a parsed header view; with flow sub-queues a full class
+             * may drop a packet of its longest flow to admit the new one.
              */
             Ptr<Packet> Remove();
             bool Enqueue(Ptr<Packet> pkt);
+            bool Enqueue(Ptr<Packet> pkt, const FlowKey& key);
             Ptr<Packet> Dequeue();
             Ptr<Packet> Peek() const;
             bool IsEmpty() const;
+            uint32_t GetNPackets() const;
+            uint32_t GetNBytes() const;
+
+            /**
+             * Owner notification -
+             * The callback is invoked with the given index after every enqueue or removal,
+             * so the owning scheduler can keep its state in sync with the queue.
+             */
+            void SetQueueChangedCallback(Callback<void, uint32_t> callback, uint32_t index);
+
+            /**
+             * The callback is invoked after AddFilter or SetIsDefault, so the owning DiffServ can rebuild
+             * its classifier indexes.
+             */
+            void SetClassifierChangedCallback(Callback<void> callback);
+
+            /**
+             * The callback is invoked with every queued packet the class drops to admit another one
+             * (a flow sub-queue making room for a new flow), so the owner can account for it.
+             */
+            void SetDropCallback(Callback<void, Ptr<const Packet>> callback);
 
             /**
              * Check if the packet matches the filters.
              */
             bool Match(Ptr<Packet> pkt) const;
+            bool Match(const FlowKey& key) const;
 
         private:
             uint32_t m_packets       = 0;
             uint32_t m_maxPackets    = 100;
+            uint32_t m_bytes         = 0;
+            uint32_t m_maxBytes      = std::numeric_limits<uint32_t>::max();
             double   m_weight        = 0.0;
+            double   m_alpha         = 1.0;
             uint32_t m_priorityLevel = 0;
+            Time     m_delayBudget;
             bool     m_isDefault     = false;
 
             // Queue and Filters most important
-            std::queue<Ptr<Packet>> m_queue;
+            // The queue is a preallocated ring of packet slots whose size is the power of two
+            // at or above m_maxPackets (capped at MAX_PREALLOCATED_PACKETS), so enqueue and
+            // dequeue never allocate below the cap; past it the ring doubles when full.
+            // m_packets is the number of occupied slots starting at m_head.
+            std::vector<Ptr<Packet>> m_ring;
+            uint32_t m_head          = 0;
             std::vector<Filter*> m_filters;
+            TrafficConditioner* m_conditioner = nullptr;
+            TrafficShaper* m_shaper = nullptr;
+            StochasticFairQueue* m_flowQueue = nullptr;
+
+            /**
+             * Resize the ring to hold at least the given number of packets (keeps queued packets in order).
+             */
+            void ResizeRing(uint32_t capacity);
+
+            // Owner notification on enqueue or removal
+            Callback<void, uint32_t> m_queueChangedCallback;
+            uint32_t m_index         = 0;
+
+            // Owner notification on AddFilter or SetIsDefault
+            Callback<void> m_classifierChangedCallback;
+
+            // Owner notification for queued packets dropped by the flow sub-queues
+            Callback<void, Ptr<const Packet>> m_dropCallback;
     };
 } // namespace ns3
 
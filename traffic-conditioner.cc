@@ -0,0 +1,219 @@
+#include "traffic-conditioner.h"
+#include "ns3/simulator.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ppp-header.h"
+#include "ns3/node.h"
+#include "ns3/log.h"
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE("TrafficConditioner");
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Constructor for TrafficConditioner.
+     */
+    TrafficConditioner::TrafficConditioner()
+    {
+        m_actions.fill(ACTION_TRANSMIT);
+        m_remarks.fill(0);
+        m_packets.fill(0);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Configures the srTCM meter. Both buckets start full.
+     */
+    void TrafficConditioner::SetSingleRate(DataRate cir, uint32_t cbs, uint32_t ebs)
+    {
+        m_mode = METER_SINGLE_RATE;
+        m_committedRate = cir.GetBitRate() / 8.0;
+        m_peakRate = 0;
+        m_committedSize = cbs;
+        m_excessSize = ebs;
+        m_committedTokens = cbs;
+        m_excessTokens = ebs;
+        m_lastUpdate = Simulator::Now();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Configures the trTCM meter. Both buckets start full.
+     */
+    void TrafficConditioner::SetTwoRate(DataRate cir, uint32_t cbs, DataRate pir, uint32_t pbs)
+    {
+        m_mode = METER_TWO_RATE;
+        m_committedRate = cir.GetBitRate() / 8.0;
+        m_peakRate = pir.GetBitRate() / 8.0;
+        m_committedSize = cbs;
+        m_excessSize = pbs;
+        m_committedTokens = cbs;
+        m_excessTokens = pbs;
+        m_lastUpdate = Simulator::Now();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Setter for the action of a color.
+     */
+    void TrafficConditioner::SetAction(Color color, Action action, uint8_t dscp)
+    {
+        m_actions[color] = action;
+        m_remarks[color] = dscp;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Adds the tokens earned since the last packet, capped at the bucket sizes.
+     * \details srTCM tokens beyond the committed bucket spill into the excess bucket (RFC 2697 §3);
+     * trTCM fills the two buckets independently (RFC 2698 §3).
+     */
+    void TrafficConditioner::Refill(Time now)
+    {
+        if (now <= m_lastUpdate)
+        {
+            return;
+        }
+
+        double elapsed = (now - m_lastUpdate).GetSeconds();
+        m_lastUpdate = now;
+
+        if (m_mode == METER_SINGLE_RATE)
+        {
+            double tokens = m_committedTokens + elapsed * m_committedRate;
+            m_committedTokens = std::min(tokens, m_committedSize);
+            m_excessTokens = std::min(m_excessTokens + (tokens - m_committedTokens), m_excessSize);
+        }
+        else
+        {
+            m_committedTokens = std::min(m_committedTokens + elapsed * m_committedRate, m_committedSize);
+            m_excessTokens = std::min(m_excessTokens + elapsed * m_peakRate, m_excessSize);
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Meters a packet in color-blind mode.
+     * \details srTCM: green if the committed bucket holds the packet, else yellow if the excess
+     * bucket does, else red. trTCM: red if the peak bucket cannot hold the packet, else yellow if
+     * the committed bucket cannot, else green. Only the buckets the color was paid from are charged.
+     */
+    TrafficConditioner::Color TrafficConditioner::Meter(uint32_t size, Time now)
+    {
+        if (m_mode == METER_NONE)
+        {
+            return GREEN;
+        }
+
+        Refill(now);
+
+        if (m_mode == METER_SINGLE_RATE)
+        {
+            if (m_committedTokens >= size)
+            {
+                m_committedTokens -= size;
+                return GREEN;
+            }
+            if (m_excessTokens >= size)
+            {
+                m_excessTokens -= size;
+                return YELLOW;
+            }
+            return RED;
+        }
+
+        // Two-rate: the peak bucket is checked first
+        if (m_excessTokens < size)
+        {
+            return RED;
+        }
+        if (m_committedTokens < size)
+        {
+            m_excessTokens -= size;
+            return YELLOW;
+        }
+        m_excessTokens -= size;
+        m_committedTokens -= size;
+        return GREEN;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Meters a packet and applies the action of its color.
+     * \details The size metered is the packet as it sits in the queue (FlowKey::length).
+     * A remark to the codepoint the packet already carries leaves the headers untouched.
+     */
+    bool TrafficConditioner::Condition(Ptr<Packet> pkt, FlowKey& key)
+    {
+        Color color = Meter(key.length, Simulator::Now());
+        m_packets[color]++;
+
+        switch (m_actions[color])
+        {
+            case ACTION_DROP:
+                m_drops++;
+                return false;
+
+            case ACTION_REMARK:
+                if (key.hasIpv4 && key.dscp != m_remarks[color] && Remark(pkt, m_remarks[color]))
+                {
+                    key.dscp = m_remarks[color];
+                }
+                return true;
+
+            default:
+                return true;
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Rewrites the DSCP of a PPP/IPv4 packet in place.
+     * \details The PPP and IPv4 headers are stripped from the packet itself, the DSCP bits of the
+     * ToS field are replaced (ECN bits kept) and the headers are added back, so only the header
+     * bytes are rewritten. The IPv4 checksum is recomputed when checksums are enabled.
+     */
+    bool TrafficConditioner::Remark(Ptr<Packet> pkt, uint8_t dscp)
+    {
+        PppHeader pppHeader;
+        if (!pkt->RemoveHeader(pppHeader))
+        {
+            return false;
+        }
+
+        Ipv4Header ipv4Header;
+        if (!pkt->RemoveHeader(ipv4Header))
+        {
+            pkt->AddHeader(pppHeader);
+            return false;
+        }
+
+        ipv4Header.SetDscp(static_cast<Ipv4Header::DscpType>(dscp));
+        if (Node::ChecksumEnabled())
+        {
+            ipv4Header.EnableChecksum();
+        }
+
+        pkt->AddHeader(ipv4Header);
+        pkt->AddHeader(pppHeader);
+        return true;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of packets metered as a color.
+     */
+    uint64_t TrafficConditioner::GetPackets(Color color) const
+    {
+        return m_packets[color];
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of packets dropped by the conditioner.
+     */
+    uint64_t TrafficConditioner::GetDrops() const
+    {
+        return m_drops;
+    }
+} // namespace ns3
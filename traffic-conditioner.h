@@ -0,0 +1,134 @@
+#ifndef TRAFFIC_CONDITIONER_H
+#define TRAFFIC_CONDITIONER_H
+
+#include <array>
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "flow-key.h"
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Edge traffic conditioner: a three-color meter followed by a marker.
+     *
+     * The meter is either the single-rate three-color marker of RFC 2697 (srTCM: CIR, CBS, EBS)
+     * or the two-rate three-color marker of RFC 2698 (trTCM: CIR, CBS, PIR, PBS), both color-blind.
+     * Each color then has an action: transmit unchanged, remark the DSCP in the IPv4 header,
+     * or drop. DiffServ runs the conditioner of the class a packet was classified into, between
+     * Classify and TrafficClass::Enqueue.
+     *
+     * Token buckets are refilled lazily from the time elapsed since the last packet, so metering
+     * is O(1) and needs no timer events. The remark rewrites the headers of the packet in place;
+     * the packet itself is never copied.
+     */
+    class TrafficConditioner
+    {
+        public:
+            enum Color
+            {
+                GREEN,
+                YELLOW,
+                RED
+            };
+
+            enum Action
+            {
+                ACTION_TRANSMIT,
+                ACTION_REMARK,
+                ACTION_DROP
+            };
+
+            /**
+             * \brief Constructor. Until a meter is configured every packet is green and transmitted.
+             */
+            TrafficConditioner();
+
+            /**
+             * \brief Meter with the single-rate three-color marker (RFC 2697).
+             * \param cir Committed information rate.
+             * \param cbs Committed burst size in bytes.
+             * \param ebs Excess burst size in bytes (tokens that overflow the committed bucket).
+             */
+            void SetSingleRate(DataRate cir, uint32_t cbs, uint32_t ebs);
+
+            /**
+             * \brief Meter with the two-rate three-color marker (RFC 2698).
+             * \param cir Committed information rate.
+             * \param cbs Committed burst size in bytes.
+             * \param pir Peak information rate (at least the CIR).
+             * \param pbs Peak burst size in bytes.
+             */
+            void SetTwoRate(DataRate cir, uint32_t cbs, DataRate pir, uint32_t pbs);
+
+            /**
+             * \brief Set what happens to packets of a color (default: transmit unchanged).
+             * \param dscp The new codepoint, only used by ACTION_REMARK.
+             */
+            void SetAction(Color color, Action action, uint8_t dscp = 0);
+
+            /**
+             * \brief Meter a packet and apply the action of its color.
+             * \param pkt The packet. Its DSCP is rewritten in place when remarked.
+             * \param key The parsed header view of the packet; its dscp follows the remark.
+             * \returns false if the packet must be dropped.
+             */
+            bool Condition(Ptr<Packet> pkt, FlowKey& key);
+
+            /**
+             * \brief Meter a packet of the given size, taking tokens from the buckets.
+             * \param now The arrival time (Condition passes Simulator::Now()).
+             * \returns The color of the packet.
+             */
+            Color Meter(uint32_t size, Time now);
+
+            /**
+             * \brief Rewrite the DSCP of a PPP/IPv4 packet in place.
+             * \returns false (leaving the packet unchanged) if the headers cannot be read.
+             */
+            static bool Remark(Ptr<Packet> pkt, uint8_t dscp);
+
+            /**
+             * \brief Number of packets metered as each color, and of packets dropped.
+             */
+            uint64_t GetPackets(Color color) const;
+            uint64_t GetDrops() const;
+
+        private:
+            enum MeterMode
+            {
+                METER_NONE,
+                METER_SINGLE_RATE,
+                METER_TWO_RATE
+            };
+
+            MeterMode m_mode = METER_NONE;
+
+            // Bucket rates in bytes per second and sizes in bytes.
+            // srTCM: the committed bucket fills at the CIR and overflows into the excess bucket.
+            // trTCM: the committed bucket fills at the CIR, the peak bucket at the PIR.
+            double m_committedRate = 0;
+            double m_peakRate = 0;
+            double m_committedSize = 0;
+            double m_excessSize = 0;
+
+            // Current tokens of the committed and the excess (srTCM) or peak (trTCM) bucket
+            double m_committedTokens = 0;
+            double m_excessTokens = 0;
+            Time m_lastUpdate;
+
+            // Action and remark codepoint per color
+            std::array<Action, 3> m_actions;
+            std::array<uint8_t, 3> m_remarks;
+
+            std::array<uint64_t, 3> m_packets;
+            uint64_t m_drops = 0;
+
+            /**
+             * \brief Add the tokens earned since the last packet.
+             */
+            void Refill(Time now);
+    };
+} // namespace ns3
+
+#endif // TRAFFIC_CONDITIONER_H
@@ -0,0 +1,89 @@
+#include "traffic-shaper.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Constructor for TrafficShaper.
+     * \param rate Committed rate the class is served at.
+     * \param burst Bucket size in bytes.
+     */
+    TrafficShaper::TrafficShaper(DataRate rate, uint32_t burst)
+        : m_rate(rate), m_burst(burst), m_bytesPerSecond(rate.GetBitRate() / 8.0), m_tokens(burst) {}
+
+    /**
+     * \ingroup diffserv
+     * \brief Adds the tokens earned since the last update, capped at the burst size.
+     */
+    void TrafficShaper::Refill(Time now)
+    {
+        if (now <= m_lastUpdate)
+        {
+            return;
+        }
+
+        m_tokens = std::min(m_tokens + (now - m_lastUpdate).GetSeconds() * m_bytesPerSecond, double(m_burst));
+        m_lastUpdate = now;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Computes when the bucket will hold a packet of the given size.
+     * \details Packets larger than the burst need a full bucket, otherwise they could never be sent.
+     * The time is rounded up to the next nanosecond so the release never comes early.
+     */
+    Time TrafficShaper::GetEligibleTime(uint32_t size, Time now)
+    {
+        Refill(now);
+
+        double needed = std::min(double(size), double(m_burst));
+        if (m_tokens >= needed)
+        {
+            return now;
+        }
+
+        // A zero rate never earns tokens
+        if (m_bytesPerSecond <= 0)
+        {
+            return Time::Max();
+        }
+
+        double seconds = (needed - m_tokens) / m_bytesPerSecond;
+        return now + NanoSeconds(static_cast<int64_t>(std::ceil(seconds * 1e9)));
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Takes a served packet out of the bucket.
+     */
+    void TrafficShaper::Consume(uint32_t size, Time now)
+    {
+        Refill(now);
+        m_tokens -= size;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief The token bucket does not depend on the backlog of the class.
+     */
+    void TrafficShaper::NotifyBacklog(bool, Time) {}
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the committed rate.
+     */
+    DataRate TrafficShaper::GetRate() const
+    {
+        return m_rate;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the bucket size.
+     */
+    uint32_t TrafficShaper::GetBurst() const
+    {
+        return m_burst;
+    }
+} // namespace ns3
@@ -0,0 +1,68 @@
+#ifndef TRAFFIC_SHAPER_H
+#define TRAFFIC_SHAPER_H
+
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Token bucket that caps the rate a TrafficClass is served at.
+     *
+     * The bucket fills at the committed rate up to the burst size. A packet is eligible once the
+     * bucket holds its size (or a full bucket, for packets larger than the burst), and serving it
+     * takes its size out of the bucket. Tokens are refilled lazily from the elapsed time, so the
+     * shaper itself needs no events; DiffServ schedules one release event per held class.
+     * Other shaping disciplines (e.g. the CreditBasedShaper) override the eligibility rules.
+     */
+    class TrafficShaper
+    {
+        public:
+            /**
+             * \brief Constructor. The bucket starts full.
+             * \param rate Committed rate the class is served at.
+             * \param burst Bucket size in bytes.
+             */
+            TrafficShaper(DataRate rate, uint32_t burst);
+            virtual ~TrafficShaper() = default;
+
+            /**
+             * \brief Time at which a packet of the given size becomes eligible.
+             * \param now The current time.
+             * \returns now if the packet conforms already, otherwise the time the bucket will hold it.
+             */
+            virtual Time GetEligibleTime(uint32_t size, Time now);
+
+            /**
+             * \brief Take a served packet out of the bucket.
+             * \details The bucket may go slightly negative when a release event rounds the
+             * eligible time; the debt is paid back by the next refill.
+             */
+            virtual void Consume(uint32_t size, Time now);
+
+            /**
+             * \brief Called whenever the class gains or loses its last packet (and after every
+             * other change of the class). The token bucket earns tokens either way, so it ignores it.
+             */
+            virtual void NotifyBacklog(bool backlogged, Time now);
+
+            DataRate GetRate() const;
+            uint32_t GetBurst() const;
+
+        private:
+            DataRate m_rate;
+            uint32_t m_burst;
+
+            // Rate in bytes per second, current tokens in bytes
+            double m_bytesPerSecond;
+            double m_tokens;
+            Time m_lastUpdate;
+
+            /**
+             * \brief Add the tokens earned since the last update.
+             */
+            void Refill(Time now);
+    };
+} // namespace ns3
+
+#endif // TRAFFIC_SHAPER_H
@@ -0,0 +1,130 @@
+#include "tuple-space.h"
+#include <algorithm>
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Removes every rule.
+     */
+    void TupleSpace::Clear()
+    {
+        m_tuples.clear();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Adds a rule to the tuple of its shape, creating the tuple if needed.
+     */
+    void TupleSpace::Insert(const std::vector<FieldMask>& tests, uint32_t classIndex)
+    {
+        Values masks{};
+        Values values{};
+        bool needsIpv4 = false;
+        bool needsPorts = false;
+
+        for (const FieldMask& test : tests)
+        {
+            uint32_t f = static_cast<uint32_t>(test.field) - 1;
+            masks[f] = test.mask;
+            values[f] = test.value & test.mask;
+
+            // Addresses, protocol and DSCP need an IPv4 header, ports a TCP/UDP header
+            if (test.field == FlowField::SOURCE_PORT || test.field == FlowField::DESTINATION_PORT)
+            {
+                needsPorts = true;
+            }
+            else
+            {
+                needsIpv4 = true;
+            }
+        }
+
+        auto tuple = std::find_if(m_tuples.begin(), m_tuples.end(),
+                                  [&](const Tuple& t) { return t.masks == masks && t.needsIpv4 == needsIpv4 && t.needsPorts == needsPorts; });
+        if (tuple == m_tuples.end())
+        {
+            m_tuples.emplace_back();
+            tuple = m_tuples.end() - 1;
+            tuple->masks = masks;
+            tuple->needsIpv4 = needsIpv4;
+            tuple->needsPorts = needsPorts;
+        }
+
+        // The first registered class wins for the same rule
+        auto inserted = tuple->rules.emplace(values, classIndex);
+        if (!inserted.second)
+        {
+            inserted.first->second = std::min(inserted.first->second, classIndex);
+        }
+
+        if (classIndex < tuple->bestClass)
+        {
+            tuple->bestClass = classIndex;
+
+            // Keep the tuples ordered by the best class they can return
+            std::stable_sort(m_tuples.begin(), m_tuples.end(),
+                             [](const Tuple& a, const Tuple& b) { return a.bestClass < b.bestClass; });
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Probes the tuples in order of their best class until none can beat the current hit.
+     */
+    uint32_t TupleSpace::Lookup(const FlowKey& key, uint32_t bound) const
+    {
+        uint32_t best = bound;
+
+        for (const Tuple& tuple : m_tuples)
+        {
+            if (tuple.bestClass >= best)
+            {
+                break;
+            }
+
+            // Packets that lack a tested field never match the tuple's rules
+            if ((tuple.needsIpv4 && !key.hasIpv4) || (tuple.needsPorts && !key.hasPorts))
+            {
+                continue;
+            }
+
+            Values values;
+            for (uint32_t f = 0; f < FIELDS; ++f)
+            {
+                values[f] = tuple.masks[f] == 0 ? 0 : key.Get(static_cast<FlowField>(f + 1)) & tuple.masks[f];
+            }
+
+            auto hit = tuple.rules.find(values);
+            if (hit != tuple.rules.end() && hit->second < best)
+            {
+                best = hit->second;
+            }
+        }
+
+        return best == bound ? NO_MATCH : best;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the number of distinct rule shapes.
+     */
+    uint32_t TupleSpace::GetTupleCount() const
+    {
+        return m_tuples.size();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Hashes the masked field values of a rule or packet.
+     */
+    size_t TupleSpace::ValuesHash::operator()(const Values& values) const
+    {
+        uint64_t h = 0;
+        for (uint32_t value : values)
+        {
+            h = (h ^ value) * 0x9e3779b97f4a7c15ULL;
+            h ^= h >> 29;
+        }
+        return static_cast<size_t>(h);
+    }
+} // namespace ns3
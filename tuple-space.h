@@ -0,0 +1,88 @@
+#ifndef TUPLE_SPACE_H
+#define TUPLE_SPACE_H
+
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <limits>
+#include "flow-key.h"
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Tuple-space-search classifier for filters that test several header fields.
+     *
+     * Every rule is reduced to a mask per header field (all ones for an exact match, the prefix
+     * mask for a subnet, zero for a field it does not test). Rules with the same masks form a
+     * tuple, and each tuple is one hash table from the masked field values to the lowest class
+     * index. A lookup costs one probe per tuple, so it grows with the number of distinct rule
+     * shapes, not with the number of rules. Tuples are kept in order of the best class they can
+     * return, so the search stops as soon as no remaining tuple can beat the current hit.
+     */
+    class TupleSpace
+    {
+        public:
+            // Returned by Lookup() when no rule matches
+            static constexpr uint32_t NO_MATCH = std::numeric_limits<uint32_t>::max();
+
+            // One field test of a rule: (packet field & mask) == value
+            struct FieldMask
+            {
+                FlowField field;
+                uint32_t value;
+                uint32_t mask;
+            };
+
+            /**
+             * \brief Remove every rule.
+             */
+            void Clear();
+
+            /**
+             * \brief Add a rule that matches when every field test holds.
+             * \param tests At most one test per field.
+             * \param classIndex The index of the traffic class that owns the rule.
+             */
+            void Insert(const std::vector<FieldMask>& tests, uint32_t classIndex);
+
+            /**
+             * \brief Find the lowest class index with a matching rule.
+             * \param key The parsed header view of the packet.
+             * \param bound Only classes below this index are of interest.
+             * \returns The class index, or NO_MATCH if none below the bound matches.
+             */
+            uint32_t Lookup(const FlowKey& key, uint32_t bound = NO_MATCH) const;
+
+            /**
+             * \brief Number of distinct rule shapes.
+             */
+            uint32_t GetTupleCount() const;
+
+        private:
+            // Number of header fields (FlowField without NONE)
+            static constexpr uint32_t FIELDS = 6;
+
+            using Values = std::array<uint32_t, FIELDS>;
+
+            struct ValuesHash
+            {
+                size_t operator()(const Values& values) const;
+            };
+
+            struct Tuple
+            {
+                Values masks;
+                bool needsIpv4 = false;
+                bool needsPorts = false;
+
+                // Lowest class index stored in this tuple
+                uint32_t bestClass = NO_MATCH;
+
+                std::unordered_map<Values, uint32_t, ValuesHash> rules;
+            };
+
+            std::vector<Tuple> m_tuples;
+    };
+} // namespace ns3
+
+#endif // TUPLE_SPACE_H
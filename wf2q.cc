@@ -0,0 +1,187 @@
+#include "wf2q.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include <algorithm>
+
+/**
+ * WF2Q+ Algorithm Reference:
+ *
+ * Bennett, J. C. R., & Zhang, H. (1997). Hierarchical Packet Fair Queueing Algorithms.
+ * IEEE/ACM Transactions on Networking, 5(5), 675–689. https://doi.org/10.1109/90.649568
+ * (WF2Q+: head-of-line start and finish tags, eligibility S <= V, V(t) = max(V + W, min S))
+ *
+ * Bennett, J. C. R., & Zhang, H. (1996). WF2Q: Worst-case Fair Weighted Fair Queueing.
+ * In Proceedings of IEEE INFOCOM '96 (pp. 120–128).
+ */
+
+namespace ns3 {
+    WF2Q::WF2Q() : virtualTime(0), totalWeight(0), servedQueue(NO_QUEUE) {}
+
+    /**
+     * \ingroup diffserv
+     * \brief Schedules the next packet to be dequeued based on WF2Q+.
+     * \returns A pointer to the next scheduled packet. If no packet is found, returns nullptr.
+     * \note Does not change the WF2Q+ state, so it can be called any number of times between dequeues.
+     */
+    Ptr<const Packet> WF2Q::Schedule() const
+    {
+        uint32_t scheduledQueue = ScheduleQueue();
+
+        // If no queue was found, return nullptr
+        if (scheduledQueue == NO_QUEUE)
+        {
+            return nullptr;
+        }
+
+        // Return the packet from the front of the scheduled queue
+        return q_class[scheduledQueue]->Peek();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Selects the eligible queue with the smallest virtual finish time.
+     * \details The virtual time is kept at or above the smallest start time whenever a queue is
+     * backlogged, so some queue is always eligible and the decision is the top of one heap.
+     * \returns The index of the scheduled queue, or NO_QUEUE if all queues are empty.
+     */
+    uint32_t WF2Q::ScheduleQueue() const
+    {
+        if (eligible.IsEmpty())
+        {
+            return NO_QUEUE;
+        }
+
+        return eligible.Top();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Adds a new TrafficClass to the WF2Q+ scheduler.
+     */
+    void WF2Q::RegisterQueue(TrafficClass* trafficClass)
+    {
+        DiffServ::RegisterQueue(trafficClass);
+
+        startTime.push_back(0);
+        finishTime.push_back(0);
+        isActive.push_back(false);
+        eligible.Resize(q_class.size());
+        pending.Resize(q_class.size());
+        totalWeight += GetQueueWeight(q_class.size() - 1);
+
+        // A class registered with packets already queued is backlogged right away
+        NotifyQueueChanged(q_class.size() - 1);
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Charges the packet about to be popped.
+     * \details The virtual time advances by the packet's size over the sum of the weights, and the
+     * queue's next packet starts where this one finishes. The new head is only known once the
+     * packet is popped, so the queue is tagged again in NotifyQueueChanged().
+     */
+    void WF2Q::CommitSchedule(uint32_t index)
+    {
+        virtualTime += q_class[index]->Peek()->GetSize() / totalWeight;
+
+        eligible.Erase(index);
+        startTime[index] = finishTime[index];
+        servedQueue = index;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Keeps the heaps in step with the queues.
+     * \details A queue that becomes backlogged starts at max(F, V); the queue just served keeps the
+     * start time set by CommitSchedule() and is tagged for its new head. A queue that empties (or is
+     * held by its shaper) leaves both heaps but keeps its finish time for when it returns.
+     */
+    void WF2Q::NotifyQueueChanged(uint32_t index)
+    {
+        bool backlogged = IsBacklogged(index);
+
+        if (index == servedQueue)
+        {
+            servedQueue = NO_QUEUE;
+            isActive[index] = backlogged;
+            if (backlogged)
+            {
+                Tag(index);
+            }
+        }
+        else if (backlogged && !isActive[index])
+        {
+            isActive[index] = true;
+            startTime[index] = std::max(finishTime[index], virtualTime);
+            Tag(index);
+        }
+        else if (!backlogged && isActive[index])
+        {
+            isActive[index] = false;
+            eligible.Erase(index);
+            pending.Erase(index);
+        }
+
+        UpdateVirtualTime();
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Computes the finish time of a queue's head-of-line packet and files the queue.
+     */
+    void WF2Q::Tag(uint32_t index)
+    {
+        finishTime[index] = startTime[index] + q_class[index]->Peek()->GetSize() / GetQueueWeight(index);
+
+        if (startTime[index] <= virtualTime)
+        {
+            pending.Erase(index);
+            eligible.Push(index, finishTime[index]);
+        }
+        else
+        {
+            eligible.Erase(index);
+            pending.Push(index, startTime[index]);
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Applies V = max(V, min S) and moves the queues that became eligible.
+     * \details Eligible queues all start at or before V, so the smallest start time only has to be
+     * looked up in the pending heap, and only when nothing is eligible.
+     */
+    void WF2Q::UpdateVirtualTime()
+    {
+        if (eligible.IsEmpty() && !pending.IsEmpty())
+        {
+            virtualTime = std::max(virtualTime, pending.TopKey());
+        }
+
+        while (!pending.IsEmpty() && pending.TopKey() <= virtualTime)
+        {
+            uint32_t index = pending.Top();
+            pending.Erase(index);
+            eligible.Push(index, finishTime[index]);
+        }
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Returns the weight of a queue; a non-positive weight counts as 1.
+     */
+    double WF2Q::GetQueueWeight(uint32_t index) const
+    {
+        double weight = q_class[index]->GetWeight();
+        return weight > 0 ? weight : 1.0;
+    }
+
+    /**
+     * \ingroup diffserv
+     * \brief Getter for the system virtual time.
+     */
+    double WF2Q::GetVirtualTime() const
+    {
+        return virtualTime;
+    }
+} // namespace ns3
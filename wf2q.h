@@ -0,0 +1,99 @@
+#ifndef WF2Q_H
+#define WF2Q_H
+
+#include "diff-serv.h"
+#include "class-heap.h"
+#include <vector>
+
+namespace ns3 {
+    /**
+     * \ingroup diffserv
+     * \brief Worst-case Fair Weighted Fair Queuing (WF2Q+) scheduler extending DiffServ
+     *
+     * Every backlogged class carries the virtual start and finish time of its head-of-line packet.
+     * A class is eligible once its start time has been reached by the system virtual time, and the
+     * eligible class with the smallest finish time is served. Unlike DRR, this bounds the delay of
+     * a low-weight class to about one packet of its own, independent of the packet sizes of others.
+     *
+     * Weights are read from TrafficClass::GetWeight(), like DRR, so a config can switch between
+     * the two. Eligible classes sit in a min-heap by finish time and the others in a min-heap by
+     * start time, so a decision is O(1) and every update is O(log n).
+     */
+    class WF2Q : public DiffServ
+    {
+    public:
+        WF2Q();
+        ~WF2Q() override = default;
+
+        /**
+         * \brief Select the next packet to be dequeued based on WF2Q+.
+         * \returns Ptr<const Packet> packet at the front of the scheduled queue.
+         */
+        Ptr<const Packet> Schedule() const override;
+
+        /**
+         * \brief Select the eligible queue with the smallest virtual finish time.
+         * \returns The index of the scheduled queue, or NO_QUEUE if all queues are empty.
+         */
+        uint32_t ScheduleQueue() const override;
+
+        /**
+         * \brief Add a new TrafficClass to the WF2Q+ scheduler.
+         * \param trafficClass pointer to the TrafficClass instance.
+         */
+        void RegisterQueue(TrafficClass* trafficClass) override;
+
+        /**
+         * \brief Getter for the system virtual time.
+         */
+        double GetVirtualTime() const;
+
+    protected:
+        /**
+         * \brief Advance the virtual time by the served packet and move the queue to its next start time.
+         * \param index The queue returned by ScheduleQueue().
+         */
+        void CommitSchedule(uint32_t index) override;
+
+        /**
+         * \brief Tag a queue that became backlogged (or got a new head) and untag one that went idle.
+         * \param index The queue that changed.
+         */
+        void NotifyQueueChanged(uint32_t index) override;
+
+    private:
+        // Virtual start and finish time of the head-of-line packet of each queue
+        std::vector<double> startTime;
+        std::vector<double> finishTime;
+        std::vector<bool> isActive;
+
+        // Backlogged queues: eligible ones by finish time, the others by start time
+        ClassHeap eligible;
+        ClassHeap pending;
+
+        // System virtual time, and the sum of all weights it advances against
+        double virtualTime;
+        double totalWeight;
+
+        // Queue charged by CommitSchedule whose new head is tagged once it has been popped
+        uint32_t servedQueue;
+
+        /**
+         * \brief Get the weight of a queue (a non-positive weight counts as 1).
+         */
+        double GetQueueWeight(uint32_t index) const;
+
+        /**
+         * \brief Compute the finish time of a queue's head and file it as eligible or pending.
+         */
+        void Tag(uint32_t index);
+
+        /**
+         * \brief Raise the virtual time to the smallest start time if no queue is eligible,
+         * then move every queue whose start time has been reached to the eligible heap.
+         */
+        void UpdateVirtualTime();
+    };
+} // namespace ns3
+
+#endif // WF2Q_H